@@ -0,0 +1,354 @@
+/**
+ * \file batch.c
+ *
+ * \brief A source file for the batch runner, which works through a file of render jobs
+ * with a pool of threads.
+ *
+ * The runner is started with a job file and any of these settings:
+ *
+ *     drawsystem --jobs nightly.txt threads=8 budget=2048 report=nightly.csv
+ *
+ * Each line of the job file is one job, written with the same settings as --render
+ * (see headless.c), such as "preset=dragon depth=14 size=256x256 out=thumbs/dragon.bmp".
+ * Blank lines and anything after a # are ignored. threads is the number of threads
+ * (one for each processor if left out), budget is the memory budget in megabytes and
+ * report is the file the timings are written to.
+ *
+ * Before a job is started, the bytes it will need for its string, line list and image
+ * are worked out from the rules without making anything, and the job only starts once
+ * the jobs already running leave room for it in the budget. Jobs are started in the
+ * order they are in the file, so a large job is never held back forever by smaller ones
+ * behind it, and a job bigger than the whole budget is run on its own. Once every job
+ * has finished, a csv file is written with the time each job spent on each stage, the
+ * number of lines it drew, the bytes it was expected to need and the peak resident memory
+ * of the run when it finished. Jobs run side by side share the process, so the resident
+ * memory is not the job's own.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "seek.h"
+#include "encode.h"
+#include "headless.h"
+#include "poster.h"
+#include "sweep.h"
+#include "grow.h"
+#include "timing.h"
+#include "batch.h"
+
+
+/*
+ * Main loop of each thread in the pool.
+ */
+static int batchThread(void *data);
+
+
+int runBatch(int argc, char *argv[], trace_log *trace){
+	/**
+	 * \brief Runs every render job in a job file across a pool of threads and writes a timing report.
+	 *
+	 * \param[in] argc 		number of command line arguments.
+	 * \param[in] argv 		the command line arguments, starting with --jobs and the job file.
+	 * \param[out] trace 	trace log the stages of every job are recorded in, NULL when not tracing.
+	 *
+	 * \return 				0 if every image was saved, 1 if not.
+	 */
+
+	batch_runner batch;
+	SDL_Thread **threads = NULL;
+	char *report = BATCH_REPORT;
+	int thread_count = SDL_GetCPUCount();
+	int budget = BATCH_BUDGET_MB;
+	int failed = 0;
+	int i = 0;
+	Uint64 start_time = SDL_GetPerformanceCounter();
+
+	structInitBatchRunner(&batch);
+
+	//reading the settings
+	if (argc < 3){
+		printf("usage: drawsystem --jobs FILE [threads=N] [budget=MB] [report=FILE]\n");
+		return 1;
+	}
+	for (i = 3; i < argc; i++){
+		if (strncmp(argv[i], "threads=", 8) == 0 && atoi(argv[i]+8) > 0)
+			thread_count = atoi(argv[i]+8);
+		else if (strncmp(argv[i], "budget=", 7) == 0 && atoi(argv[i]+7) > 0)
+			budget = atoi(argv[i]+7);
+		else if (strncmp(argv[i], "report=", 7) == 0 && argv[i][7] != '\0')
+			report = argv[i]+7;
+		else{
+			printf("Unknown batch setting: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (!readJobFile(&batch, argv[2])){
+		free(batch.jobs);
+		return 1;
+	}
+	for (i = 0; i < batch.job_count; i++)
+		batch.jobs[i].lsys.trace = trace;
+
+	if (thread_count > batch.job_count)
+		thread_count = batch.job_count;
+	batch.budget = (size_t)budget*1024*1024;
+	printf("%d jobs on %d threads with a %d MB budget\n", batch.job_count, thread_count, budget);
+
+	//starting the pool and waiting for it to work through the jobs
+	batch.lock = SDL_CreateMutex();
+	batch.memory_free = SDL_CreateCond();
+	threads = (SDL_Thread**)calloc(thread_count, sizeof(SDL_Thread*));
+	if (batch.lock == NULL || batch.memory_free == NULL || threads == NULL){
+		printf("Could not set up the batch runner: %s\n", SDL_GetError());
+		failed = 1;
+		thread_count = 0;
+	}
+
+	for (i = 0; i < thread_count; i++){
+		threads[i] = SDL_CreateThread(batchThread, "batch", &batch);
+		if (threads[i] == NULL)
+			printf("Could not start batch thread: %s\n", SDL_GetError());
+	}
+
+	//running the jobs on this thread if no pool thread could be started
+	for (i = 0; i < thread_count && threads[i] == NULL; i++);
+	if (i == thread_count && batch.lock != NULL)
+		batchThread(&batch);
+
+	for (i = 0; i < thread_count; i++){
+		if (threads[i] != NULL)
+			SDL_WaitThread(threads[i], NULL);
+	}
+
+	for (i = 0; i < batch.job_count; i++){
+		if (!batch.jobs[i].saved)
+			failed = 1;
+	}
+
+	if (!writeBatchReport(&batch, report))
+		failed = 1;
+
+	printf("batch finished in %.3f s, peak RSS %ld KB, report in %s\n",
+		secondsSince(start_time), peakMemory(), report);
+
+	free(threads);
+	free(batch.jobs);
+	SDL_DestroyCond(batch.memory_free);
+	SDL_DestroyMutex(batch.lock);
+	return failed;
+}
+
+int readJobFile(batch_runner *batch, char *name){
+	/**
+	 * \brief Reads the render jobs from a job file.
+	 *
+	 * Every job is checked as it is read, and the bytes it is expected to need are worked out,
+	 * so that a mistake anywhere in the file is reported before any job is run.
+	 *
+	 * \param[out] batch 	the runner the jobs are added to, whose jobs must be freed even if reading fails.
+	 * \param[in] name 		file name of the job file.
+	 *
+	 * \return 				1 if every line was read, 0 if the file could not be read or has a mistake.
+	 */
+
+	FILE *file = fopen(name, "r");
+	char text[BATCH_LINE_LENGTH];
+	char *word = NULL;
+	render_job *grown = NULL;
+	int capacity = 0;
+	int line_number = 0;
+
+	if (file == NULL){
+		printf("Could not open job file %s\n", name);
+		return 0;
+	}
+
+	while (fgets(text, sizeof(text), file) != NULL){
+		line_number++;
+
+		//ignoring comments and blank lines
+		if (strchr(text, '#') != NULL)
+			*strchr(text, '#') = '\0';
+		word = strtok(text, " \t\r\n");
+		if (word == NULL)
+			continue;
+
+		//making room for another job
+		if (batch->job_count == capacity){
+			capacity = capacity ? 2*capacity : 64;
+			grown = (render_job*)realloc(batch->jobs, capacity*sizeof(render_job));
+			if (grown == NULL){
+				printf("render job memory allocation failed\n");
+				fclose(file);
+				return 0;
+			}
+			batch->jobs = grown;
+		}
+
+		structInitRenderJob(&(batch->jobs[batch->job_count]));
+		for (; word != NULL; word = strtok(NULL, " \t\r\n")){
+			if (!parseRenderSetting(&(batch->jobs[batch->job_count]), word)){
+				printf("%s:%d: unknown render setting %s\n", name, line_number, word);
+				fclose(file);
+				return 0;
+			}
+		}
+		if (!finishRenderJob(&(batch->jobs[batch->job_count]))){
+			printf("%s:%d: job could not be read\n", name, line_number);
+			fclose(file);
+			return 0;
+		}
+
+		batch->jobs[batch->job_count].expected_bytes = estimateJobBytes(&(batch->jobs[batch->job_count]));
+		batch->job_count++;
+	}
+
+	fclose(file);
+
+	if (batch->job_count == 0){
+		printf("No jobs in %s\n", name);
+		return 0;
+	}
+
+	return 1;
+}
+
+size_t estimateJobBytes(render_job *job){
+	/**
+	 * \brief Returns the number of bytes a render job is expected to need at its peak.
+	 *
+	 * The string length comes from stringLength() and the number of lines from a seek table, so
+	 * nothing is made. The peak is the largest of the last rewrite (the old and new strings are
+	 * both held), making the line list (the string and line list are held) and drawing (the line
+	 * list and image are held). An svg needs no image, a poster only holds one row of tiles and
+	 * its bins, a density image also holds its counts and anti-aliased lines hold a coverage level
+	 * for each pixel. A sweep holds the images of its reorder buffer, and for an angle sweep, a
+	 * line list for each thread. A growth video holds three images, and the string while its
+	 * line list is drawn.
+	 *
+	 * \param[in] job 		the job.
+	 *
+	 * \return 				the expected peak in bytes.
+	 */
+
+	seek_table table;
+	double segments = 0;
+	double string_bytes = stringLength(&(job->lsys), job->lsys.iterations) + 1;
+	double previous_bytes = stringLength(&(job->lsys), job->lsys.iterations-1) + 1;
+	double line_bytes = 0;
+	double image_bytes = 0;
+	double peak = 0;
+
+	structInitSeekTable(&table);
+	if (makeSeekTable(&(job->lsys), &table)){
+		segments = totalSegments(&(job->lsys), &table);
+		freeSeekTable(&table);
+	}
+	else
+		segments = string_bytes;
+	line_bytes = segments*sizeof(line);
+	if (job->sweep)
+		image_bytes = sweepBytes(job, segments);
+	else if (job->grow)
+		image_bytes = growthBytes(job) + string_bytes;
+	else if (posterRequested(job))
+		image_bytes = posterBytes(job, segments);
+	else if (job->image_format != IMAGE_SVG || job->video_format)
+		image_bytes = (job->density ? 2.0 : 1.0)*job->width*job->height*sizeof(Uint32) + (job->antialias ? (double)job->width*job->height : 0);
+
+	peak = previous_bytes + string_bytes;
+	if (string_bytes + line_bytes > peak)
+		peak = string_bytes + line_bytes;
+	if (line_bytes + image_bytes > peak)
+		peak = line_bytes + image_bytes;
+
+	return peak < (double)((size_t)-1) ? (size_t)peak : (size_t)-1;
+}
+
+int writeBatchReport(batch_runner *batch, char *name){
+	/**
+	 * \brief Writes the stage timings, line counts and memory use of every job to a csv file.
+	 *
+	 * Jobs are written in the order they are in the job file, one row each, with times in
+	 * seconds.
+	 *
+	 * \param[in] batch 	the runner once every job has finished.
+	 * \param[in] name 		file name for the report.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	FILE *file = fopen(name, "w");
+	render_job *job = NULL;
+	int i = 0;
+
+	if (file == NULL){
+		printf("Could not write report %s\n", name);
+		return 0;
+	}
+
+	fprintf(file, "out,label,depth,angle,width,height,segments,rewrite_s,turtle_s,raster_s,encode_s,total_s,expected_bytes,peak_rss_kb,stored,saved\n");
+	for (i = 0; i < batch->job_count; i++){
+		job = &(batch->jobs[i]);
+		fprintf(file, "%s,%s,%d,%g,%d,%d,%lld,%.6f,%.6f,%.6f,%.6f,%.6f,%lu,%ld,%d,%d\n", job->out, job->label, job->lsys.iterations,
+			rtod(job->lsys.angle), job->width, job->height, job->segments, job->rewrite_time, job->turtle_time, job->raster_time,
+			job->encode_time, job->rewrite_time + job->turtle_time + job->raster_time + job->encode_time,
+			(unsigned long)job->expected_bytes, job->peak_rss, job->from_store, job->saved);
+	}
+
+	if (fclose(file) != 0){
+		printf("Could not write report %s\n", name);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int batchThread(void *data){
+	/**
+	 * \brief Takes jobs in order and runs them, waiting for room in the memory budget before each one.
+	 *
+	 * \param[in] data 		the batch_runner that owns the thread.
+	 *
+	 * \return 				0 when there are no jobs left.
+	 */
+
+	batch_runner *batch = (batch_runner*)data;
+	render_job *job = NULL;
+
+	while (1){
+		//waiting until the next job fits alongside the ones running, or nothing else is running
+		SDL_LockMutex(batch->lock);
+		while (batch->next_job < batch->job_count && batch->reserved > 0
+			&& batch->reserved + batch->jobs[batch->next_job].expected_bytes > batch->budget)
+			SDL_CondWait(batch->memory_free, batch->lock);
+
+		if (batch->next_job >= batch->job_count){
+			SDL_UnlockMutex(batch->lock);
+			break;
+		}
+
+		job = &(batch->jobs[batch->next_job++]);
+		batch->reserved += job->expected_bytes;
+		SDL_UnlockMutex(batch->lock);
+
+		renderJob(job);
+		job->peak_rss = peakMemory();
+
+		//giving back the memory and waking any thread waiting for it
+		SDL_LockMutex(batch->lock);
+		batch->reserved -= job->expected_bytes;
+		printRenderJob(job);
+		SDL_CondBroadcast(batch->memory_free);
+		SDL_UnlockMutex(batch->lock);
+	}
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+/** \brief Default memory budget for the jobs running at once, in megabytes.*/
+#define BATCH_BUDGET_MB 1024
+/** \brief Default file name for the timing report.*/
+#define BATCH_REPORT "batch_report.csv"
+/** \brief Longest line that can be read from a job file.*/
+#define BATCH_LINE_LENGTH 1024
+
+
+/*
+ * Runs every render job in a job file across a pool of threads and writes a timing report.
+ */
+int runBatch(int argc, char *argv[], trace_log *trace);
+
+/*
+ * Reads the render jobs from a job file.
+ */
+int readJobFile(batch_runner *batch, char *name);
+
+/*
+ * Returns the number of bytes a render job is expected to need at its peak.
+ */
+size_t estimateJobBytes(render_job *job);
+
+/*
+ * Writes the stage timings, line counts and memory use of every job to a csv file.
+ */
+int writeBatchReport(batch_runner *batch, char *name);
+
+#endif
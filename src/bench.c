@@ -0,0 +1,321 @@
+/**
+ * \file bench.c
+ *
+ * \brief A source file for the benchmark suite, a program of its own built with "make bench"
+ * that times each stage of making and drawing every pre defined rule set, so that changes in
+ * speed can be tracked from one release to the next.
+ *
+ * The suite is started with any of these settings:
+ *
+ *     ./bench repetitions=21 warmup=3 depths=2 size=2000x1600 out=bench.json
+ *
+ * Every rule set in lsys.c is timed at depths depths (BENCH_DEPTHS if left out), counting
+ * down from its iteration limit. At each depth, makeString(), countMoves(), stringToTurtle()
+ * and rasterFractal() with aliased and with anti-aliased lines are each run warmup times
+ * without being timed, then repetitions times with each run timed on its own. The lines are
+ * made and drawn the same way as by the headless renderer, with a line length of 1 and
+ * fitted to an image of the given size (1000x800 if left out).
+ *
+ * The median and 95th percentile of each stage's times, with the shortest time, the length
+ * of the string and the number of lines, are written to out as JSON, and the medians are
+ * printed as each depth finishes. Neither the video subsystem nor SDL_ttf is initialised.
+ *
+ * At each depth the middle third of the line list is also made again with rangeToTurtle()
+ * and checked against the lines made by stringToTurtle(), and the suite fails if they differ.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "seek.h"
+#include "raster.h"
+#include "headless.h"
+#include "timing.h"
+#include "bench.h"
+
+
+/** \brief Names of the timed stages, in the order they are run and reported.*/
+static char *stage_names[BENCH_STAGES] = {"makeString", "countMoves", "stringToTurtle", "rasterFractal", "rasterFractalAA"};
+
+
+/*
+ * Runs one stage once and returns the number of seconds it took.
+ */
+static double runStage(lsystem *lsys, int stage, raster_image *image, int *moves);
+
+/*
+ * Compares two times for qsort().
+ */
+static int compareTimes(const void *a, const void *b);
+
+
+int main(int argc, char *argv[]){
+    /**
+     * \brief Times every stage for every rule set at several depths and writes the results to a JSON report.
+     *
+     * \param[in] argc     number of command line arguments.
+     * \param[in] argv     the command line arguments, each one a setting.
+     *
+     * \return   0 if every stage was timed and the report written, 1 if not.
+     */
+
+    bench_settings bench;
+    FILE *report = NULL;
+    lsystem lsys;
+    int failed = 0;
+    int first = 1;
+    int depth = 0;
+    int i = 0;
+    int j = 0;
+
+    structInitBenchSettings(&bench);
+    bench.repetitions = BENCH_REPETITIONS;
+    bench.warmup = BENCH_WARMUP;
+    bench.depths = BENCH_DEPTHS;
+    bench.width = 1000;
+    bench.height = 800;
+    bench.out = BENCH_REPORT;
+
+    //reading the settings
+    for (i = 1; i < argc; i++){
+        if (strncmp(argv[i], "repetitions=", 12) == 0 && atoi(argv[i]+12) > 0 && atoi(argv[i]+12) <= BENCH_MAX_REPETITIONS)
+            bench.repetitions = atoi(argv[i]+12);
+        else if (strncmp(argv[i], "warmup=", 7) == 0 && atoi(argv[i]+7) >= 0)
+            bench.warmup = atoi(argv[i]+7);
+        else if (strncmp(argv[i], "depths=", 7) == 0 && atoi(argv[i]+7) > 0)
+            bench.depths = atoi(argv[i]+7);
+        else if (strncmp(argv[i], "size=", 5) == 0 && sscanf(argv[i]+5, "%dx%d", &(bench.width), &(bench.height)) == 2 && bench.width > 0 && bench.height > 0)
+            continue;
+        else if (strncmp(argv[i], "out=", 4) == 0 && argv[i][4] != '\0')
+            bench.out = argv[i]+4;
+        else{
+            printf("Unknown bench setting: %s\n", argv[i]);
+            printf("usage: bench [repetitions=N] [warmup=N] [depths=N] [size=WxH] [out=FILE]\n");
+            return 1;
+        }
+    }
+
+    report = fopen(bench.out, "w");
+    if (report == NULL){
+        printf("Could not open %s to write the report\n", bench.out);
+        return 1;
+    }
+
+    fprintf(report, "{\"repetitions\":%d,\"warmup\":%d,\"width\":%d,\"height\":%d,\"results\":[", bench.repetitions, bench.warmup, bench.width, bench.height);
+    for (i = 0; i < PRESET_COUNT; i++){
+        structInitLsystem(&lsys);
+        loadPreset(&lsys, i);
+
+        for (j = bench.depths-1; j >= 0; j--){
+            depth = lsys.iteration_limit - j;
+            if (depth < 0)
+                continue;
+
+            fprintf(report, "%s\n", first ? "" : ",");
+            first = 0;
+            if (!benchPreset(&bench, report, i, depth))
+                failed = 1;
+        }
+    }
+    fprintf(report, "\n]}\n");
+
+    if (fclose(report) != 0){
+        printf("Could not write the report to %s\n", bench.out);
+        failed = 1;
+    }
+    else
+        printf("report in %s\n", bench.out);
+
+    return failed;
+}
+
+int benchPreset(bench_settings *bench, FILE *report, int preset, int depth){
+    /**
+     * \brief Times every stage for one rule set at one depth and writes the results to the report.
+     *
+     * Each stage works on what the stage before it made, so the string is made before the moves
+     * are counted and the line list is made before it is drawn. The results are written as one
+     * JSON object, without a comma before or after it.
+     *
+     * \param[in] bench 	the settings.
+     * \param[out] report 	file the JSON report is being written to.
+     * \param[in] preset 	position of the rule set, from 0 to PRESET_COUNT-1.
+     * \param[in] depth 	fractal depth to time the rule set at.
+     *
+     * \return 				1 if every stage was timed and the seek check passed, 0 if not.
+     */
+
+    lsystem lsys;
+    raster_image image;
+    seek_table table;
+    double *times = NULL;
+    double medians[BENCH_STAGES];
+    double p95 = 0;
+    double seconds = 0;
+    int moves = 0;
+    int timed = 1;
+    int matches = 0;
+    int stage = 0;
+    int run = 0;
+
+    structInitLsystem(&lsys);
+    structInitRasterImage(&image);
+    structInitSeekTable(&table);
+    loadPreset(&lsys, preset);
+    lsys.iterations = depth;
+    lsys.length = 1;
+    structInitCoord(&(lsys.start));
+
+    times = (double*)calloc(bench->repetitions, sizeof(double));
+    if (times == NULL || !initRaster(&image, bench->width, bench->height)){
+        printf("bench memory allocation failed\n");
+        timed = 0;
+    }
+
+    fprintf(report, "{\"preset\":\"%s\",\"depth\":%d,\"stages\":{", presetKey(preset), depth);
+    for (stage = 0; timed && stage < BENCH_STAGES; stage++){
+        for (run = 0; timed && run < bench->warmup + bench->repetitions; run++){
+            seconds = runStage(&lsys, stage, &image, &moves);
+            if (seconds < 0)
+                timed = 0;
+            else if (run >= bench->warmup)
+                times[run - bench->warmup] = 1000*seconds;
+        }
+        if (!timed)
+            break;
+
+        summariseTimes(times, bench->repetitions, &(medians[stage]), &p95);
+        fprintf(report, "%s\"%s\":{\"median_ms\":%.6f,\"p95_ms\":%.6f,\"min_ms\":%.6f}", stage > 0 ? "," : "", stage_names[stage], medians[stage], p95, times[0]);
+    }
+
+    //checking the middle third of the line list made again by seeking against the turtle's
+    if (timed && makeSeekTable(&lsys, &table))
+        matches = checkRange(&lsys, &table, lsys.line_list_length/3, 2*(long long)lsys.line_list_length/3);
+    freeSeekTable(&table);
+
+    fprintf(report, "},\"string_length\":%lu,\"lines\":%d,\"complete\":%s,\"seek_matches\":%s}", lsys.string == NULL ? 0 : (unsigned long)strlen(lsys.string), lsys.line_list_length, timed ? "true" : "false", matches ? "true" : "false");
+
+    if (timed){
+        printf("%s depth %d, %d lines:", presetKey(preset), depth, lsys.line_list_length);
+        for (stage = 0; stage < BENCH_STAGES; stage++)
+            printf(" %s %.3f ms%s", stage_names[stage], medians[stage], stage < BENCH_STAGES-1 ? "," : "\n");
+    }
+    else
+        printf("%s depth %d: could not time every stage\n", presetKey(preset), depth);
+    if (timed && !matches)
+        printf("%s depth %d: lines made by rangeToTurtle() do not match stringToTurtle()\n", presetKey(preset), depth);
+
+    free(times);
+    free(lsys.string);
+    free(lsys.line_list);
+    freeRaster(&image);
+
+    return timed && matches;
+}
+
+void summariseTimes(double *times, int count, double *median, double *p95){
+    /**
+     * \brief Sorts a list of times and finds its median and 95th percentile.
+     *
+     * The 95th percentile is the time that 95% of the times are at or below, taken by
+     * nearest rank, so with fewer than 20 times it is the longest one.
+     *
+     * \param[out] times 	the times, which are sorted from shortest to longest.
+     * \param[in] count 	number of times, at least 1.
+     * \param[out] median 	the median time.
+     * \param[out] p95 		the 95th percentile.
+     */
+
+    int rank = (95*count + 99)/100;
+
+    qsort(times, count, sizeof(double), compareTimes);
+
+    if (count % 2)
+        *median = times[count/2];
+    else
+        *median = (times[count/2 - 1] + times[count/2])/2;
+    *p95 = times[rank > 0 ? rank-1 : 0];
+}
+
+static double runStage(lsystem *lsys, int stage, raster_image *image, int *moves){
+    /**
+     * \brief Runs one stage once and returns the number of seconds it took.
+     *
+     * The string or line list left by the last run of the stage is freed before the stage is
+     * timed, so each run makes them from nothing and the last run leaves them for the next
+     * stage.
+     *
+     * \param[out] lsys 	the lsystem, set to the depth being timed.
+     * \param[in] stage 	position of the stage, from 0 to BENCH_STAGES-1.
+     * \param[out] image 	the image the lines are drawn into.
+     * \param[out] moves 	given the number of movement characters when the moves are counted.
+     *
+     * \return 				the number of seconds, or -1 if memory allocation failed.
+     */
+
+    double scale = 1;
+    coordinate offset;
+    SDL_Colour bg_colour = {255, 255, 255, 255};
+    SDL_Colour ln_colour = {0, 0, 0, 255};
+    Uint64 start_time = 0;
+
+    structInitCoord(&offset);
+
+    if (stage == 0){
+        free(lsys->string);
+        lsys->string = NULL;
+    }
+    else if (stage == 2){
+        free(lsys->line_list);
+        lsys->line_list = NULL;
+    }
+
+    start_time = SDL_GetPerformanceCounter();
+    switch (stage){
+        //making the string from the axiom
+        case 0:
+            if (!makeString(lsys))
+                return -1;
+            break;
+        //counting the movement characters in the string
+        case 1:
+            *moves = countMoves(lsys->string);
+            break;
+        //running the turtle over the string
+        case 2:
+            lsys->line_list_length = stringToTurtle(lsys);
+            if (lsys->line_list == NULL && *moves > 0)
+                return -1;
+            break;
+        //fitting the lines to the image and drawing them, anti-aliased for the last stage
+        default:
+            fitLines(lsys->line_list, lsys->line_list_length, image->width, image->height, RENDER_MARGIN, &scale, &offset);
+            clearRaster(image, bg_colour);
+            rasterFractal(image, lsys->line_list, lsys->line_list_length, scale, offset, ln_colour, stage == 4);
+            break;
+    }
+
+    return secondsSince(start_time);
+}
+
+static int compareTimes(const void *a, const void *b){
+    /**
+     * \brief Compares two times for qsort().
+     *
+     * \param[in] a 	pointer to the first time.
+     * \param[in] b 	pointer to the second time.
+     *
+     * \return 			-1 if the first is shorter, 1 if it is longer and 0 if they are the same.
+     */
+
+    double first = *(const double*)a;
+    double second = *(const double*)b;
+
+    return (first > second) - (first < second);
+}
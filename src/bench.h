@@ -0,0 +1,28 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/** \brief Number of timed runs of each stage if none is given.*/
+#define BENCH_REPETITIONS 11
+/** \brief Largest number of timed runs of each stage.*/
+#define BENCH_MAX_REPETITIONS 1000
+/** \brief Number of untimed runs of each stage if none is given.*/
+#define BENCH_WARMUP 2
+/** \brief Number of depths each rule set is timed at if none is given.*/
+#define BENCH_DEPTHS 3
+/** \brief File name the JSON report is written to if none is given.*/
+#define BENCH_REPORT "bench.json"
+/** \brief Number of stages timed for each rule set and depth.*/
+#define BENCH_STAGES 5
+
+
+/*
+ * Times every stage for one rule set at one depth and writes the results to the report.
+ */
+int benchPreset(bench_settings *bench, FILE *report, int preset, int depth);
+
+/*
+ * Sorts a list of times and finds its median and 95th percentile.
+ */
+void summariseTimes(double *times, int count, double *median, double *p95);
+
+#endif
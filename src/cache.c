@@ -0,0 +1,552 @@
+/**
+ * \file cache.c
+ *
+ * \brief A source file for the geometry cache, which holds finished strings and line
+ * lists so that they can be drawn again without being remade.
+ *
+ * Entries are found by a hash of everything that changes the shape of the fractal: the
+ * axiom, the rules, the angle and the fractal depth. Line lists are stored as made with
+ * a line length of 1 from (0, 0), so one entry serves every line length and start point
+ * and is scaled into place by placeLines() when it is used. Colours and names are not
+ * part of the key as they do not change the geometry.
+ *
+ * The cache has a memory budget counted in bytes. Entries are kept in order of use as
+ * well as in a hash table, and the least recently used are freed to make room for new
+ * ones. As the cache is filled from background threads, every function takes the lock.
+ * A lookup only holds the lock while it finds its entry and counts itself as a user of
+ * it, and copies out of the entry without the lock, so the speculative scheduler is not
+ * kept waiting while a large fractal is copied. An entry taken out of the cache while it
+ * has users is only freed once the last of them is done with it.
+ *
+ * When an lsystem is not held, the geometry store is checked for a file holding it
+ * before it counts as a miss. The file is opened and mapped without the cache lock, so
+ * a lookup on the drawing screen never waits for another thread's disk access. Entries
+ * for stored files point straight into the mapped file instead of holding their own copy,
+ * and the size of the mapping is counted against the budget, so they are freed in order of
+ * use like any other entry. Loads are copy-on-use: a lookup copies the lines out of the
+ * mapping as placeLines() scales them into place, which it has to do for held lines too. A
+ * file bigger than the whole budget is not added, and is closed once its lookup is done.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "turtle.h"
+#include "store.h"
+#include "cache.h"
+
+
+/*
+ * Returns true if two lsystems have the same axiom, rules, angle and depth.
+ */
+static int sameGeometry(lsystem *a, lsystem *b);
+
+/*
+ * Finds the entry for an lsystem, the cache lock must be held.
+ */
+static geom_entry *findEntry(geom_cache *cache, lsystem *lsys, unsigned long long hash);
+
+/*
+ * Finds the entry for an lsystem, mapping in its stored geometry file if it is not held, the cache lock must be held and is let go while mapping.
+ */
+static geom_entry *findOrLoadEntry(geom_cache *cache, lsystem *lsys, unsigned long long hash);
+
+/*
+ * Adds an entry to the cache, freeing the least recently used to make room, the cache lock must be held.
+ */
+static void addEntry(geom_cache *cache, geom_entry *entry);
+
+/*
+ * Takes an entry out of the order of use, the cache lock must be held.
+ */
+static void unlinkEntry(geom_cache *cache, geom_entry *entry);
+
+/*
+ * Puts an entry at the front of the order of use, the cache lock must be held.
+ */
+static void linkNewest(geom_cache *cache, geom_entry *entry);
+
+/*
+ * Takes an entry out of the cache and frees it, or leaves it for its last user to free, the cache lock must be held.
+ */
+static void removeEntry(geom_cache *cache, geom_entry *entry);
+
+/*
+ * Stops counting a lookup as a user of an entry, freeing the entry if it was removed while in use, the cache lock must be held.
+ */
+static void releaseEntry(geom_entry *entry);
+
+/*
+ * Frees an entry and the geometry it holds or maps.
+ */
+static void freeEntry(geom_entry *entry);
+
+/*
+ * Mixes a block of bytes into a hash.
+ */
+static unsigned long long hashBytes(unsigned long long hash, const void *data, size_t size);
+
+
+int initCache(geom_cache *cache, size_t budget){
+	/**
+	 * \brief Sets up the lock and memory budget of a cache.
+	 *
+	 * \param[out] cache 	a cache initialised with structInitGeomCache().
+	 * \param[in] budget 	maximum number of bytes the entries may hold.
+	 *
+	 * \return 				1 if sucessfull, 0 if the lock could not be created.
+	 */
+
+	cache->lock = SDL_CreateMutex();
+	if (cache->lock == NULL){
+		printf("Could not create cache lock: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	cache->budget = budget;
+	return 1;
+}
+
+void freeCache(geom_cache *cache){
+	/**
+	 * \brief Frees every entry in the cache and its lock.
+	 *
+	 * \param[out] cache 	the cache to be freed.
+	 */
+
+	while (cache->oldest != NULL)
+		removeEntry(cache, cache->oldest);
+
+	SDL_DestroyMutex(cache->lock);
+	cache->lock = NULL;
+}
+
+unsigned long long hashLsystem(lsystem *lsys){
+	/**
+	 * \brief Makes a 64 bit FNV-1a hash of the axiom, rules, angle and depth of an lsystem.
+	 *
+	 * Each string is hashed with its terminating null so that moving characters from one
+	 * rule to the next changes the hash.
+	 *
+	 * \param[in] lsys 		the lsystem to be hashed.
+	 *
+	 * \return 				the hash.
+	 */
+
+	unsigned long long hash = 14695981039346656037ULL;
+
+	hash = hashBytes(hash, lsys->axiom, strlen(lsys->axiom)+1);
+	hash = hashBytes(hash, lsys->rule_A, strlen(lsys->rule_A)+1);
+	hash = hashBytes(hash, lsys->rule_B, strlen(lsys->rule_B)+1);
+	hash = hashBytes(hash, lsys->rule_F, strlen(lsys->rule_F)+1);
+	hash = hashBytes(hash, lsys->rule_f, strlen(lsys->rule_f)+1);
+	hash = hashBytes(hash, lsys->rule_X, strlen(lsys->rule_X)+1);
+	hash = hashBytes(hash, lsys->rule_Y, strlen(lsys->rule_Y)+1);
+	hash = hashBytes(hash, lsys->rule_plus, strlen(lsys->rule_plus)+1);
+	hash = hashBytes(hash, lsys->rule_minus, strlen(lsys->rule_minus)+1);
+	hash = hashBytes(hash, lsys->rule_store, strlen(lsys->rule_store)+1);
+	hash = hashBytes(hash, lsys->rule_pop, strlen(lsys->rule_pop)+1);
+	hash = hashBytes(hash, &(lsys->angle), sizeof(lsys->angle));
+	hash = hashBytes(hash, &(lsys->iterations), sizeof(lsys->iterations));
+
+	return hash;
+}
+
+int cacheLookup(geom_cache *cache, lsystem *lsys, int need_string){
+	/**
+	 * \brief Copies the string and line list for the lsystem out of the cache if they are held.
+	 *
+	 * The lsystem is given a line list scaled to its line length and moved to its start point,
+	 * and its own copy of the string if it needs one, so the entry can be freed at any time.
+	 * When only the line length or start point has changed the string held is already right,
+	 * so it is not copied again. The string and line list being replaced are freed. The copying
+	 * is done without the cache lock. The entry becomes the most recently used and every lookup
+	 * is counted as a hit or a miss.
+	 *
+	 * \param[out] cache 		the cache to look in.
+	 * \param[out] lsys 		the lsystem to be filled.
+	 * \param[in] need_string 	true if the lsystem's string is missing or out of date and must be copied too.
+	 *
+	 * \return 					1 if the geometry was found and copied, 0 if not.
+	 */
+
+	geom_entry *entry = NULL;
+	char *string = NULL;
+	int found = 0;
+
+	//finding the entry and counting this lookup as a user so it is not freed while being copied
+	SDL_LockMutex(cache->lock);
+	entry = findOrLoadEntry(cache, lsys, hashLsystem(lsys));
+	if (entry != NULL)
+		entry->users++;
+	SDL_UnlockMutex(cache->lock);
+
+	//copying the string and placing the lines so that the lsystem owns what it is given
+	if (entry != NULL){
+		if (need_string){
+			string = (char*)malloc(strlen(entry->string)+1);
+			if (string != NULL)
+				strcpy(string, entry->string);
+		}
+		if ((string != NULL || !need_string) && placeLines(lsys, entry->line_list, entry->line_list_length)){
+			if (need_string){
+				free(lsys->string);
+				lsys->string = string;
+			}
+			found = 1;
+		}
+		else
+			free(string);
+	}
+
+	SDL_LockMutex(cache->lock);
+	if (found && !entry->removed){
+		unlinkEntry(cache, entry);
+		linkNewest(cache, entry);
+	}
+	if (entry != NULL)
+		releaseEntry(entry);
+	if (found)
+		cache->hits++;
+	else
+		cache->misses++;
+	SDL_UnlockMutex(cache->lock);
+
+	return found;
+}
+
+int cacheContains(geom_cache *cache, lsystem *lsys){
+	/**
+	 * \brief Returns true if the cache holds the string and line list for the lsystem.
+	 *
+	 * Unlike cacheLookup() nothing is copied, counted or moved in the order of use, although
+	 * a stored geometry file for the lsystem is mapped in if it is found, and kept if it fits.
+	 *
+	 * \param[in] cache 	the cache to look in.
+	 * \param[in] lsys 		the lsystem to look for.
+	 */
+
+	geom_entry *entry = NULL;
+	int found = 0;
+	unsigned long long hash = hashLsystem(lsys);
+
+	SDL_LockMutex(cache->lock);
+	entry = findOrLoadEntry(cache, lsys, hash);
+	found = entry != NULL;
+	if (found && entry->removed && entry->users == 0)
+		freeEntry(entry);
+	SDL_UnlockMutex(cache->lock);
+
+	return found;
+}
+
+int cacheInsert(geom_cache *cache, lsystem *key, char *string, line *line_list, int line_list_length){
+	/**
+	 * \brief Hands a finished string and line list to the cache.
+	 *
+	 * The least recently used entries are freed until the new one fits in the budget. Geometry
+	 * that is bigger than the whole budget, or that is already held, is not taken.
+	 *
+	 * \param[out] cache 			the cache to add to.
+	 * \param[in] key 				the lsystem the geometry was made from.
+	 * \param[in] string 			the string, owned by the cache if it is taken.
+	 * \param[in] line_list 		the line list made with a line length of 1 from (0, 0), owned by the cache if it is taken.
+	 * \param[in] line_list_length 	the number of lines in the line list.
+	 *
+	 * \return 						1 if the cache took the geometry, 0 if the caller still owns it.
+	 */
+
+	size_t bytes = sizeof(geom_entry) + strlen(string) + 1 + line_list_length*sizeof(line);
+	unsigned long long hash = hashLsystem(key);
+	geom_entry *entry = NULL;
+
+	if (bytes > cache->budget)
+		return 0;
+
+	entry = (geom_entry*)malloc(sizeof(geom_entry));
+	if (entry == NULL)
+		return 0;
+
+	entry->hash = hash;
+	entry->key = *key;
+	entry->key.string = NULL;
+	entry->key.line_list = NULL;
+	entry->key.cancel_flag = NULL;
+	entry->key.progress = NULL;
+	entry->string = string;
+	entry->line_list = line_list;
+	entry->line_list_length = line_list_length;
+	entry->bytes = bytes;
+	entry->mapping = NULL;
+	entry->mapping_size = 0;
+	entry->users = 0;
+	entry->removed = 0;
+
+	SDL_LockMutex(cache->lock);
+
+	if (findEntry(cache, key, hash) != NULL){
+		SDL_UnlockMutex(cache->lock);
+		free(entry);
+		return 0;
+	}
+
+	addEntry(cache, entry);
+
+	SDL_UnlockMutex(cache->lock);
+	return 1;
+}
+
+static int sameGeometry(lsystem *a, lsystem *b){
+	/**
+	 * \brief Returns true if two lsystems have the same axiom, rules, angle and depth.
+	 *
+	 * Used to check that an entry with a matching hash really is the same lsystem.
+	 *
+	 * \param[in] a 	the first lsystem.
+	 * \param[in] b 	the second lsystem.
+	 */
+
+	return a->iterations == b->iterations
+		&& a->angle == b->angle
+		&& strcmp(a->axiom, b->axiom) == 0
+		&& strcmp(a->rule_A, b->rule_A) == 0
+		&& strcmp(a->rule_B, b->rule_B) == 0
+		&& strcmp(a->rule_F, b->rule_F) == 0
+		&& strcmp(a->rule_f, b->rule_f) == 0
+		&& strcmp(a->rule_X, b->rule_X) == 0
+		&& strcmp(a->rule_Y, b->rule_Y) == 0
+		&& strcmp(a->rule_plus, b->rule_plus) == 0
+		&& strcmp(a->rule_minus, b->rule_minus) == 0
+		&& strcmp(a->rule_store, b->rule_store) == 0
+		&& strcmp(a->rule_pop, b->rule_pop) == 0;
+}
+
+static geom_entry *findEntry(geom_cache *cache, lsystem *lsys, unsigned long long hash){
+	/**
+	 * \brief Finds the entry for an lsystem, the cache lock must be held.
+	 *
+	 * \param[in] cache 	the cache to look in.
+	 * \param[in] lsys 		the lsystem to look for.
+	 * \param[in] hash 		hash of the lsystem from hashLsystem().
+	 *
+	 * \return 				the entry, or NULL if there is none.
+	 */
+
+	geom_entry *entry = NULL;
+
+	for (entry = cache->buckets[hash % CACHE_BUCKETS]; entry != NULL; entry = entry->chain){
+		if (entry->hash == hash && sameGeometry(&(entry->key), lsys))
+			return entry;
+	}
+
+	return NULL;
+}
+
+static geom_entry *findOrLoadEntry(geom_cache *cache, lsystem *lsys, unsigned long long hash){
+	/**
+	 * \brief Finds the entry for an lsystem, mapping in its stored geometry file if it is not held.
+	 *
+	 * The cache lock must be held. It is let go while the file is opened, mapped and its header
+	 * checked, so other threads can use the cache in the meantime, and taken again to add the
+	 * entry. If another thread added the same lsystem in the meantime, that entry is used and
+	 * the new mapping is closed. The entry is counted as the size of its mapping, and one bigger
+	 * than the whole budget is returned without being added, already marked as removed, for the
+	 * caller to free when done with it.
+	 *
+	 * \param[out] cache 	the cache to look in.
+	 * \param[in] lsys 		the lsystem to look for.
+	 * \param[in] hash 		hash of the lsystem from hashLsystem().
+	 *
+	 * \return 				the entry, or NULL if it is neither held nor stored.
+	 */
+
+	geom_entry *entry = findEntry(cache, lsys, hash);
+	geom_entry *found = NULL;
+	int opened = 0;
+
+	if (entry != NULL)
+		return entry;
+
+	entry = (geom_entry*)malloc(sizeof(geom_entry));
+	if (entry == NULL)
+		return NULL;
+
+	//mapping the file without the lock
+	SDL_UnlockMutex(cache->lock);
+	opened = openStoredGeometry(lsys, hash, entry);
+	SDL_LockMutex(cache->lock);
+
+	//using an entry added by another thread while the lock was let go
+	found = findEntry(cache, lsys, hash);
+	if (!opened || found != NULL){
+		if (opened)
+			closeStoredGeometry(entry);
+		free(entry);
+		return found;
+	}
+
+	entry->hash = hash;
+	entry->key = *lsys;
+	entry->key.string = NULL;
+	entry->key.line_list = NULL;
+	entry->key.cancel_flag = NULL;
+	entry->key.progress = NULL;
+	entry->bytes = sizeof(geom_entry) + entry->mapping_size;
+	entry->users = 0;
+	entry->removed = 0;
+
+	//a file too big to keep is only used by the one lookup
+	if (entry->bytes > cache->budget)
+		entry->removed = 1;
+	else
+		addEntry(cache, entry);
+	return entry;
+}
+
+static void addEntry(geom_cache *cache, geom_entry *entry){
+	/**
+	 * \brief Adds an entry to the cache, freeing the least recently used to make room.
+	 *
+	 * The cache lock must be held and the entry must not be bigger than the budget.
+	 *
+	 * \param[out] cache 	the cache to add to.
+	 * \param[out] entry 	the entry, with its hash, key, geometry and bytes set.
+	 */
+
+	int bucket = entry->hash % CACHE_BUCKETS;
+
+	//freeing the least recently used entries until the new one fits
+	while (cache->bytes + entry->bytes > cache->budget)
+		removeEntry(cache, cache->oldest);
+
+	entry->chain = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+	linkNewest(cache, entry);
+	cache->entry_count++;
+	cache->bytes += entry->bytes;
+}
+
+static void unlinkEntry(geom_cache *cache, geom_entry *entry){
+	/**
+	 * \brief Takes an entry out of the order of use, the cache lock must be held.
+	 *
+	 * \param[out] cache 	the cache holding the entry.
+	 * \param[out] entry 	the entry to be taken out.
+	 */
+
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		cache->newest = entry->next;
+
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		cache->oldest = entry->prev;
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static void linkNewest(geom_cache *cache, geom_entry *entry){
+	/**
+	 * \brief Puts an entry at the front of the order of use, the cache lock must be held.
+	 *
+	 * \param[out] cache 	the cache holding the entry.
+	 * \param[out] entry 	the entry that has just been used.
+	 */
+
+	entry->prev = NULL;
+	entry->next = cache->newest;
+	if (cache->newest != NULL)
+		cache->newest->prev = entry;
+	cache->newest = entry;
+	if (cache->oldest == NULL)
+		cache->oldest = entry;
+}
+
+static void removeEntry(geom_cache *cache, geom_entry *entry){
+	/**
+	 * \brief Takes an entry out of the hash table and the order of use and frees it.
+	 *
+	 * An entry that a lookup is still copying out of is only marked as removed, and is freed
+	 * by releaseEntry() when the lookup is done. Its bytes stop counting against the budget
+	 * straight away.
+	 *
+	 * \param[out] cache 	the cache holding the entry.
+	 * \param[out] entry 	the entry to be freed.
+	 */
+
+	geom_entry **place = &(cache->buckets[entry->hash % CACHE_BUCKETS]);
+
+	while (*place != entry)
+		place = &((*place)->chain);
+	*place = entry->chain;
+
+	unlinkEntry(cache, entry);
+	cache->entry_count--;
+	cache->bytes -= entry->bytes;
+
+	if (entry->users > 0)
+		entry->removed = 1;
+	else
+		freeEntry(entry);
+}
+
+static void releaseEntry(geom_entry *entry){
+	/**
+	 * \brief Stops counting a lookup as a user of an entry, freeing the entry if it was removed while in use.
+	 *
+	 * The cache lock must be held.
+	 *
+	 * \param[out] entry 	the entry the lookup has finished copying out of.
+	 */
+
+	entry->users--;
+	if (entry->removed && entry->users == 0)
+		freeEntry(entry);
+}
+
+static void freeEntry(geom_entry *entry){
+	/**
+	 * \brief Frees an entry and the geometry it holds or maps.
+	 *
+	 * Entries that point into a stored geometry file unmap it rather than freeing their geometry.
+	 *
+	 * \param[out] entry 	the entry, which is no longer in the cache.
+	 */
+
+	if (entry->mapping != NULL)
+		closeStoredGeometry(entry);
+	else{
+		free(entry->string);
+		free(entry->line_list);
+	}
+	free(entry);
+}
+
+static unsigned long long hashBytes(unsigned long long hash, const void *data, size_t size){
+	/**
+	 * \brief Mixes a block of bytes into a 64 bit FNV-1a hash.
+	 *
+	 * \param[in] hash 		the hash so far.
+	 * \param[in] data 		the bytes to be added.
+	 * \param[in] size 		the number of bytes.
+	 *
+	 * \return 				the new hash.
+	 */
+
+	const unsigned char *bytes = (const unsigned char*)data;
+	size_t i = 0;
+
+	for (i = 0; i < size; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,38 @@
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+/** \brief Default memory budget for the geometry cache in bytes.*/
+#define CACHE_BUDGET (128*1024*1024)
+
+
+/*
+ * Sets up the lock and memory budget of a cache.
+ */
+int initCache(geom_cache *cache, size_t budget);
+
+/*
+ * Frees every entry in the cache and its lock.
+ */
+void freeCache(geom_cache *cache);
+
+/*
+ * Makes a hash of the axiom, rules, angle and depth of an lsystem.
+ */
+unsigned long long hashLsystem(lsystem *lsys);
+
+/*
+ * Copies the placed line list, and the string if it is needed, for the lsystem out of the cache if they are held.
+ */
+int cacheLookup(geom_cache *cache, lsystem *lsys, int need_string);
+
+/*
+ * Returns true if the cache holds the string and line list for the lsystem.
+ */
+int cacheContains(geom_cache *cache, lsystem *lsys);
+
+/*
+ * Hands a finished string and line list (made with a line length of 1 from (0, 0)) to the cache.
+ */
+int cacheInsert(geom_cache *cache, lsystem *key, char *string, line *line_list, int line_list_length);
+
+#endif
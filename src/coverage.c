@@ -0,0 +1,295 @@
+/**
+ * \file coverage.c
+ *
+ * \brief A source file for drawing the fractal on the drawing screen once for each line list,
+ * as a mask of how much of each pixel it covers, and colouring that mask separately.
+ *
+ * Drawing a fractal of millions of lines takes far longer than touching each pixel of the
+ * drawing screen once, but only the line list decides which pixels are covered. The lines
+ * are drawn into a mask of levels from COVERAGE_NONE to COVERAGE_FULL, which is only redrawn
+ * when the geometry version of the line list, the view (lines or density) or whether the
+ * lines are anti-aliased changes. The
+ * colours are put on by a separate composite, which looks each level up in a table of 256
+ * colours blended from the background to the line colour, so changing the colours is one
+ * pass over the pixels whatever the number of lines. The line list is kept while the colours
+ * are changed on the options screen, and placeLines() keeps the geometry version when the
+ * same lines are placed again on coming back, so the mask is not drawn again.
+ *
+ * A fractal of millions of lines can still take seconds to draw, so the lines are drawn a
+ * slice at a time until a time budget runs out, and the rest are left for the next frame.
+ * The window keeps handling clicks in between and the fractal fills in as it is drawn. A
+ * new line list starts the mask again from its first line, dropping what was left of the
+ * old one. The time spent on every slice of a line list is added up, for the timings shown in
+ * the info overlay.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+#include "density.h"
+#include "trace.h"
+#include "timing.h"
+#include "coverage.h"
+
+
+/*
+ * Draws a line into the levels of a coverage mask with the bresenham line drawing algorithm.
+ */
+static void coverageLine(coverage_mask *mask, coordinate start, coordinate end);
+
+/*
+ * Returns true if two colours have the same red, green and blue.
+ */
+static int sameColour(SDL_Colour first, SDL_Colour second);
+
+
+int initCoverage(coverage_mask *mask, int width, int height){
+	/**
+	 * \brief Allocates the levels and coloured pixels of a coverage mask.
+	 *
+	 * \param[out] mask 	a mask initialised with structInitCoverageMask().
+	 * \param[in] width 	width of the mask in pixels.
+	 * \param[in] height 	height of the mask in pixels.
+	 *
+	 * \return 				1 if sucessfull, 0 if the size is not valid or memory allocation failed.
+	 */
+
+	if (width < 1 || height < 1)
+		return 0;
+
+	mask->levels = (Uint8*)calloc((size_t)width*height, sizeof(Uint8));
+	if (mask->levels == NULL || !initRaster(&(mask->image), width, height)){
+		printf("coverage mask memory allocation failed\n");
+		free(mask->levels);
+		mask->levels = NULL;
+		return 0;
+	}
+
+	mask->width = width;
+	mask->height = height;
+	mask->geometry_version = -1;
+	mask->composited = 0;
+	return 1;
+}
+
+void freeCoverage(coverage_mask *mask){
+	/**
+	 * \brief Frees the levels, pixels and texture of a coverage mask.
+	 *
+	 * \param[out] mask 	the mask to be freed.
+	 */
+
+	free(mask->levels);
+	freeDensity(&(mask->map));
+	freeRaster(&(mask->image));
+	if (mask->texture != NULL)
+		SDL_DestroyTexture(mask->texture);
+	structInitCoverageMask(mask);
+}
+
+int updateCoverage(coverage_mask *mask, lsystem *lsys, double scale, coordinate offset, double budget){
+	/**
+	 * \brief Draws more of the lsystem's line list into the levels of a coverage mask, until it is all drawn or a time budget runs out.
+	 *
+	 * Lines are drawn at COVERAGE_FULL, or with the lsystem's anti-alias flag set, as the share of
+	 * each pixel they cover by rasterLineAA(). With the density flag set the lines are counted
+	 * into the mask's density map instead, and the levels are the densities counted so far, tone
+	 * mapped with DENSITY_LOG. Each point is placed at offset + scale*point, and the scale and
+	 * offset are expected to stay the same for a mask.
+	 *
+	 * Lines are drawn COVERAGE_SLICE at a time, and the time is checked after each slice, so
+	 * at least one slice is drawn on every call. If the line list or view has changed since the
+	 * levels were started, they are cleared and drawn again from the first line.
+	 *
+	 * \param[out] mask 	the mask, allocated with initCoverage().
+	 * \param[in] lsys 		lsystem holding the line list, its geometry version and the density and anti-alias flags.
+	 * \param[in] scale 	how much to scale each point by.
+	 * \param[in] offset 	where to move the origin of the line list to.
+	 * \param[in] budget 	time in milliseconds to stop drawing after, 0 to draw every line.
+	 *
+	 * \return 				1 if the levels were changed, 0 if they were already up to date.
+	 */
+
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	Uint64 limit = budget*SDL_GetPerformanceFrequency()/1000;
+	int length = lsys->line_list == NULL ? 0 : lsys->line_list_length;
+	coordinate start;
+	coordinate end;
+	int last = 0;
+	int i = 0;
+
+	if (coverageDone(mask, lsys))
+		return 0;
+
+	//starting again from the first line if the line list or view has changed
+	if (mask->geometry_version != lsys->geometry_version || mask->density != lsys->density_flag || mask->antialias != lsys->antialias_flag){
+		memset(mask->levels, COVERAGE_NONE, (size_t)mask->width*mask->height);
+		mask->geometry_version = lsys->geometry_version;
+		mask->density = lsys->density_flag;
+		mask->antialias = lsys->antialias_flag;
+		mask->drawn = 0;
+		mask->raster_time = 0;
+
+		if (mask->density && mask->map.counts == NULL)
+			initDensity(&(mask->map), mask->width, mask->height);
+		if (mask->density && mask->map.counts != NULL)
+			memset(mask->map.counts, 0, (size_t)mask->width*mask->height*sizeof(Uint32));
+		else if (mask->density)
+			mask->drawn = length;
+	}
+
+	//drawing slices of lines until they are all drawn or the budget has run out
+	while (mask->drawn < length){
+		last = mask->drawn + COVERAGE_SLICE < length ? mask->drawn + COVERAGE_SLICE : length;
+
+		if (mask->density)
+			accumulateLines(&(mask->map), lsys->line_list + mask->drawn, last - mask->drawn, scale, offset);
+		else {
+			for (i = mask->drawn; i < last; i++){
+				start.x_pos = offset.x_pos + scale*lsys->line_list[i].start.x_pos;
+				start.y_pos = offset.y_pos + scale*lsys->line_list[i].start.y_pos;
+				end.x_pos = offset.x_pos + scale*lsys->line_list[i].end.x_pos;
+				end.y_pos = offset.y_pos + scale*lsys->line_list[i].end.y_pos;
+				if (mask->antialias)
+					rasterLineAA(&(mask->image), mask->levels, start, end);
+				else
+					coverageLine(mask, start, end);
+			}
+		}
+		mask->drawn = last;
+
+		if (budget > 0 && SDL_GetPerformanceCounter() - start_time >= limit)
+			break;
+	}
+
+	//tone mapping the densities counted so far, scaled against the largest so far
+	if (mask->density && mask->map.counts != NULL)
+		densityLevels(&(mask->map), mask->levels, DENSITY_LOG, 1);
+
+	mask->raster_time += millisecondsSince(start_time);
+	traceEnd(lsys->trace, "updateCoverage", start_time);
+	mask->composited = 0;
+	return 1;
+}
+
+int coverageDone(coverage_mask *mask, lsystem *lsys){
+	/**
+	 * \brief Returns true if every line of the lsystem's line list has been drawn into the levels of a coverage mask.
+	 *
+	 * A mask whose levels could not be allocated has nothing left that can be drawn, so is done.
+	 *
+	 * \param[in] mask 		the mask.
+	 * \param[in] lsys 		lsystem holding the line list, its geometry version and the density and anti-alias flags.
+	 */
+
+	int length = lsys->line_list == NULL ? 0 : lsys->line_list_length;
+
+	if (mask->levels == NULL)
+		return 1;
+
+	return mask->geometry_version == lsys->geometry_version && mask->density == lsys->density_flag && mask->antialias == lsys->antialias_flag && mask->drawn >= length;
+}
+
+int compositeCoverage(coverage_mask *mask, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Colours the levels of a coverage mask if they or the lsystem's colours have changed since it was last coloured.
+	 *
+	 * Each pixel of the mask's image is given its level's colour from a table blended from the
+	 * background colour to the line colour by makePalette(), which is a single lookup per pixel.
+	 *
+	 * \param[out] mask 		the mask, with its image coloured.
+	 * \param[in] bg_colour 	colour for COVERAGE_NONE.
+	 * \param[in] ln_colour 	colour for COVERAGE_FULL.
+	 *
+	 * \return 					1 if the image was coloured, 0 if it was already up to date.
+	 */
+
+	Uint32 colours[256];
+	Uint32 *pixels = mask->image.pixels;
+	Uint8 *levels = mask->levels;
+	size_t count = (size_t)mask->width*mask->height;
+	size_t i = 0;
+
+	if (mask->composited && sameColour(mask->bg_colour, bg_colour) && sameColour(mask->ln_colour, ln_colour))
+		return 0;
+
+	makePalette(colours, PALETTE_MONO, bg_colour, ln_colour);
+	for (i = 0; i < count; i++)
+		pixels[i] = colours[levels[i]];
+
+	mask->bg_colour = bg_colour;
+	mask->ln_colour = ln_colour;
+	mask->composited = 1;
+	return 1;
+}
+
+static void coverageLine(coverage_mask *mask, coordinate start, coordinate end){
+	/**
+	 * \brief Draws a line into the levels of a coverage mask with the bresenham line drawing algorithm.
+	 *
+	 * Works in the same way as rasterLine(), setting each pixel the line passes through to
+	 * COVERAGE_FULL.
+	 *
+	 * \param[out] mask 	the mask to be drawn to.
+	 * \param[in] start 	start point of the line.
+	 * \param[in] end 		end point of the line.
+	 */
+
+	int x0 = round(start.x_pos);
+	int y0 = round(start.y_pos);
+
+	int xn = round(end.x_pos);
+	int yn = round(end.y_pos);
+
+	int dx = abs(xn-x0);
+	int sx = x0<xn ? 1 : -1;
+
+	int dy = abs(yn-y0);
+	int sy = y0<yn ? 1 : -1;
+
+	int error = (dx>dy ? dx : -dy)/2;
+	int e2;
+
+	//skipping lines that are wholly off one side of the mask
+	if ((x0 < 0 && xn < 0) || (y0 < 0 && yn < 0) || (x0 >= mask->width && xn >= mask->width) || (y0 >= mask->height && yn >= mask->height))
+		return;
+
+	while (1){
+
+		//only draws points inside the mask
+		if (x0 >= 0 && x0 < mask->width && y0 >= 0 && y0 < mask->height)
+			mask->levels[(size_t)y0*mask->width + x0] = COVERAGE_FULL;
+
+		//breaks if the end of the line has been reached
+		if (x0 == xn && y0 == yn)
+			break;
+
+		e2 = error;
+		if (e2 > -dx){
+			error -= dy;
+			x0 += sx;
+		}
+
+		if (e2 < dy){
+			error += dx;
+			y0 += sy;
+		}
+	}
+}
+
+static int sameColour(SDL_Colour first, SDL_Colour second){
+	/**
+	 * \brief Returns true if two colours have the same red, green and blue.
+	 *
+	 * \param[in] first 	the first colour.
+	 * \param[in] second 	the second colour.
+	 */
+
+	return first.r == second.r && first.g == second.g && first.b == second.b;
+}
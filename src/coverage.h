@@ -0,0 +1,39 @@
+#ifndef _COVERAGE_H_
+#define _COVERAGE_H_
+
+/** \brief Level of a pixel the fractal does not cover, which is given the background colour.*/
+#define COVERAGE_NONE 0
+/** \brief Level of a pixel the fractal fully covers, which is given the line colour.*/
+#define COVERAGE_FULL 255
+/** \brief Number of lines drawn between checks of the time budget.*/
+#define COVERAGE_SLICE 4096
+/** \brief Time in milliseconds the drawing screen spends drawing lines each frame, half of a 60Hz frame.*/
+#define COVERAGE_BUDGET 8
+
+
+/*
+ * Allocates the levels and coloured pixels of a coverage mask.
+ */
+int initCoverage(coverage_mask *mask, int width, int height);
+
+/*
+ * Frees the levels, pixels and texture of a coverage mask.
+ */
+void freeCoverage(coverage_mask *mask);
+
+/*
+ * Draws more of the lsystem's line list into the levels of a coverage mask, until it is all drawn or a time budget runs out.
+ */
+int updateCoverage(coverage_mask *mask, lsystem *lsys, double scale, coordinate offset, double budget);
+
+/*
+ * Returns true if every line of the lsystem's line list has been drawn into the levels of a coverage mask.
+ */
+int coverageDone(coverage_mask *mask, lsystem *lsys);
+
+/*
+ * Colours the levels of a coverage mask if they or the lsystem's colours have changed since it was last coloured.
+ */
+int compositeCoverage(coverage_mask *mask, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+#endif
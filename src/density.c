@@ -0,0 +1,302 @@
+/**
+ * \file density.c
+ *
+ * \brief A source file for drawing fractals as a map of how many lines pass through
+ * each pixel.
+ *
+ * At high depths most lines are shorter than a pixel, so drawing them fills the same
+ * pixels over and over and the fractal becomes a solid blob. Instead each line adds one
+ * to the count of every pixel it passes through, which is a single increment for a line
+ * shorter than a pixel, and the counts are tone mapped, scaled by their logarithm or by
+ * a gamma curve so that both the faintest and the busiest parts show, then coloured from
+ * a palette of 256 colours.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+#include "density.h"
+
+
+/*
+ * Adds one to the count of the pixel containing a point, if it is inside the map.
+ */
+static void addPoint(density_map *map, double x_pos, double y_pos);
+
+/*
+ * Returns what the counts of a density map are multiplied by to scale them against the largest count.
+ */
+static double levelScale(density_map *map, int tone);
+
+/*
+ * Returns the level from 0 to 255 of a count.
+ */
+static int countLevel(Uint32 count, double scale, int tone, double gamma);
+
+
+int initDensity(density_map *map, int width, int height){
+	/**
+	 * \brief Allocates the counts of a density map and sets them to zero.
+	 *
+	 * \param[out] map 		a map initialised with structInitDensityMap().
+	 * \param[in] width 	width of the map in pixels.
+	 * \param[in] height 	height of the map in pixels.
+	 *
+	 * \return 				1 if sucessfull, 0 if the size is not valid or memory allocation failed.
+	 */
+
+	if (width < 1 || height < 1)
+		return 0;
+
+	map->counts = (Uint32*)calloc((size_t)width*height, sizeof(Uint32));
+	if (map->counts == NULL){
+		printf("density map memory allocation failed\n");
+		return 0;
+	}
+
+	map->width = width;
+	map->height = height;
+	return 1;
+}
+
+void freeDensity(density_map *map){
+	/**
+	 * \brief Frees the counts of a density map.
+	 *
+	 * \param[out] map 		the map to be freed.
+	 */
+
+	free(map->counts);
+	structInitDensityMap(map);
+}
+
+void accumulateLines(density_map *map, line *line_list, int length, double scale, coordinate offset){
+	/**
+	 * \brief Adds the pixels each line passes through to a density map.
+	 *
+	 * Each point is placed at offset + scale*point, as rasterFractal() places it. A line shorter
+	 * than a pixel counts once, at its middle. A longer line is split into one step for each
+	 * pixel of its length and counts once at the middle of each step, so every pixel it crosses
+	 * counts about once however it is drawn.
+	 *
+	 * \param[out] map 			the map to be added to.
+	 * \param[in] line_list 	the lines.
+	 * \param[in] length 		number of lines in the line list.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 */
+
+	double start_x = 0;
+	double start_y = 0;
+	double dx = 0;
+	double dy = 0;
+	double size = 0;
+	int steps = 0;
+	int i = 0;
+	int j = 0;
+
+	for (i = 0; i < length; i++){
+		start_x = offset.x_pos + scale*line_list[i].start.x_pos;
+		start_y = offset.y_pos + scale*line_list[i].start.y_pos;
+		dx = offset.x_pos + scale*line_list[i].end.x_pos - start_x;
+		dy = offset.y_pos + scale*line_list[i].end.y_pos - start_y;
+		size = fmax(fabs(dx), fabs(dy));
+
+		if (size < 1){
+			addPoint(map, start_x + dx/2, start_y + dy/2);
+			continue;
+		}
+
+		//skipping lines that are wholly off one side of the map
+		if ((start_x < 0 && start_x + dx < 0) || (start_y < 0 && start_y + dy < 0) || (start_x >= map->width && start_x + dx >= map->width) || (start_y >= map->height && start_y + dy >= map->height))
+			continue;
+
+		steps = ceil(size);
+		for (j = 0; j < steps; j++)
+			addPoint(map, start_x + dx*(j + 0.5)/steps, start_y + dy*(j + 0.5)/steps);
+	}
+}
+
+void makePalette(Uint32 *colours, int palette, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Fills a table of 256 colours from a palette, darkest or faintest first.
+	 *
+	 * The colours are blended evenly between the stops of the palette. The first colour is used
+	 * for pixels no line passes through, which is the background colour for PALETTE_MONO.
+	 *
+	 * \param[out] colours 		table of 256 ARGB8888 colours.
+	 * \param[in] palette 		one of the PALETTE_ values.
+	 * \param[in] bg_colour 	background colour, used by PALETTE_MONO.
+	 * \param[in] ln_colour 	line colour, used by PALETTE_MONO.
+	 */
+
+	static const Uint8 fire[5][3] = {{0, 0, 0}, {128, 0, 0}, {255, 64, 0}, {255, 200, 0}, {255, 255, 255}};
+	static const Uint8 ice[5][3] = {{0, 0, 0}, {0, 32, 96}, {0, 128, 200}, {128, 220, 255}, {255, 255, 255}};
+	static const Uint8 viridis[5][3] = {{68, 1, 84}, {59, 82, 139}, {33, 145, 140}, {94, 201, 98}, {253, 231, 37}};
+	Uint8 stops[5][3];
+	int stop_count = 5;
+	double position = 0;
+	double blend = 0;
+	int stop = 0;
+	int channel = 0;
+	Uint8 value[3];
+	int i = 0;
+
+	switch(palette){
+		case PALETTE_FIRE: memcpy(stops, fire, sizeof(stops)); break;
+		case PALETTE_ICE: memcpy(stops, ice, sizeof(stops)); break;
+		case PALETTE_VIRIDIS: memcpy(stops, viridis, sizeof(stops)); break;
+		default:
+			stops[0][0] = bg_colour.r;
+			stops[0][1] = bg_colour.g;
+			stops[0][2] = bg_colour.b;
+			stops[1][0] = ln_colour.r;
+			stops[1][1] = ln_colour.g;
+			stops[1][2] = ln_colour.b;
+			stop_count = 2;
+	}
+
+	for (i = 0; i < 256; i++){
+		position = i*(stop_count-1)/255.0;
+		stop = position >= stop_count-1 ? stop_count-2 : (int)position;
+		blend = position - stop;
+		for (channel = 0; channel < 3; channel++)
+			value[channel] = stops[stop][channel] + blend*(stops[stop+1][channel] - stops[stop][channel]) + 0.5;
+		colours[i] = 0xff000000 | (Uint32)value[0] << 16 | (Uint32)value[1] << 8 | value[2];
+	}
+}
+
+void toneMapDensity(density_map *map, raster_image *image, int tone, double gamma, Uint32 *colours){
+	/**
+	 * \brief Turns the counts of a density map into the colours of an image of the same size.
+	 *
+	 * Each pixel is given the colour of its level from densityLevels(), so pixels with no lines
+	 * are given colours[0].
+	 *
+	 * \param[in] map 			the map.
+	 * \param[out] image 		an image the same size as the map.
+	 * \param[in] tone 			DENSITY_LOG or DENSITY_GAMMA.
+	 * \param[in] gamma 		gamma for DENSITY_GAMMA.
+	 * \param[in] colours 		table of 256 colours from makePalette().
+	 */
+
+	size_t count = (size_t)map->width*map->height;
+	double scale = levelScale(map, tone);
+	size_t i = 0;
+
+	if (tone == DENSITY_GAMMA && gamma <= 0)
+		gamma = 1;
+
+	for (i = 0; i < count; i++)
+		image->pixels[i] = colours[countLevel(map->counts[i], scale, tone, gamma)];
+}
+
+void densityLevels(density_map *map, Uint8 *levels, int tone, double gamma){
+	/**
+	 * \brief Turns the counts of a density map into levels from 0 to 255, to be coloured later.
+	 *
+	 * Counts are scaled against the largest count, by log(1+count)/log(1+largest) for DENSITY_LOG
+	 * or (count/largest)^(1/gamma) for DENSITY_GAMMA, and given levels 1 to 255, so that a pixel
+	 * any line passes through always shows. Pixels with no lines are given level 0.
+	 *
+	 * \param[in] map 			the map.
+	 * \param[out] levels 		array of one level for each count of the map.
+	 * \param[in] tone 			DENSITY_LOG or DENSITY_GAMMA.
+	 * \param[in] gamma 		gamma for DENSITY_GAMMA.
+	 */
+
+	size_t count = (size_t)map->width*map->height;
+	double scale = levelScale(map, tone);
+	size_t i = 0;
+
+	if (tone == DENSITY_GAMMA && gamma <= 0)
+		gamma = 1;
+
+	for (i = 0; i < count; i++)
+		levels[i] = countLevel(map->counts[i], scale, tone, gamma);
+}
+
+int findPalette(char *name){
+	/**
+	 * \brief Returns the palette named by a setting value, or -1 if there is none.
+	 *
+	 * \param[in] name 		"mono", "fire", "ice" or "viridis".
+	 */
+
+	if (strcmp(name, "mono") == 0)
+		return PALETTE_MONO;
+	if (strcmp(name, "fire") == 0)
+		return PALETTE_FIRE;
+	if (strcmp(name, "ice") == 0)
+		return PALETTE_ICE;
+	if (strcmp(name, "viridis") == 0)
+		return PALETTE_VIRIDIS;
+
+	return -1;
+}
+
+static void addPoint(density_map *map, double x_pos, double y_pos){
+	/**
+	 * \brief Adds one to the count of the pixel containing a point, if it is inside the map.
+	 *
+	 * Points are rounded to the nearest pixel, as rasterLine() rounds them.
+	 *
+	 * \param[out] map 		the map.
+	 * \param[in] x_pos 	x position of the point.
+	 * \param[in] y_pos 	y position of the point.
+	 */
+
+	double x = floor(x_pos + 0.5);
+	double y = floor(y_pos + 0.5);
+
+	if (x >= 0 && x < map->width && y >= 0 && y < map->height)
+		map->counts[(size_t)y*map->width + (size_t)x]++;
+}
+
+static double levelScale(density_map *map, int tone){
+	/**
+	 * \brief Returns what the counts of a density map are multiplied by to scale them against the largest count.
+	 *
+	 * \param[in] map 		the map.
+	 * \param[in] tone 		DENSITY_LOG, where log(1+count) is scaled, or DENSITY_GAMMA, where the count is.
+	 */
+
+	size_t count = (size_t)map->width*map->height;
+	Uint32 largest = 0;
+	size_t i = 0;
+
+	for (i = 0; i < count; i++)
+		if (map->counts[i] > largest)
+			largest = map->counts[i];
+
+	return tone == DENSITY_LOG ? 1/log1p(largest) : 1.0/largest;
+}
+
+static int countLevel(Uint32 count, double scale, int tone, double gamma){
+	/**
+	 * \brief Returns the level from 0 to 255 of a count.
+	 *
+	 * \param[in] count 	the count.
+	 * \param[in] scale 	value from levelScale().
+	 * \param[in] tone 		DENSITY_LOG or DENSITY_GAMMA.
+	 * \param[in] gamma 	gamma for DENSITY_GAMMA, above 0.
+	 */
+
+	double level = 0;
+
+	if (count == 0)
+		return 0;
+
+	if (tone == DENSITY_LOG)
+		level = log1p(count)*scale;
+	else
+		level = pow(count*scale, 1/gamma);
+
+	return 1 + (int)(level*254 + 0.5);
+}
@@ -0,0 +1,56 @@
+#ifndef _DENSITY_H_
+#define _DENSITY_H_
+
+/** \brief Counts are scaled by their logarithm, which shows detail across the widest range.*/
+#define DENSITY_LOG 0
+/** \brief Counts are scaled by a power of 1/gamma.*/
+#define DENSITY_GAMMA 1
+
+/** \brief Blends from the background colour to the line colour.*/
+#define PALETTE_MONO 0
+/** \brief Black through red and yellow to white.*/
+#define PALETTE_FIRE 1
+/** \brief Black through blue to white.*/
+#define PALETTE_ICE 2
+/** \brief Purple through blue and green to yellow.*/
+#define PALETTE_VIRIDIS 3
+/** \brief Number of palettes.*/
+#define PALETTE_COUNT 4
+
+
+/*
+ * Allocates the counts of a density map and sets them to zero.
+ */
+int initDensity(density_map *map, int width, int height);
+
+/*
+ * Frees the counts of a density map.
+ */
+void freeDensity(density_map *map);
+
+/*
+ * Adds the pixels each line passes through to a density map.
+ */
+void accumulateLines(density_map *map, line *line_list, int length, double scale, coordinate offset);
+
+/*
+ * Fills a table of 256 colours from a palette, darkest or faintest first.
+ */
+void makePalette(Uint32 *colours, int palette, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+/*
+ * Turns the counts of a density map into the colours of an image of the same size.
+ */
+void toneMapDensity(density_map *map, raster_image *image, int tone, double gamma, Uint32 *colours);
+
+/*
+ * Turns the counts of a density map into levels from 0 to 255, to be coloured later.
+ */
+void densityLevels(density_map *map, Uint8 *levels, int tone, double gamma);
+
+/*
+ * Returns the palette named by a setting value, or -1 if there is none.
+ */
+int findPalette(char *name);
+
+#endif
@@ -0,0 +1,880 @@
+/**
+ * \file encode.c
+ *
+ * \brief A source file for writing images as compressed PNG or QOI files without any
+ * libraries beyond SDL.
+ *
+ * Images of line art are mostly long runs of the background colour, so they shrink
+ * many times over with even simple compression, where a bmp of the drawing area is
+ * 3.2 MB every time. PNG files are written as 8 bit RGB, with each row stored as the
+ * difference from the row above, which turns everything the lines do not touch into
+ * zeros. The rows are compressed with deflate using the fixed Huffman codes and a
+ * greedy search for repeated runs through a hash chain, which gets most of the gain
+ * of a full deflate encoder at a small part of the cost. PNG can also be written with
+ * the data stored uncompressed, and QOI is written as its specification describes.
+ *
+ * PNG files are written through a png_stream, which takes one row at a time and only
+ * holds the last DEFLATE_WINDOW bytes that runs can repeat and one chunk of output, so
+ * images far too large to hold, such as tiled posters, can be written as they are drawn.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+#include "encode.h"
+
+
+/*
+ * Adds a byte to the compressed output, writing it as a chunk when it is full.
+ */
+static void putByte(png_stream *png, unsigned char byte);
+
+/*
+ * Adds a number of bits to the compressed output, lowest bit first.
+ */
+static void putBits(png_stream *png, unsigned long value, int count);
+
+/*
+ * Adds a Huffman code to the compressed output, highest bit first as deflate stores codes.
+ */
+static void putCode(png_stream *png, unsigned long code, int length);
+
+/*
+ * Adds any bits waiting to the compressed output, padding the last byte with zeros.
+ */
+static void flushBits(png_stream *png);
+
+/*
+ * Writes the compressed output waiting as an IDAT chunk.
+ */
+static void flushChunk(png_stream *png);
+
+/*
+ * Adds a literal byte or the end of block symbol with its fixed Huffman code.
+ */
+static void putLiteral(png_stream *png, int symbol);
+
+/*
+ * Adds a repeated run with its fixed Huffman codes.
+ */
+static void putMatch(png_stream *png, int length, int distance);
+
+/*
+ * Adds filtered bytes to the stream, compressing or storing them as the window fills.
+ */
+static void addBytes(png_stream *png, unsigned char *data, int length);
+
+/*
+ * Writes the bytes in the window as an uncompressed block.
+ */
+static void putStoredBlock(png_stream *png, int final);
+
+/*
+ * Compresses the bytes in the window that have enough bytes after them to find runs in.
+ */
+static void compressWindow(png_stream *png, int finish);
+
+/*
+ * Drops the oldest half of the window to make room for more bytes.
+ */
+static void slideWindow(png_stream *png);
+
+/*
+ * Returns the hash of the 3 bytes starting at a position, used to find earlier runs.
+ */
+static int hashBytes(unsigned char *data);
+
+/*
+ * Frees the buffers of a PNG stream.
+ */
+static void freePNGStream(png_stream *png);
+
+/*
+ * Writes a PNG chunk with its length and checksum.
+ */
+static int writeChunk(FILE *file, char *type, unsigned char *data, size_t length);
+
+/*
+ * Updates a CRC-32 checksum with a block of bytes.
+ */
+static unsigned long crc32Bytes(unsigned long crc, unsigned char *data, size_t length);
+
+/*
+ * Writes a 32 bit value to a byte array, highest byte first.
+ */
+static void putBigEndian(unsigned char *data, unsigned long value);
+
+
+/** \brief Smallest length for each deflate length code from 257.*/
+static const int length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+/** \brief Number of extra bits for each deflate length code from 257.*/
+static const int length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+/** \brief Smallest distance for each deflate distance code.*/
+static const int distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+/** \brief Number of extra bits for each deflate distance code.*/
+static const int distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+
+int saveImage(raster_image *image, char *name, int format){
+	/**
+	 * \brief Saves an image in the given format.
+	 *
+	 * \param[in] image 	the image to be saved.
+	 * \param[in] name 		file name for the image.
+	 * \param[in] format 	one of the IMAGE_ values.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	FILE *file = NULL;
+	int saved = 0;
+
+	if (format == IMAGE_BMP)
+		return saveRaster(image, name);
+	if (format == IMAGE_SVG){
+		printf("Could not save %s, svg files are saved from the line list\n", name);
+		return 0;
+	}
+
+	file = fopen(name, "wb");
+	if (file == NULL){
+		printf("Could not save %s\n", name);
+		return 0;
+	}
+
+	if (format == IMAGE_QOI)
+		saved = encodeQOI(image, file);
+	else
+		saved = encodePNG(image, file, format == IMAGE_PNG);
+
+	if (fclose(file) != 0)
+		saved = 0;
+	if (!saved)
+		printf("Could not save %s\n", name);
+
+	return saved;
+}
+
+int encodePNG(raster_image *image, FILE *file, int compress){
+	/**
+	 * \brief Writes an image to a file as an RGB PNG.
+	 *
+	 * \param[in] image 	the image to be written.
+	 * \param[out] file 	file open for writing in binary mode.
+	 * \param[in] compress 	true to compress with deflate, false to store the data uncompressed.
+	 *
+	 * \return 				1 if sucessfull, 0 if memory could not be allocated or the file could not be written.
+	 */
+
+	png_stream png;
+	int y = 0;
+
+	if (!openPNGStream(&png, file, image->width, image->height, compress))
+		return 0;
+
+	for (y = 0; y < image->height; y++)
+		writePNGRow(&png, image->pixels + (size_t)y*image->width);
+
+	return closePNGStream(&png);
+}
+
+int openPNGStream(png_stream *png, FILE *file, int width, int height, int compress){
+	/**
+	 * \brief Starts writing a PNG to a file that rows are then added to one at a time.
+	 *
+	 * \param[out] png 		the stream, which does not need to be initialised.
+	 * \param[out] file 	file open for writing in binary mode, which is not closed with the stream.
+	 * \param[in] width 	width of the image in pixels.
+	 * \param[in] height 	height of the image in pixels.
+	 * \param[in] compress 	true to compress with deflate, false to store the data uncompressed.
+	 *
+	 * \return 				1 if sucessfull, 0 if memory could not be allocated or the file could not be written.
+	 */
+
+	static const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+	unsigned char header[13];
+	int i = 0;
+
+	structInitPngStream(png);
+	png->file = file;
+	png->width = width;
+	png->height = height;
+	png->compress = compress;
+
+	png->row = (unsigned char*)malloc(1 + 3*(size_t)width);
+	png->above = (unsigned char*)calloc(3*(size_t)width, 1);
+	png->window = (unsigned char*)malloc(2*DEFLATE_WINDOW);
+	png->out = (unsigned char*)malloc(PNG_CHUNK_BYTES);
+	if (compress){
+		png->head = (int*)malloc(65536*sizeof(int));
+		png->previous = (int*)malloc(DEFLATE_WINDOW*sizeof(int));
+	}
+	if (png->row == NULL || png->above == NULL || png->window == NULL || png->out == NULL || (compress && (png->head == NULL || png->previous == NULL))){
+		printf("PNG memory allocation failed\n");
+		freePNGStream(png);
+		return 0;
+	}
+	for (i = 0; compress && i < 65536; i++)
+		png->head[i] = -1;
+
+	//8 bit RGB, default compression and filtering, not interlaced
+	putBigEndian(header, width);
+	putBigEndian(header + 4, height);
+	header[8] = 8;
+	header[9] = 2;
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	if (fwrite(signature, 1, 8, file) != 8 || !writeChunk(file, "IHDR", header, 13)){
+		freePNGStream(png);
+		return 0;
+	}
+
+	//zlib header for deflate with a 32K window, then one final block with the fixed codes if compressing
+	putByte(png, 0x78);
+	putByte(png, 0x01);
+	if (compress){
+		putBits(png, 1, 1);
+		putBits(png, 1, 2);
+	}
+
+	return 1;
+}
+
+int writePNGRow(png_stream *png, Uint32 *pixels){
+	/**
+	 * \brief Adds the next row of pixels to a PNG stream.
+	 *
+	 * Every row but the first uses the "up" filter, storing the difference from the row above.
+	 *
+	 * \param[out] png 		the open stream.
+	 * \param[in] pixels 	width pixels in ARGB8888 format.
+	 *
+	 * \return 				1 if sucessfull, 0 if every row has been written or the stream has failed.
+	 */
+
+	unsigned char *above = png->above;
+	unsigned char *row = png->row;
+	unsigned char r = 0;
+	unsigned char g = 0;
+	unsigned char b = 0;
+	int x = 0;
+
+	if (png->failed || png->rows == png->height)
+		return 0;
+
+	row[0] = png->rows > 0 ? 2 : 0;
+	for (x = 0; x < png->width; x++){
+		r = (pixels[x] >> 16) & 0xff;
+		g = (pixels[x] >> 8) & 0xff;
+		b = pixels[x] & 0xff;
+		row[1 + 3*x] = r - above[3*x];
+		row[2 + 3*x] = g - above[3*x+1];
+		row[3 + 3*x] = b - above[3*x+2];
+		above[3*x] = r;
+		above[3*x+1] = g;
+		above[3*x+2] = b;
+	}
+
+	addBytes(png, row, 1 + 3*png->width);
+	png->rows++;
+
+	return !png->failed;
+}
+
+int closePNGStream(png_stream *png){
+	/**
+	 * \brief Finishes a PNG stream, writing the end of the data and frees its buffers.
+	 *
+	 * \param[out] png 		the open stream.
+	 *
+	 * \return 				1 if the whole image was written, 0 if not.
+	 */
+
+	unsigned char checksum[4];
+	int written = 0;
+	int i = 0;
+
+	if (png->rows < png->height){
+		printf("PNG closed after %d of %d rows\n", png->rows, png->height);
+		png->failed = 1;
+	}
+
+	if (png->compress){
+		compressWindow(png, 1);
+		putLiteral(png, 256);
+		flushBits(png);
+	}
+	else
+		putStoredBlock(png, 1);
+
+	//Adler-32 checksum of the filtered rows
+	putBigEndian(checksum, (png->adler_b << 16) | png->adler_a);
+	for (i = 0; i < 4; i++)
+		putByte(png, checksum[i]);
+	flushChunk(png);
+
+	written = !png->failed && writeChunk(png->file, "IEND", NULL, 0);
+	freePNGStream(png);
+	return written;
+}
+
+int encodeQOI(raster_image *image, FILE *file){
+	/**
+	 * \brief Writes an image to a file in the Quite OK Image format.
+	 *
+	 * The image is written with 3 channels, as the drawing is always opaque.
+	 *
+	 * \param[in] image 	the image to be written.
+	 * \param[out] file 	file open for writing in binary mode.
+	 *
+	 * \return 				1 if sucessfull, 0 if memory could not be allocated or the file could not be written.
+	 */
+
+	static const unsigned char end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+	size_t count = (size_t)image->width*image->height;
+	unsigned char *out = (unsigned char*)malloc(14 + 4*count + 8);
+	size_t pos = 0;
+	Uint32 seen[64];
+	Uint32 pixel = 0;
+	Uint32 previous = 0xff000000;
+	int run = 0;
+	int index = 0;
+	int dr = 0;
+	int dg = 0;
+	int db = 0;
+	size_t i = 0;
+	int written = 0;
+
+	if (out == NULL){
+		printf("QOI memory allocation failed\n");
+		return 0;
+	}
+
+	memset(seen, 0, sizeof(seen));
+	memcpy(out, "qoif", 4);
+	putBigEndian(out + 4, image->width);
+	putBigEndian(out + 8, image->height);
+	out[12] = 3;
+	out[13] = 0;
+	pos = 14;
+
+	for (i = 0; i < count; i++){
+		pixel = image->pixels[i] | 0xff000000;
+
+		//runs of the same pixel
+		if (pixel == previous){
+			run++;
+			if (run == 62 || i == count-1){
+				out[pos++] = 0xc0 | (run-1);
+				run = 0;
+			}
+			continue;
+		}
+		if (run > 0){
+			out[pos++] = 0xc0 | (run-1);
+			run = 0;
+		}
+
+		//pixels seen recently, then small differences, then the full colour
+		index = (((pixel >> 16) & 0xff)*3 + ((pixel >> 8) & 0xff)*5 + (pixel & 0xff)*7 + 255*11) % 64;
+		if (seen[index] == pixel)
+			out[pos++] = index;
+		else {
+			seen[index] = pixel;
+			dr = (int)((pixel >> 16) & 0xff) - (int)((previous >> 16) & 0xff);
+			dg = (int)((pixel >> 8) & 0xff) - (int)((previous >> 8) & 0xff);
+			db = (int)(pixel & 0xff) - (int)(previous & 0xff);
+			dr = (signed char)dr;
+			dg = (signed char)dg;
+			db = (signed char)db;
+
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				out[pos++] = 0x40 | (dr+2) << 4 | (dg+2) << 2 | (db+2);
+			else if (dg >= -32 && dg <= 31 && dr-dg >= -8 && dr-dg <= 7 && db-dg >= -8 && db-dg <= 7){
+				out[pos++] = 0x80 | (dg+32);
+				out[pos++] = (dr-dg+8) << 4 | (db-dg+8);
+			}
+			else {
+				out[pos++] = 0xfe;
+				out[pos++] = (pixel >> 16) & 0xff;
+				out[pos++] = (pixel >> 8) & 0xff;
+				out[pos++] = pixel & 0xff;
+			}
+		}
+		previous = pixel;
+	}
+
+	memcpy(out + pos, end_marker, 8);
+	pos += 8;
+
+	written = fwrite(out, 1, pos, file) == pos;
+	free(out);
+	return written;
+}
+
+char *imageExtension(int format){
+	/**
+	 * \brief Returns the file extension used for an image format.
+	 *
+	 * \param[in] format 	one of the IMAGE_ values.
+	 */
+
+	switch(format){
+		case IMAGE_QOI: return "qoi";
+		case IMAGE_BMP: return "bmp";
+		case IMAGE_SVG: return "svg";
+		default: return "png";
+	}
+}
+
+char *imageFormatName(int format){
+	/**
+	 * \brief Returns a short name for an image format to show on buttons.
+	 *
+	 * \param[in] format 	one of the IMAGE_ values.
+	 */
+
+	switch(format){
+		case IMAGE_QOI: return "QOI";
+		case IMAGE_BMP: return "BMP";
+		case IMAGE_PNG_STORED: return "PNG (stored)";
+		case IMAGE_SVG: return "SVG";
+		default: return "PNG";
+	}
+}
+
+int findImageFormat(char *name){
+	/**
+	 * \brief Returns the image format named by a setting value or used by a file name, or -1 if there is none.
+	 *
+	 * \param[in] name 		"png", "png-stored", "qoi", "bmp" or "svg", or a file name ending in one of them.
+	 */
+
+	char *extension = strrchr(name, '.');
+
+	if (strcmp(name, "png-stored") == 0)
+		return IMAGE_PNG_STORED;
+	if (extension != NULL)
+		name = extension+1;
+
+	if (strcmp(name, "png") == 0)
+		return IMAGE_PNG;
+	if (strcmp(name, "qoi") == 0)
+		return IMAGE_QOI;
+	if (strcmp(name, "bmp") == 0)
+		return IMAGE_BMP;
+	if (strcmp(name, "svg") == 0)
+		return IMAGE_SVG;
+
+	return -1;
+}
+
+static void putByte(png_stream *png, unsigned char byte){
+	/**
+	 * \brief Adds a byte to the compressed output, writing it as a chunk when it is full.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] byte 		the byte to be added.
+	 */
+
+	if (png->failed)
+		return;
+
+	png->out[png->out_length++] = byte;
+	if (png->out_length == PNG_CHUNK_BYTES)
+		flushChunk(png);
+}
+
+static void putBits(png_stream *png, unsigned long value, int count){
+	/**
+	 * \brief Adds a number of bits to the compressed output, lowest bit first.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] value 	the bits to be added.
+	 * \param[in] count 	number of bits, at most 16.
+	 */
+
+	png->bits |= value << png->bit_count;
+	png->bit_count += count;
+
+	while (png->bit_count >= 8){
+		putByte(png, png->bits & 0xff);
+		png->bits >>= 8;
+		png->bit_count -= 8;
+	}
+}
+
+static void putCode(png_stream *png, unsigned long code, int length){
+	/**
+	 * \brief Adds a Huffman code to the compressed output, highest bit first as deflate stores codes.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] code 		the code.
+	 * \param[in] length 	number of bits in the code.
+	 */
+
+	unsigned long reversed = 0;
+	int i = 0;
+
+	for (i = 0; i < length; i++)
+		reversed |= ((code >> i) & 1) << (length-1-i);
+
+	putBits(png, reversed, length);
+}
+
+static void flushBits(png_stream *png){
+	/**
+	 * \brief Adds any bits waiting to the compressed output, padding the last byte with zeros.
+	 *
+	 * \param[out] png 		the stream.
+	 */
+
+	if (png->bit_count > 0)
+		putBits(png, 0, 8 - png->bit_count);
+}
+
+static void flushChunk(png_stream *png){
+	/**
+	 * \brief Writes the compressed output waiting as an IDAT chunk.
+	 *
+	 * The compressed data can be split between chunks at any byte.
+	 *
+	 * \param[out] png 		the stream.
+	 */
+
+	if (png->out_length > 0 && !png->failed && !writeChunk(png->file, "IDAT", png->out, png->out_length))
+		png->failed = 1;
+	png->out_length = 0;
+}
+
+static void putLiteral(png_stream *png, int symbol){
+	/**
+	 * \brief Adds a literal byte or the end of block symbol with its fixed Huffman code.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] symbol 	a byte from 0 to 255, or 256 for the end of the block.
+	 */
+
+	if (symbol < 144)
+		putCode(png, 0x30 + symbol, 8);
+	else if (symbol < 256)
+		putCode(png, 0x190 + symbol - 144, 9);
+	else
+		putCode(png, symbol - 256, 7);
+}
+
+static void putMatch(png_stream *png, int length, int distance){
+	/**
+	 * \brief Adds a repeated run with its fixed Huffman codes.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] length 	length of the run, from 3 to 258.
+	 * \param[in] distance 	how far back the run starts, from 1 to DEFLATE_WINDOW.
+	 */
+
+	int code = 0;
+	int symbol = 0;
+
+	while (code < 28 && length_base[code+1] <= length)
+		code++;
+	symbol = 257 + code;
+	if (symbol < 280)
+		putCode(png, symbol - 256, 7);
+	else
+		putCode(png, 0xc0 + symbol - 280, 8);
+	putBits(png, length - length_base[code], length_extra[code]);
+
+	code = 0;
+	while (code < 29 && distance_base[code+1] <= distance)
+		code++;
+	putCode(png, code, 5);
+	putBits(png, distance - distance_base[code], distance_extra[code]);
+}
+
+static void addBytes(png_stream *png, unsigned char *data, int length){
+	/**
+	 * \brief Adds filtered bytes to the stream, compressing or storing them as the window fills.
+	 *
+	 * Stored data is written as a block each time 65535 bytes, the most a block can hold, have
+	 * been gathered. Compressed data is compressed as far as it can be each time bytes are added.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] data 		the bytes to be added.
+	 * \param[in] length 	number of bytes.
+	 */
+
+	int count = 0;
+	int block = 0;
+	int i = 0;
+
+	//the sums only need reducing every 5552 bytes before they could overflow 32 bits
+	for (i = 0; i < length; i += block){
+		block = length - i < 5552 ? length - i : 5552;
+		for (count = 0; count < block; count++){
+			png->adler_a += data[i+count];
+			png->adler_b += png->adler_a;
+		}
+		png->adler_a %= 65521;
+		png->adler_b %= 65521;
+	}
+
+	while (length > 0 && !png->failed){
+		if (png->compress){
+			if (png->window_length == 2*DEFLATE_WINDOW)
+				slideWindow(png);
+			count = 2*DEFLATE_WINDOW - png->window_length;
+		}
+		else
+			count = 65535 - png->window_length;
+		if (count > length)
+			count = length;
+
+		memcpy(png->window + png->window_length, data, count);
+		png->window_length += count;
+		data += count;
+		length -= count;
+
+		if (png->compress)
+			compressWindow(png, 0);
+		else if (png->window_length == 65535)
+			putStoredBlock(png, 0);
+	}
+}
+
+static void putStoredBlock(png_stream *png, int final){
+	/**
+	 * \brief Writes the bytes in the window as an uncompressed block and empties it.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] final 	true if this is the last block of the stream.
+	 */
+
+	int done = 0;
+	int count = 0;
+
+	putBits(png, final, 1);
+	putBits(png, 0, 2);
+	flushBits(png);
+	putByte(png, png->window_length & 0xff);
+	putByte(png, png->window_length >> 8);
+	putByte(png, ~png->window_length & 0xff);
+	putByte(png, (~png->window_length >> 8) & 0xff);
+
+	//copying the bytes a chunk at a time
+	while (done < png->window_length && !png->failed){
+		count = PNG_CHUNK_BYTES - png->out_length;
+		if (count > png->window_length - done)
+			count = png->window_length - done;
+		memcpy(png->out + png->out_length, png->window + done, count);
+		png->out_length += count;
+		done += count;
+		if (png->out_length == PNG_CHUNK_BYTES)
+			flushChunk(png);
+	}
+
+	png->window_length = 0;
+}
+
+static void compressWindow(png_stream *png, int finish){
+	/**
+	 * \brief Compresses the bytes in the window that have enough bytes after them to find runs in.
+	 *
+	 * At each position the last DEFLATE_CHAIN positions that started with the same 3 bytes are
+	 * tried and the longest run is used, or a literal byte if there is none. Until the stream is
+	 * finished, the last DEFLATE_LOOKAHEAD bytes are left for when more bytes are added.
+	 *
+	 * \param[out] png 		the stream.
+	 * \param[in] finish 	true to compress every byte left in the window.
+	 */
+
+	unsigned char *data = png->window;
+	int length = png->window_length;
+	int limit = finish ? length : length - DEFLATE_LOOKAHEAD;
+	int pos = png->position;
+	int candidate = 0;
+	int hash = 0;
+	int best_length = 0;
+	int best_distance = 0;
+	int match = 0;
+	int tries = 0;
+	int i = 0;
+
+	while (pos < limit){
+		best_length = 0;
+		best_distance = 0;
+
+		if (pos + 2 < length){
+			//finding the longest run among earlier positions with the same first 3 bytes
+			hash = hashBytes(data + pos);
+			candidate = png->head[hash];
+			for (tries = 0; tries < DEFLATE_CHAIN && candidate >= 0 && pos - candidate <= DEFLATE_WINDOW; tries++){
+				for (match = 0; match < 258 && pos + match < length && data[candidate+match] == data[pos+match]; match++);
+				if (match > best_length){
+					best_length = match;
+					best_distance = pos - candidate;
+					if (match == 258)
+						break;
+				}
+				if (png->previous[candidate % DEFLATE_WINDOW] >= candidate)
+					break;
+				candidate = png->previous[candidate % DEFLATE_WINDOW];
+			}
+			png->previous[pos % DEFLATE_WINDOW] = png->head[hash];
+			png->head[hash] = pos;
+		}
+
+		if (best_length >= 3){
+			putMatch(png, best_length, best_distance);
+			//adding the positions inside the run to the hash chains
+			for (i = 1; i < best_length; i++){
+				if (pos + i + 2 < length){
+					hash = hashBytes(data + pos + i);
+					png->previous[(pos+i) % DEFLATE_WINDOW] = png->head[hash];
+					png->head[hash] = pos+i;
+				}
+			}
+			pos += best_length;
+		}
+		else {
+			putLiteral(png, data[pos]);
+			pos++;
+		}
+	}
+
+	png->position = pos;
+}
+
+static void slideWindow(png_stream *png){
+	/**
+	 * \brief Drops the oldest half of the window to make room for more bytes.
+	 *
+	 * Runs can only repeat bytes up to DEFLATE_WINDOW back, so once the window is full and
+	 * compressed up to its lookahead, the oldest half is no longer needed. Positions in the
+	 * hash chains move down with the bytes, and any that fall off the start are dropped.
+	 *
+	 * \param[out] png 		the stream.
+	 */
+
+	int i = 0;
+
+	memmove(png->window, png->window + DEFLATE_WINDOW, png->window_length - DEFLATE_WINDOW);
+	png->window_length -= DEFLATE_WINDOW;
+	png->position -= DEFLATE_WINDOW;
+
+	for (i = 0; i < 65536; i++)
+		png->head[i] = png->head[i] >= DEFLATE_WINDOW ? png->head[i] - DEFLATE_WINDOW : -1;
+	for (i = 0; i < DEFLATE_WINDOW; i++)
+		png->previous[i] = png->previous[i] >= DEFLATE_WINDOW ? png->previous[i] - DEFLATE_WINDOW : -1;
+}
+
+static int hashBytes(unsigned char *data){
+	/**
+	 * \brief Returns the hash of the 3 bytes starting at a position, used to find earlier runs.
+	 *
+	 * \param[in] data 		the first of the 3 bytes.
+	 */
+
+	return ((data[0] << 8) ^ (data[1] << 4) ^ data[2]) & 0xffff;
+}
+
+static void freePNGStream(png_stream *png){
+	/**
+	 * \brief Frees the buffers of a PNG stream.
+	 *
+	 * \param[out] png 		the stream.
+	 */
+
+	free(png->row);
+	free(png->above);
+	free(png->window);
+	free(png->out);
+	free(png->head);
+	free(png->previous);
+	png->row = NULL;
+	png->above = NULL;
+	png->window = NULL;
+	png->out = NULL;
+	png->head = NULL;
+	png->previous = NULL;
+}
+
+static int writeChunk(FILE *file, char *type, unsigned char *data, size_t length){
+	/**
+	 * \brief Writes a PNG chunk with its length and checksum.
+	 *
+	 * \param[out] file 	the file being written.
+	 * \param[in] type 		the 4 letter chunk type.
+	 * \param[in] data 		the chunk data, may be NULL if length is 0.
+	 * \param[in] length 	number of bytes of data.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	unsigned char bytes[4];
+	unsigned long crc = crc32Bytes(0, (unsigned char*)type, 4);
+
+	if (length > 0)
+		crc = crc32Bytes(crc, data, length);
+
+	putBigEndian(bytes, length);
+	if (fwrite(bytes, 1, 4, file) != 4 || fwrite(type, 1, 4, file) != 4)
+		return 0;
+	if (length > 0 && fwrite(data, 1, length, file) != length)
+		return 0;
+
+	putBigEndian(bytes, crc);
+	return fwrite(bytes, 1, 4, file) == 4;
+}
+
+static unsigned long crc32Bytes(unsigned long crc, unsigned char *data, size_t length){
+	/**
+	 * \brief Updates a CRC-32 checksum with a block of bytes.
+	 *
+	 * The table is made on the stack each time, which is cheap next to the data it covers
+	 * and means the writer threads do not share anything.
+	 *
+	 * \param[in] crc 		the checksum so far, 0 to start.
+	 * \param[in] data 		the bytes to be added.
+	 * \param[in] length 	number of bytes.
+	 *
+	 * \return 				the new checksum.
+	 */
+
+	unsigned long table[256];
+	unsigned long value = 0;
+	size_t i = 0;
+	int bit = 0;
+
+	for (i = 0; i < 256; i++){
+		value = i;
+		for (bit = 0; bit < 8; bit++)
+			value = (value >> 1) ^ (0xedb88320UL & (0 - (value & 1)));
+		table[i] = value;
+	}
+
+	crc = ~crc & 0xffffffffUL;
+	for (i = 0; i < length; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return ~crc & 0xffffffffUL;
+}
+
+static void putBigEndian(unsigned char *data, unsigned long value){
+	/**
+	 * \brief Writes a 32 bit value to a byte array, highest byte first.
+	 *
+	 * \param[out] data 	at least 4 bytes.
+	 * \param[in] value 	the value to be written.
+	 */
+
+	data[0] = (value >> 24) & 0xff;
+	data[1] = (value >> 16) & 0xff;
+	data[2] = (value >> 8) & 0xff;
+	data[3] = value & 0xff;
+}
@@ -0,0 +1,72 @@
+#ifndef _ENCODE_H_
+#define _ENCODE_H_
+
+/** \brief PNG compressed with deflate, the default format for saves.*/
+#define IMAGE_PNG 0
+/** \brief The Quite OK Image format, very fast to write and read.*/
+#define IMAGE_QOI 1
+/** \brief Uncompressed 32 bit bmp, written by SDL_SaveBMP().*/
+#define IMAGE_BMP 2
+/** \brief PNG with the image data stored without compression, the fastest PNG to write.*/
+#define IMAGE_PNG_STORED 3
+/** \brief Vector image written from the line list by saveSVG() in svg.c rather than from pixels.*/
+#define IMAGE_SVG 4
+/** \brief Number of image formats.*/
+#define IMAGE_FORMATS 5
+
+/** \brief Number of bytes looked back through for repeated runs when compressing.*/
+#define DEFLATE_WINDOW 32768
+/** \brief Number of earlier positions tried for each match when compressing.*/
+#define DEFLATE_CHAIN 32
+/** \brief Number of bytes left uncompressed at the end of the window until more arrive, enough for the longest run.*/
+#define DEFLATE_LOOKAHEAD 262
+/** \brief Number of compressed bytes written in each PNG data chunk.*/
+#define PNG_CHUNK_BYTES 65536
+
+
+/*
+ * Saves an image in the given format.
+ */
+int saveImage(raster_image *image, char *name, int format);
+
+/*
+ * Writes an image to a file as an RGB PNG.
+ */
+int encodePNG(raster_image *image, FILE *file, int compress);
+
+/*
+ * Starts writing a PNG to a file that rows are then added to one at a time.
+ */
+int openPNGStream(png_stream *png, FILE *file, int width, int height, int compress);
+
+/*
+ * Adds the next row of pixels to a PNG stream.
+ */
+int writePNGRow(png_stream *png, Uint32 *pixels);
+
+/*
+ * Finishes a PNG stream and frees its buffers.
+ */
+int closePNGStream(png_stream *png);
+
+/*
+ * Writes an image to a file in the Quite OK Image format.
+ */
+int encodeQOI(raster_image *image, FILE *file);
+
+/*
+ * Returns the file extension used for an image format.
+ */
+char *imageExtension(int format);
+
+/*
+ * Returns a short name for an image format to show on buttons.
+ */
+char *imageFormatName(int format);
+
+/*
+ * Returns the image format named by a setting value or used by a file name, or -1 if there is none.
+ */
+int findImageFormat(char *name);
+
+#endif
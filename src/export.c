@@ -0,0 +1,358 @@
+/**
+ * \file export.c
+ *
+ * \brief A source file for exporting the creation of a fractal as a sequence of images
+ * in the background.
+ *
+ * A sequence used to be drawn on the window's renderer and read back one frame at a
+ * time, which held up the window until every frame had been saved, and moving the
+ * window while it ran spoiled the frames. Now the drawing screen is read back once,
+ * before any lines are drawn, and the rest is done away from the window. One thread
+ * draws the lines into its own image and, at the end of every frame, copies the image
+ * into a free slot and queues it. Writer threads take queued frames, write them to
+ * disk and free their slots. There are only EXPORT_SLOTS slots, so drawing waits for
+ * the writers when it gets too far ahead, while the next frame is drawn as the last
+ * one is being written. The drawing screen keeps responding and shows the progress.
+ *
+ * Anti-aliased lines are drawn into coverage levels rather than the image, and each
+ * frame is the first frame with the levels so far blended over it as it is copied.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+#include "encode.h"
+#include "trace.h"
+#include "export.h"
+
+
+/*
+ * Main loop of the thread drawing the frames.
+ */
+static int rasterThread(void *data);
+
+/*
+ * Main loop of each thread writing frames to disk.
+ */
+static int writerThread(void *data);
+
+/*
+ * Waits for the threads of the last export and frees its images and line list.
+ */
+static void finishExport(seq_exporter *exporter);
+
+
+int initExporter(seq_exporter *exporter){
+	/**
+	 * \brief Creates the lock and condition shared by the export threads.
+	 *
+	 * \param[out] exporter 	an exporter initialised with structInitSeqExporter().
+	 *
+	 * \return 					1 if sucessfull, 0 if the lock could not be created.
+	 */
+
+	exporter->lock = SDL_CreateMutex();
+	exporter->changed = SDL_CreateCond();
+	if (exporter->lock == NULL || exporter->changed == NULL){
+		printf("Could not create export lock: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	return 1;
+}
+
+void stopExporter(seq_exporter *exporter){
+	/**
+	 * \brief Stops any export, waits for its threads and frees the lock.
+	 *
+	 * Frames that have been drawn but not written are dropped.
+	 *
+	 * \param[out] exporter 	the exporter to be stopped.
+	 */
+
+	SDL_LockMutex(exporter->lock);
+	exporter->cancel = 1;
+	SDL_CondBroadcast(exporter->changed);
+	SDL_UnlockMutex(exporter->lock);
+
+	finishExport(exporter);
+
+	SDL_DestroyCond(exporter->changed);
+	SDL_DestroyMutex(exporter->lock);
+	exporter->changed = NULL;
+	exporter->lock = NULL;
+}
+
+int startSequenceExport(seq_exporter *exporter, raster_image *base, line *line_list, int line_list_length, SDL_Colour ln_colour, int x_offset, int format, int antialias){
+	/**
+	 * \brief Starts exporting the creation of a fractal as a sequence of images in the background.
+	 *
+	 * The lines are drawn one after another on top of the base image, and a frame is saved every
+	 * line_list_length/EXPORT_MAX_FRAMES+1 lines and after the last line, as the sequence has
+	 * always been. The line list is copied, so the fractal on screen can change while the export
+	 * runs. Only one export runs at a time.
+	 *
+	 * \param[out] exporter 		the exporter.
+	 * \param[out] base 			the first frame (the background and anything drawn over it), owned by the exporter once started.
+	 * \param[in] line_list 		the lines to be drawn, placed as on the drawing screen.
+	 * \param[in] line_list_length 	the number of lines.
+	 * \param[in] ln_colour 		colour for the lines.
+	 * \param[in] x_offset 			x position of the left edge of the base image on the drawing screen.
+	 * \param[in] format 			format the frames are saved in, one of the IMAGE_ values.
+	 * \param[in] antialias 		true to draw anti-aliased lines.
+	 *
+	 * \return 						1 if the export was started, 0 if one is running or it could not be started.
+	 */
+
+	time_t current_time = time(NULL);
+	int step = line_list_length/EXPORT_MAX_FRAMES + 1;
+	int i = 0;
+
+	if (exportBusy(exporter) || line_list_length < 1)
+		return 0;
+	finishExport(exporter);
+
+	//copying the lines, moved so that they line up with the base image
+	exporter->line_list = (line*)malloc(line_list_length*sizeof(line));
+	if (exporter->line_list == NULL){
+		printf("export line list memory allocation failed\n");
+		return 0;
+	}
+	for (i = 0; i < line_list_length; i++){
+		exporter->line_list[i] = line_list[i];
+		exporter->line_list[i].start.x_pos -= x_offset;
+		exporter->line_list[i].end.x_pos -= x_offset;
+	}
+
+	//setting up the coverage levels anti-aliased lines are drawn into
+	if (antialias){
+		exporter->levels = (Uint8*)calloc((size_t)base->width*base->height, sizeof(Uint8));
+		if (exporter->levels == NULL){
+			printf("export coverage memory allocation failed\n");
+			finishExport(exporter);
+			return 0;
+		}
+	}
+
+	//setting up the slots frames are copied into
+	for (i = 0; i < EXPORT_SLOTS; i++){
+		if (!initRaster(&(exporter->slots[i]), base->width, base->height)){
+			finishExport(exporter);
+			return 0;
+		}
+		exporter->free_slots[i] = i;
+	}
+
+	exporter->line_list_length = line_list_length;
+	exporter->ln_colour = ln_colour;
+	exporter->format = format;
+	exporter->frame = *base;
+	structInitRasterImage(base);
+	exporter->free_count = EXPORT_SLOTS;
+	exporter->queue_head = 0;
+	exporter->queue_count = 0;
+	exporter->raster_done = 0;
+	exporter->cancel = 0;
+	exporter->frame_count = (line_list_length-1)/step + 1 + ((line_list_length-1) % step != 0);
+	SDL_AtomicSet(&(exporter->frames_written), 0);
+	SDL_AtomicSet(&(exporter->busy), 1);
+	strcpy(exporter->base_time, ctime(&current_time));
+
+	//starting the writers before the thread that feeds them
+	exporter->writers_running = 0;
+	for (i = 0; i < EXPORT_WRITERS; i++){
+		exporter->writers[i] = SDL_CreateThread(writerThread, "export writer", exporter);
+		if (exporter->writers[i] != NULL)
+			exporter->writers_running++;
+	}
+	if (exporter->writers_running > 0)
+		exporter->raster_thread = SDL_CreateThread(rasterThread, "export raster", exporter);
+
+	if (exporter->raster_thread == NULL){
+		printf("Could not start export threads: %s\n", SDL_GetError());
+		SDL_LockMutex(exporter->lock);
+		exporter->cancel = 1;
+		SDL_CondBroadcast(exporter->changed);
+		SDL_UnlockMutex(exporter->lock);
+		finishExport(exporter);
+		SDL_AtomicSet(&(exporter->busy), 0);
+		return 0;
+	}
+
+	printf("exporting %d frames\n", exporter->frame_count);
+	return 1;
+}
+
+int exportBusy(seq_exporter *exporter){
+	/**
+	 * \brief Returns true while a sequence is being exported.
+	 *
+	 * \param[in] exporter 		the exporter being checked.
+	 */
+
+	return SDL_AtomicGet(&(exporter->busy));
+}
+
+int exportProgress(seq_exporter *exporter){
+	/**
+	 * \brief Returns the percentage of frames written to disk.
+	 *
+	 * \param[in] exporter 		the exporter being checked.
+	 */
+
+	if (exporter->frame_count < 1)
+		return 0;
+
+	return 100*SDL_AtomicGet(&(exporter->frames_written))/exporter->frame_count;
+}
+
+static int rasterThread(void *data){
+	/**
+	 * \brief Draws the lines one after another, queueing a copy of the image at the end of every frame.
+	 *
+	 * \param[in] data 		the seq_exporter that owns the thread.
+	 *
+	 * \return 				0 when every frame has been queued or the export is stopped.
+	 */
+
+	seq_exporter *exporter = (seq_exporter*)data;
+	Uint32 pixel = rasterColour(exporter->ln_colour);
+	int step = exporter->line_list_length/EXPORT_MAX_FRAMES + 1;
+	int frame_number = 1;
+	int slot = 0;
+	int i = 0;
+
+	for (i = 0; i < exporter->line_list_length; i++){
+		if (exporter->levels != NULL)
+			rasterLineAA(&(exporter->frame), exporter->levels, exporter->line_list[i].start, exporter->line_list[i].end);
+		else
+			rasterLine(&(exporter->frame), exporter->line_list[i].start, exporter->line_list[i].end, pixel);
+
+		if (i % step != 0 && i != exporter->line_list_length-1)
+			continue;
+
+		//waiting for a free slot
+		SDL_LockMutex(exporter->lock);
+		while (exporter->free_count == 0 && !exporter->cancel)
+			SDL_CondWait(exporter->changed, exporter->lock);
+		if (exporter->cancel){
+			SDL_UnlockMutex(exporter->lock);
+			break;
+		}
+		slot = exporter->free_slots[--(exporter->free_count)];
+		SDL_UnlockMutex(exporter->lock);
+
+		//copying the frame while the writers carry on with earlier ones
+		memcpy(exporter->slots[slot].pixels, exporter->frame.pixels, (size_t)exporter->frame.width*exporter->frame.height*sizeof(Uint32));
+		if (exporter->levels != NULL)
+			blendCoverage(&(exporter->slots[slot]), exporter->levels, pixel);
+		sprintf(exporter->slot_names[slot], "saves/fractal_seq_%s_%03d.%s", exporter->base_time, frame_number++, imageExtension(exporter->format));
+
+		SDL_LockMutex(exporter->lock);
+		exporter->queue[(exporter->queue_head + exporter->queue_count) % EXPORT_SLOTS] = slot;
+		exporter->queue_count++;
+		SDL_CondBroadcast(exporter->changed);
+		SDL_UnlockMutex(exporter->lock);
+	}
+
+	SDL_LockMutex(exporter->lock);
+	exporter->raster_done = 1;
+	SDL_CondBroadcast(exporter->changed);
+	SDL_UnlockMutex(exporter->lock);
+
+	return 0;
+}
+
+static int writerThread(void *data){
+	/**
+	 * \brief Writes queued frames to disk until every frame is written or the export is stopped.
+	 *
+	 * The last writer to exit marks the export as finished and wakes up the main loop so the
+	 * finished progress is shown.
+	 *
+	 * \param[in] data 		the seq_exporter that owns the thread.
+	 *
+	 * \return 				0 when the thread exits.
+	 */
+
+	seq_exporter *exporter = (seq_exporter*)data;
+	SDL_Event wake_event;
+	int slot = 0;
+	int written = 0;
+	Uint64 trace_begin = 0;
+
+	while (1){
+		//waiting for a queued frame
+		SDL_LockMutex(exporter->lock);
+		while (exporter->queue_count == 0 && !exporter->raster_done && !exporter->cancel)
+			SDL_CondWait(exporter->changed, exporter->lock);
+		if (exporter->cancel || exporter->queue_count == 0){
+			SDL_UnlockMutex(exporter->lock);
+			break;
+		}
+		slot = exporter->queue[exporter->queue_head];
+		exporter->queue_head = (exporter->queue_head + 1) % EXPORT_SLOTS;
+		exporter->queue_count--;
+		SDL_UnlockMutex(exporter->lock);
+
+		trace_begin = traceBegin(exporter->trace);
+		saveImage(&(exporter->slots[slot]), exporter->slot_names[slot], exporter->format);
+		traceEnd(exporter->trace, "saveImage", trace_begin);
+
+		//giving the slot back
+		SDL_LockMutex(exporter->lock);
+		exporter->free_slots[exporter->free_count++] = slot;
+		SDL_CondBroadcast(exporter->changed);
+		SDL_UnlockMutex(exporter->lock);
+
+		written = SDL_AtomicAdd(&(exporter->frames_written), 1) + 1;
+		printf("%d of %d frames saved.\n", written, exporter->frame_count);
+	}
+
+	SDL_LockMutex(exporter->lock);
+	exporter->writers_running--;
+	if (exporter->writers_running == 0){
+		SDL_AtomicSet(&(exporter->busy), 0);
+		memset(&wake_event, 0, sizeof(wake_event));
+		wake_event.type = SDL_USEREVENT;
+		SDL_PushEvent(&wake_event);
+	}
+	SDL_UnlockMutex(exporter->lock);
+
+	return 0;
+}
+
+static void finishExport(seq_exporter *exporter){
+	/**
+	 * \brief Waits for the threads of the last export and frees its images and line list.
+	 *
+	 * \param[out] exporter 	the exporter.
+	 */
+
+	int i = 0;
+
+	if (exporter->raster_thread != NULL)
+		SDL_WaitThread(exporter->raster_thread, NULL);
+	exporter->raster_thread = NULL;
+
+	for (i = 0; i < EXPORT_WRITERS; i++){
+		if (exporter->writers[i] != NULL)
+			SDL_WaitThread(exporter->writers[i], NULL);
+		exporter->writers[i] = NULL;
+	}
+
+	for (i = 0; i < EXPORT_SLOTS; i++)
+		freeRaster(&(exporter->slots[i]));
+	freeRaster(&(exporter->frame));
+	free(exporter->levels);
+	exporter->levels = NULL;
+	free(exporter->line_list);
+	exporter->line_list = NULL;
+	exporter->line_list_length = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef _EXPORT_H_
+#define _EXPORT_H_
+
+/** \brief Largest number of frames in a sequence, not counting the final frame.*/
+#define EXPORT_MAX_FRAMES 200
+
+
+/*
+ * Creates the lock and condition shared by the export threads.
+ */
+int initExporter(seq_exporter *exporter);
+
+/*
+ * Stops any export, waits for its threads and frees the lock.
+ */
+void stopExporter(seq_exporter *exporter);
+
+/*
+ * Starts exporting the creation of a fractal as a sequence of images in the background.
+ */
+int startSequenceExport(seq_exporter *exporter, raster_image *base, line *line_list, int line_list_length, SDL_Colour ln_colour, int x_offset, int format, int antialias);
+
+/*
+ * Returns true while a sequence is being exported.
+ */
+int exportBusy(seq_exporter *exporter);
+
+/*
+ * Returns the percentage of frames written to disk.
+ */
+int exportProgress(seq_exporter *exporter);
+
+#endif
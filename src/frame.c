@@ -0,0 +1,147 @@
+/**
+ * \file frame.c
+ *
+ * \brief A source file for deciding which events need the window redrawn, and for measuring
+ * how long input takes to reach the screen.
+ *
+ * The main loop takes every waiting event before drawing anything, so a burst of mouse motion
+ * or window events costs one frame at most, and events that change nothing on the screen cost
+ * none. Only clicks change the screens, along with the window being uncovered or resized and
+ * the renderer being reset, and mouse motion while a setting is being dragged, which the main
+ * loop checks for itself.
+ *
+ * The latency of a frame is measured from the timestamp of the earliest click it shows to just
+ * after it is presented, which with vsync on includes waiting for the display. The time taken
+ * to draw and present the last frame is kept too, for the timings shown in the info overlay.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "timing.h"
+#include "frame.h"
+
+
+int noteEvent(frame_stats *stats, SDL_Event *event){
+	/**
+	 * \brief Counts an event, noting when input arrives, and returns true if it changes what is on the screen.
+	 *
+	 * \param[out] stats 	frame stats of the main loop.
+	 * \param[in] event 	the event.
+	 *
+	 * \return 				1 if the screen needs to be drawn again, 0 if not.
+	 */
+
+	stats->events++;
+
+	switch (event->type){
+		case SDL_MOUSEBUTTONDOWN:
+			noteInput(stats, event->button.timestamp);
+			return 1;
+
+		case SDL_WINDOWEVENT:
+			switch (event->window.event){
+				case SDL_WINDOWEVENT_SHOWN:
+				case SDL_WINDOWEVENT_EXPOSED:
+				case SDL_WINDOWEVENT_RESIZED:
+				case SDL_WINDOWEVENT_SIZE_CHANGED:
+				case SDL_WINDOWEVENT_RESTORED:
+				case SDL_WINDOWEVENT_MAXIMIZED:
+					return 1;
+			}
+			return 0;
+
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			return 1;
+	}
+
+	return 0;
+}
+
+void noteInput(frame_stats *stats, Uint32 timestamp){
+	/**
+	 * \brief Notes input that changes the screen, so the latency of the frame that shows it is measured.
+	 *
+	 * Clicks are noted by noteEvent(). Other input, like dragging a setting, is only noted by
+	 * the main loop when it changes something.
+	 *
+	 * \param[out] stats 	frame stats of the main loop.
+	 * \param[in] timestamp 	timestamp of the input's event in milliseconds.
+	 */
+
+	if (!stats->input_pending || timestamp < stats->input_time)
+		stats->input_time = timestamp;
+	stats->input_pending = 1;
+}
+
+void notePresent(frame_stats *stats){
+	/**
+	 * \brief Counts a presented frame, logging how long the input it shows took to reach the screen.
+	 *
+	 * Must be called just after SDL_RenderPresent().
+	 *
+	 * \param[out] stats 	frame stats of the main loop.
+	 */
+
+	Uint32 latency = 0;
+
+	stats->frames++;
+	if (!stats->input_pending)
+		return;
+
+	latency = SDL_GetTicks() - stats->input_time;
+	stats->input_pending = 0;
+	stats->latency_count++;
+	stats->latency_total += latency;
+	if (latency > stats->latency_max)
+		stats->latency_max = latency;
+
+	printf("input to present latency: %u ms\n", (unsigned)latency);
+}
+
+void startFrame(frame_stats *stats){
+	/**
+	 * \brief Notes that drawing a frame has started, so the time until it is presented can be measured.
+	 *
+	 * \param[out] stats 	frame stats of the main loop.
+	 */
+
+	stats->stages.frame_start = SDL_GetPerformanceCounter();
+}
+
+void presentFrame(SDL_Renderer *renderer, frame_stats *stats){
+	/**
+	 * \brief Presents the renderer, timing the present and the whole frame, and counts the frame.
+	 *
+	 * The times are shown in the info overlay of the next frame drawn, so they are always one
+	 * frame behind.
+	 *
+	 * \param[out] renderer 	renderer the frame has been drawn to.
+	 * \param[out] stats 		frame stats of the main loop, after startFrame() was called for this frame.
+	 */
+
+	Uint64 present_start = SDL_GetPerformanceCounter();
+
+	SDL_RenderPresent(renderer);
+
+	stats->stages.present_time = millisecondsSince(present_start);
+	stats->stages.frame_time = millisecondsSince(stats->stages.frame_start);
+	notePresent(stats);
+}
+
+void printFrameStats(frame_stats *stats){
+	/**
+	 * \brief Prints the number of frames and events and the mean and longest input to present latency.
+	 *
+	 * \param[in] stats 	frame stats of the main loop.
+	 */
+
+	printf("frames: %d presented for %d events", stats->frames, stats->events);
+	if (stats->latency_count > 0)
+		printf(", input to present latency %.1f ms mean, %u ms longest", stats->latency_total/stats->latency_count, (unsigned)stats->latency_max);
+	printf("\n");
+}
@@ -0,0 +1,40 @@
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+/** \brief Stage time of a stage that did not need to run, like the rewrite when only the line length changed.*/
+#define STAGE_SKIPPED -1
+/** \brief Stage time of a stage whose result was taken from the geometry cache.*/
+#define STAGE_CACHED -2
+
+
+/*
+ * Counts an event, noting when input arrives, and returns true if it changes what is on the screen.
+ */
+int noteEvent(frame_stats *stats, SDL_Event *event);
+
+/*
+ * Notes input that changes the screen, so the latency of the frame that shows it is measured.
+ */
+void noteInput(frame_stats *stats, Uint32 timestamp);
+
+/*
+ * Counts a presented frame, logging how long the input it shows took to reach the screen.
+ */
+void notePresent(frame_stats *stats);
+
+/*
+ * Notes that drawing a frame has started, so the time until it is presented can be measured.
+ */
+void startFrame(frame_stats *stats);
+
+/*
+ * Presents the renderer, timing the present and the whole frame, and counts the frame.
+ */
+void presentFrame(SDL_Renderer *renderer, frame_stats *stats);
+
+/*
+ * Prints the number of frames and events and the mean and longest input to present latency.
+ */
+void printFrameStats(frame_stats *stats);
+
+#endif
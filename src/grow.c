@@ -0,0 +1,236 @@
+/**
+ * \file grow.c
+ *
+ * \brief A source file for writing videos of a fractal growing from its axiom to its full
+ * depth.
+ *
+ * makeString() makes each generation of the string from the one before, so every depth up
+ * to the full one is made on the way to it anyway. A growth video follows the same loop,
+ * starting from the axiom with startString() and calling iteration() once for each level,
+ * and runs the turtle over each generation as soon as it is made, so no depth is made again
+ * from the axiom. Each level's line list is drawn into an image, fitted to the frame on its
+ * own, and freed before the next generation is made.
+ *
+ * Each level is shown for grow frames, fading from the image of one level to the image of
+ * the next, and the last frame holds the fractal at its full depth. The fade only blends the
+ * two images, so the lines of each level are drawn once however many frames there are.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "raster.h"
+#include "video.h"
+#include "headless.h"
+#include "timing.h"
+#include "grow.h"
+
+
+/*
+ * Runs the turtle over the lsystem's current string and draws the lines into an image, fitted to the image.
+ */
+static int drawGrowthLevel(render_job *job, lsystem *lsys, raster_image *image, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+/*
+ * Fills an image with a blend of two others of the same size.
+ */
+static void blendImages(raster_image *image, raster_image *from, raster_image *to, int weight);
+
+
+size_t growthBytes(render_job *job){
+	/**
+	 * \brief Returns the number of bytes drawing a growth video is expected to hold, not counting the strings or the line list.
+	 *
+	 * That is the images of the level being faded from, the level being faded to and the frame
+	 * being written, and a coverage level for each pixel with anti-aliased lines.
+	 *
+	 * \param[in] job 		the job.
+	 *
+	 * \return 				the number of bytes.
+	 */
+
+	size_t pixels = (size_t)job->width*job->height;
+
+	return 3*pixels*sizeof(Uint32) + (job->antialias ? pixels : 0);
+}
+
+int renderGrowth(render_job *job, lsystem *lsys, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Draws a video of the fractal growing from its axiom to its full depth, running the turtle over each generation as it is made.
+	 *
+	 * The video has job->grow frames for each level from a depth of 0 up to the lsystem's
+	 * iterations, and one more for the full depth. The job is given its rewrite, turtle, raster
+	 * and encode times and the number of lines at the full depth.
+	 *
+	 * \param[out] job 			the job, with a video format and the number of frames for each level.
+	 * \param[out] lsys 		copy of the job's lsystem with no string, which is left with none.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] ln_colour 	colour for the lines.
+	 *
+	 * \return 					1 if every frame was written, 0 if not.
+	 */
+
+	raster_image images[2];
+	raster_image frame;
+	raster_image swap;
+	video_stream video;
+	int depth = 0;
+	int step = 0;
+	int written = 1;
+	Uint64 start_time = 0;
+
+	structInitRasterImage(&(images[0]));
+	structInitRasterImage(&(images[1]));
+	structInitRasterImage(&frame);
+	structInitVideoStream(&video);
+
+	if (!initRaster(&(images[0]), job->width, job->height) || !initRaster(&(images[1]), job->width, job->height) || !initRaster(&frame, job->width, job->height)){
+		fprintf(stderr, "%s: growth memory allocation failed\n", job->out);
+		written = 0;
+	}
+	if (written && !openVideo(&video, job->out, job->video_format, job->width, job->height, job->fps))
+		written = 0;
+
+	//drawing the axiom as the first level
+	start_time = SDL_GetPerformanceCounter();
+	if (written && !startString(lsys))
+		written = 0;
+	job->rewrite_time += secondsSince(start_time);
+	if (written)
+		written = drawGrowthLevel(job, lsys, &(images[0]), bg_colour, ln_colour);
+
+	for (depth = 1; written && depth <= lsys->iterations; depth++){
+
+		//making the next generation from the last
+		start_time = SDL_GetPerformanceCounter();
+		written = iteration(lsys);
+		job->rewrite_time += secondsSince(start_time);
+
+		if (written)
+			written = drawGrowthLevel(job, lsys, &(images[1]), bg_colour, ln_colour);
+
+		//fading from the last level to the next, starting with the last level on its own
+		for (step = 0; written && step < job->grow; step++){
+			start_time = SDL_GetPerformanceCounter();
+			if (step > 0)
+				blendImages(&frame, &(images[0]), &(images[1]), 256*step/job->grow);
+			job->raster_time += secondsSince(start_time);
+
+			start_time = SDL_GetPerformanceCounter();
+			written = writeVideoFrame(&video, step > 0 ? &frame : &(images[0]));
+			job->encode_time += secondsSince(start_time);
+		}
+
+		swap = images[0];
+		images[0] = images[1];
+		images[1] = swap;
+	}
+
+	//holding the full depth for the last frame
+	if (written){
+		start_time = SDL_GetPerformanceCounter();
+		written = writeVideoFrame(&video, &(images[0]));
+		job->encode_time += secondsSince(start_time);
+	}
+
+	if (video.file != NULL && !closeVideo(&video))
+		written = 0;
+	if (!written)
+		fprintf(stderr, "%s: could not write every frame\n", job->out);
+
+	free(lsys->string);
+	lsys->string = NULL;
+	freeRaster(&(images[0]));
+	freeRaster(&(images[1]));
+	freeRaster(&frame);
+
+	return written;
+}
+
+static int drawGrowthLevel(render_job *job, lsystem *lsys, raster_image *image, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Runs the turtle over the lsystem's current string and draws the lines into an image, fitted to the image.
+	 *
+	 * The line list is made with a line length of 1 from (0, 0) and freed once drawn. A level
+	 * with no lines, like an axiom with no movement characters, is left as the background.
+	 *
+	 * \param[out] job 			the job, which is given the number of lines and the time spent.
+	 * \param[out] lsys 		lsystem holding the string.
+	 * \param[out] image 		the image, the size of the job.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] ln_colour 	colour for the lines.
+	 *
+	 * \return 					1 if sucessfull, 0 if memory allocation failed.
+	 */
+
+	double scale = 1;
+	coordinate offset;
+	Uint64 start_time = SDL_GetPerformanceCounter();
+
+	structInitCoord(&offset);
+
+	job->segments = lsys->line_list_length = stringToTurtle(lsys);
+	if (lsys->line_list == NULL && countMoves(lsys->string) > 0){
+		fprintf(stderr, "%s: could not make the line list\n", job->out);
+		return 0;
+	}
+	if (lsys->line_list == NULL)
+		job->segments = lsys->line_list_length = 0;
+	job->turtle_time += secondsSince(start_time);
+
+	start_time = SDL_GetPerformanceCounter();
+	fitLines(lsys->line_list, job->segments, job->width, job->height, RENDER_MARGIN, &scale, &offset);
+	clearRaster(image, bg_colour);
+	rasterFractal(image, lsys->line_list, job->segments, scale, offset, ln_colour, job->antialias);
+	free(lsys->line_list);
+	lsys->line_list = NULL;
+	job->raster_time += secondsSince(start_time);
+
+	return 1;
+}
+
+static void blendImages(raster_image *image, raster_image *from, raster_image *to, int weight){
+	/**
+	 * \brief Fills an image with a blend of two others of the same size.
+	 *
+	 * Each of the four channels of every pixel is blended on its own, so the blend does not
+	 * depend on the order of the channels.
+	 *
+	 * \param[out] image 	the image to be filled.
+	 * \param[in] from 		the image at a weight of 0.
+	 * \param[in] to 		the image at a weight of 256.
+	 * \param[in] weight 	how far to blend from one image to the other, from 0 to 256.
+	 */
+
+	size_t count = (size_t)image->width*image->height;
+	Uint32 first = 0;
+	Uint32 second = 0;
+	Uint32 blended = 0;
+	size_t i = 0;
+	int shift = 0;
+	int a = 0;
+	int b = 0;
+
+	for (i = 0; i < count; i++){
+		first = from->pixels[i];
+		second = to->pixels[i];
+		if (first == second){
+			image->pixels[i] = first;
+			continue;
+		}
+
+		blended = 0;
+		for (shift = 0; shift < 32; shift += 8){
+			a = (first >> shift) & 0xff;
+			b = (second >> shift) & 0xff;
+			blended |= (Uint32)((a*(256 - weight) + b*weight + 128) >> 8) << shift;
+		}
+		image->pixels[i] = blended;
+	}
+}
@@ -0,0 +1,15 @@
+#ifndef _GROW_H_
+#define _GROW_H_
+
+
+/*
+ * Returns the number of bytes drawing a growth video is expected to hold, not counting the strings or the line list.
+ */
+size_t growthBytes(render_job *job);
+
+/*
+ * Draws a video of the fractal growing from its axiom to its full depth, running the turtle over each generation as it is made.
+ */
+int renderGrowth(render_job *job, lsystem *lsys, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+#endif
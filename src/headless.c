@@ -0,0 +1,713 @@
+/**
+ * \file headless.c
+ *
+ * \brief A source file for the headless renderer, which draws fractals to image files
+ * without opening a window so that it can be run where there is no display.
+ *
+ * The renderer is started with one or more jobs on the command line, each made up of
+ * --render followed by any of these settings:
+ *
+ *     drawsystem --render preset=dragon depth=16 size=4096x4096 out=dragon.bmp
+ *
+ * preset is the short name of a pre defined rule set, depth is the fractal depth (the
+ * rule set's default if left out), angle is the turning angle in degrees, size is the
+ * image size (1000x800 if left out) and out is the file name (saves/<preset>_d<depth>.png
+ * if left out). Instead of a preset, an axiom can be given with axiom= and rules with
+ * rule_A=, rule_B=, rule_F=, rule_f=, rule_X=, rule_Y=, rule_plus=, rule_minus=,
+ * rule_store= and rule_pop=. Settings are applied in order, so a preset should come
+ * before anything that changes it.
+ *
+ * Images are saved in the format given by format=png, png-stored, qoi or bmp, or else
+ * the format matching the extension of out, or else as PNG. With format=svg the lines
+ * are written straight to an svg file instead of being drawn, with coordinates rounded
+ * to precision= decimal places (1 if left out).
+ *
+ * Images too large to hold, or any image given tile=N, are drawn as posters in tiles of
+ * NxN pixels (see poster.c) and streamed to a PNG file a row of tiles at a time:
+ *
+ *     drawsystem --render preset=dragon depth=24 size=20000x20000 out=dragon.png
+ *
+ * With mode=density, the image shows how many lines pass through each pixel (see
+ * density.c), scaled with tone=log (the default) or tone=gamma with gamma=G, and
+ * coloured with palette=mono, fire, ice or viridis.
+ *
+ * With antialias=on, lines are drawn anti-aliased (see rasterLineAA() in raster.c) in
+ * images, posters and videos alike.
+ *
+ * Neither the video subsystem nor SDL_ttf is initialised. The string and line list are
+ * made with the same makeString() and stringToTurtle() functions as the drawing screen,
+ * or mapped in from the geometry store if an earlier run made them, and are fitted to
+ * the image and drawn on the CPU. The wall time and peak memory use are printed after
+ * each job. Many jobs can be read from a file and run in parallel with --jobs, see
+ * batch.c.
+ *
+ * With video=y4m or video=rgb, a job writes a video of the fractal being drawn instead
+ * of an image, adding lines_per_frame lines in each frame, or enough lines to make
+ * frames frames (RENDER_DEFAULT_FRAMES if neither is given). With out=- the video is
+ * written to stdout, ready to be piped into an encoder:
+ *
+ *     drawsystem --render preset=dragon depth=16 video=y4m lines_per_frame=64 out=- | ffmpeg -i - dragon.mp4
+ *
+ * With sweep=angle:FROM:TO or sweep=length:FROM:TO, a job instead writes a video of the
+ * whole fractal over frames frames while its angle in degrees, or its line length, moves
+ * from FROM to TO (see sweep.c). The frames are drawn by threads= threads, one for each CPU
+ * core if left out, and the video format is y4m unless video= says otherwise:
+ *
+ *     drawsystem --render preset=plant2 depth=6 sweep=angle:20:30 frames=120 out=plant.y4m
+ *
+ * Any other job given threads=N with N above 1 makes its line list in N shares at once with
+ * the seek table (see seek.c), without making the string. Such a line list is not written
+ * to the geometry store, as a stored file holds the string too.
+ *
+ * With grow=N, a job writes a video of the fractal growing from its axiom to its depth,
+ * N frames for each level, fading from each level to the next (see grow.c). Like a sweep,
+ * the video format is y4m unless video= says otherwise.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "seek.h"
+#include "cache.h"
+#include "store.h"
+#include "raster.h"
+#include "video.h"
+#include "encode.h"
+#include "svg.h"
+#include "poster.h"
+#include "density.h"
+#include "sweep.h"
+#include "grow.h"
+#include "trace.h"
+#include "batch.h"
+#include "timing.h"
+#include "headless.h"
+
+
+/*
+ * Writes a video of the fractal being drawn, adding a run of lines in each frame.
+ */
+static int renderSequence(render_job *job, raster_image *image, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour line_colour);
+
+/*
+ * Draws how many lines pass through each pixel of an image, coloured from the job's palette.
+ */
+static int drawDensity(render_job *job, raster_image *image, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+/*
+ * Returns the rule of a render job's lsystem named by a setting key, or NULL if there is none.
+ */
+static char *ruleForKey(lsystem *lsys, char *key);
+
+/*
+ * Prints how the headless renderer is used.
+ */
+static void printUsage();
+
+
+int headlessRequested(int argc, char *argv[]){
+	/**
+	 * \brief Returns true if the command line asks for the headless renderer.
+	 *
+	 * \param[in] argc 		number of command line arguments.
+	 * \param[in] argv 		the command line arguments.
+	 */
+
+	return argc > 1 && (strcmp(argv[1], "--render") == 0 || strcmp(argv[1], "--jobs") == 0);
+}
+
+int runHeadless(int argc, char *argv[], trace_log *trace){
+	/**
+	 * \brief Runs every render job given on the command line without opening a window.
+	 *
+	 * Each --render starts a new job, and the settings after it up to the next --render belong
+	 * to that job. All of the jobs are read before any are run, so a mistake anywhere on the
+	 * command line is reported before any time is spent. A command line starting with --jobs
+	 * is handed to the batch runner instead.
+	 *
+	 * \param[in] argc 		number of command line arguments.
+	 * \param[in] argv 		the command line arguments.
+	 * \param[out] trace 	trace log the stages of every job are recorded in, NULL when not tracing.
+	 *
+	 * \return 				0 if every image was saved, 1 if not.
+	 */
+
+	render_job *jobs = NULL;
+	int job_count = 0;
+	int failed = 0;
+	int i = 0;
+
+	if (strcmp(argv[1], "--jobs") == 0)
+		return runBatch(argc, argv, trace);
+
+	jobs = (render_job*)malloc(argc*sizeof(render_job));
+	if (jobs == NULL){
+		printf("render job memory allocation failed\n");
+		return 1;
+	}
+
+	//reading the jobs
+	for (i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--render") == 0){
+			if (job_count > 0 && !finishRenderJob(&(jobs[job_count-1])))
+				break;
+			structInitRenderJob(&(jobs[job_count]));
+			job_count++;
+		}
+		else if (job_count == 0 || !parseRenderSetting(&(jobs[job_count-1]), argv[i])){
+			printf("Unknown render setting: %s\n", argv[i]);
+			break;
+		}
+	}
+
+	if (i < argc || job_count == 0 || !finishRenderJob(&(jobs[job_count-1]))){
+		printUsage();
+		free(jobs);
+		return 1;
+	}
+
+	//running them one after another
+	for (i = 0; i < job_count; i++){
+		jobs[i].lsys.trace = trace;
+		renderJob(&(jobs[i]));
+		printRenderJob(&(jobs[i]));
+		if (!jobs[i].saved)
+			failed = 1;
+	}
+
+	free(jobs);
+	return failed;
+}
+
+int parseRenderSetting(render_job *job, char *setting){
+	/**
+	 * \brief Reads one setting of the form key=value into a render job.
+	 *
+	 * A preset replaces the whole lsystem, so it should come before any other setting that
+	 * changes the lsystem. An axiom or rule given without a preset starts from an lsystem where
+	 * every character is replaced by itself.
+	 *
+	 * \param[out] job 		the job the setting belongs to.
+	 * \param[in] setting 	the command line argument or word from a job file.
+	 *
+	 * \return 				1 if the setting was understood, 0 if not.
+	 */
+
+	char key[40];
+	char name[16];
+	char *value = strchr(setting, '=');
+	char *rule = NULL;
+	int preset = 0;
+
+	if (value == NULL || value - setting >= (int)sizeof(key))
+		return 0;
+	strncpy(key, setting, value - setting);
+	key[value - setting] = '\0';
+	value++;
+
+	if (strcmp(key, "preset") == 0){
+		preset = findPreset(value);
+		if (preset < 0)
+			return 0;
+		loadPreset(&(job->lsys), preset);
+		strcpy(job->label, presetKey(preset));
+		return 1;
+	}
+	if (strcmp(key, "depth") == 0){
+		job->lsys.iterations = atoi(value);
+		return job->lsys.iterations > 0;
+	}
+	if (strcmp(key, "angle") == 0){
+		job->lsys.angle = dtor(atof(value));
+		return 1;
+	}
+	if (strcmp(key, "size") == 0)
+		return sscanf(value, "%dx%d", &(job->width), &(job->height)) == 2 && job->width > 0 && job->height > 0;
+	if (strcmp(key, "out") == 0 && strlen(value) < sizeof(job->out)){
+		strcpy(job->out, value);
+		return 1;
+	}
+	if (strcmp(key, "format") == 0){
+		job->image_format = findImageFormat(value);
+		return job->image_format >= 0;
+	}
+	if (strcmp(key, "tile") == 0){
+		job->tile_size = atoi(value);
+		return job->tile_size > 0;
+	}
+	if (strcmp(key, "mode") == 0){
+		job->density = strcmp(value, "density") == 0;
+		return job->density || strcmp(value, "lines") == 0;
+	}
+	if (strcmp(key, "tone") == 0){
+		job->tone = strcmp(value, "gamma") == 0 ? DENSITY_GAMMA : DENSITY_LOG;
+		return job->tone == DENSITY_GAMMA || strcmp(value, "log") == 0;
+	}
+	if (strcmp(key, "gamma") == 0){
+		job->gamma = atof(value);
+		return job->gamma > 0;
+	}
+	if (strcmp(key, "palette") == 0){
+		job->palette = findPalette(value);
+		return job->palette >= 0;
+	}
+	if (strcmp(key, "antialias") == 0){
+		job->antialias = strcmp(value, "on") == 0;
+		return job->antialias || strcmp(value, "off") == 0;
+	}
+	if (strcmp(key, "precision") == 0){
+		job->precision = atoi(value);
+		return job->precision >= 0 && job->precision <= SVG_MAX_PRECISION;
+	}
+	if (strcmp(key, "video") == 0){
+		job->video_format = findVideoFormat(value);
+		return job->video_format != 0;
+	}
+	if (strcmp(key, "frames") == 0){
+		job->frames = atoi(value);
+		return job->frames > 0;
+	}
+	if (strcmp(key, "lines_per_frame") == 0){
+		job->lines_per_frame = atoi(value);
+		return job->lines_per_frame > 0;
+	}
+	if (strcmp(key, "fps") == 0){
+		job->fps = atoi(value);
+		return job->fps > 0;
+	}
+	if (strcmp(key, "sweep") == 0){
+		if (sscanf(value, "%15[a-z]:%lf:%lf", name, &(job->sweep_from), &(job->sweep_to)) != 3)
+			return 0;
+		job->sweep = findSweep(name);
+		return job->sweep == SWEEP_ANGLE || (job->sweep == SWEEP_LENGTH && job->sweep_from > 0 && job->sweep_to > 0);
+	}
+	if (strcmp(key, "threads") == 0){
+		job->threads = atoi(value);
+		return job->threads > 0;
+	}
+	if (strcmp(key, "grow") == 0){
+		job->grow = atoi(value);
+		return job->grow > 0;
+	}
+
+	//rules given with the job, starting from the default rules if no preset has been given
+	if (strlen(value) >= sizeof(job->lsys.axiom))
+		return 0;
+	if (job->label[0] == '\0' && (strcmp(key, "axiom") == 0 || ruleForKey(&(job->lsys), key) != NULL)){
+		initLsystem(&(job->lsys));
+		strcpy(job->lsys.name, "Custom");
+		strcpy(job->label, "custom");
+	}
+	if (strcmp(key, "axiom") == 0){
+		strcpy(job->lsys.axiom, value);
+		return 1;
+	}
+	rule = ruleForKey(&(job->lsys), key);
+	if (rule != NULL){
+		strcpy(rule, value);
+		return 1;
+	}
+
+	return 0;
+}
+
+int finishRenderJob(render_job *job){
+	/**
+	 * \brief Checks a render job once all of its settings have been read and fills in its file name.
+	 *
+	 * \param[out] job 		the job to be checked.
+	 *
+	 * \return 				1 if the job can be run, 0 if it has no preset or axiom.
+	 */
+
+	if (job->lsys.axiom[0] == '\0'){
+		printf("A render job needs a preset or an axiom\n");
+		return 0;
+	}
+
+	if (job->image_format < 0 && job->out[0] != '\0')
+		job->image_format = findImageFormat(job->out);
+	if (job->image_format < 0)
+		job->image_format = IMAGE_PNG;
+	if ((job->sweep || job->grow) && !job->video_format)
+		job->video_format = VIDEO_Y4M;
+	if (job->grow && (job->sweep || job->density || posterRequested(job))){
+		printf("%s: growth videos can only be drawn as lines, a whole frame at a time\n", job->out[0] ? job->out : job->label);
+		return 0;
+	}
+	if (job->sweep && (job->density || posterRequested(job))){
+		printf("%s: sweeps can only be drawn as lines, a whole frame at a time\n", job->out[0] ? job->out : job->label);
+		return 0;
+	}
+	if (job->density && (job->video_format || job->image_format == IMAGE_SVG || posterRequested(job))){
+		printf("%s: density images can only be drawn whole, as a single image\n", job->out[0] ? job->out : job->label);
+		return 0;
+	}
+	if (posterRequested(job) && job->image_format != IMAGE_PNG && job->image_format != IMAGE_PNG_STORED){
+		printf("%s: images drawn in tiles can only be saved as PNG\n", job->out[0] ? job->out : job->label);
+		return 0;
+	}
+
+	if (job->out[0] == '\0')
+		sprintf(job->out, "saves/%s_d%d.%s", job->label, job->lsys.iterations, job->video_format ? videoExtension(job->video_format) : imageExtension(job->image_format));
+
+	return 1;
+}
+
+void renderJob(render_job *job){
+	/**
+	 * \brief Makes and saves the image for a single render job, timing each stage.
+	 *
+	 * The line list is made with a line length of 1 from (0, 0), as the geometry cache and store
+	 * hold it, and is scaled to fill the image as it is drawn. Large line lists are written to the
+	 * geometry store so that later jobs for the same fractal only have to draw it. The string is
+	 * freed as soon as the line list is made so that it is not held while the image is drawn.
+	 * A job given more than one thread makes the line list in shares with shardTurtle() instead,
+	 * without the string, unless it is an angle sweep.
+	 *
+	 * \param[out] job 		the job to be run, which is given its timings and line count.
+	 */
+
+	lsystem lsys = job->lsys;
+	geom_entry stored;
+	raster_image image;
+	line *line_list = NULL;
+	double scale = 1;
+	coordinate offset;
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	Uint64 trace_begin = 0;
+	SDL_Colour bg_default = {255, 255, 255, 255};
+	SDL_Colour ln_default = {0, 0, 0, 255};
+
+	structInitRasterImage(&image);
+	structInitCoord(&offset);
+	lsys.string = NULL;
+	lsys.line_list = NULL;
+	lsys.length = 1;
+	structInitCoord(&(lsys.start));
+
+	//drawing every generation of a growth video as it is made, which times its own stages
+	if (job->grow){
+		job->saved = renderGrowth(job, &lsys, bg_default, ln_default);
+		return;
+	}
+
+	//using stored geometry if an earlier run made it, and making it otherwise, an angle sweep
+	//needs the string rather than the line list
+	job->from_store = job->sweep != SWEEP_ANGLE && openStoredGeometry(&lsys, hashLsystem(&lsys), &stored);
+	if (job->from_store){
+		line_list = stored.line_list;
+		job->segments = stored.line_list_length;
+	}
+	else if (job->threads > 1 && job->sweep != SWEEP_ANGLE){
+		//making shares of the line list on several threads, which needs no string
+		job->segments = lsys.line_list_length = shardTurtle(&lsys, job->threads);
+		line_list = lsys.line_list;
+		if (line_list == NULL){
+			printf("%s: could not make the line list\n", job->out);
+			return;
+		}
+		job->turtle_time = secondsSince(start_time);
+	}
+	else{
+		if (!makeString(&lsys)){
+			printf("%s: could not make the string\n", job->out);
+			return;
+		}
+		job->rewrite_time = secondsSince(start_time);
+
+		//running the turtle for every frame of an angle sweep from the one string, which times its own stages
+		if (job->sweep == SWEEP_ANGLE){
+			job->saved = renderSweep(job, &lsys, NULL, 0, bg_default, ln_default);
+			free(lsys.string);
+			return;
+		}
+
+		start_time = SDL_GetPerformanceCounter();
+		job->segments = lsys.line_list_length = stringToTurtle(&lsys);
+		line_list = lsys.line_list;
+		if (line_list == NULL){
+			printf("%s: could not make the line list\n", job->out);
+			free(lsys.string);
+			return;
+		}
+		storeGeometry(&lsys, lsys.string, line_list, lsys.line_list_length);
+		free(lsys.string);
+		lsys.string = NULL;
+		job->turtle_time = secondsSince(start_time);
+	}
+
+	//writing the lines straight to an svg, which needs no image
+	if (job->image_format == IMAGE_SVG && !job->video_format){
+		start_time = SDL_GetPerformanceCounter();
+		fitLines(line_list, job->segments, job->width, job->height, RENDER_MARGIN, &scale, &offset);
+		job->saved = saveSVG(line_list, job->segments, scale, offset, job->width, job->height, bg_default, ln_default, job->precision, job->out);
+		job->encode_time = secondsSince(start_time);
+		if (job->from_store)
+			closeStoredGeometry(&stored);
+		free(lsys.line_list);
+		return;
+	}
+
+	//scaling the one line list for every frame of a line length sweep, which times its own stages
+	if (job->sweep == SWEEP_LENGTH){
+		job->saved = renderSweep(job, &lsys, line_list, job->segments, bg_default, ln_default);
+		if (job->from_store)
+			closeStoredGeometry(&stored);
+		free(lsys.line_list);
+		return;
+	}
+
+	//drawing a poster a row of tiles at a time, which times its own stages
+	if (posterRequested(job)){
+		fitLines(line_list, job->segments, job->width, job->height, RENDER_MARGIN, &scale, &offset);
+		job->saved = renderPoster(job, line_list, scale, offset, bg_default, ln_default);
+		if (job->from_store)
+			closeStoredGeometry(&stored);
+		free(lsys.line_list);
+		return;
+	}
+
+	//drawing the fractal to fill the image
+	start_time = SDL_GetPerformanceCounter();
+	if (initRaster(&image, job->width, job->height)){
+		fitLines(line_list, job->segments, job->width, job->height, RENDER_MARGIN, &scale, &offset);
+		clearRaster(&image, bg_default);
+		if (job->video_format){
+			//drawing and writing the frames of a sequence, which times its own stages
+			job->saved = renderSequence(job, &image, line_list, scale, offset, bg_default, ln_default);
+		}
+		else if (job->density){
+			//counting the lines through each pixel, then colouring the counts
+			if (!drawDensity(job, &image, line_list, scale, offset, bg_default, ln_default))
+				freeRaster(&image);
+		}
+		else{
+			trace_begin = traceBegin(lsys.trace);
+			rasterFractal(&image, line_list, job->segments, scale, offset, ln_default, job->antialias);
+			traceEnd(lsys.trace, "rasterFractal", trace_begin);
+		}
+	}
+	if (!job->video_format)
+		job->raster_time = secondsSince(start_time);
+
+	if (job->from_store)
+		closeStoredGeometry(&stored);
+	free(lsys.line_list);
+
+	//saving it
+	start_time = SDL_GetPerformanceCounter();
+	if (image.pixels != NULL && !job->video_format){
+		trace_begin = traceBegin(lsys.trace);
+		job->saved = saveImage(&image, job->out, job->image_format);
+		traceEnd(lsys.trace, "saveImage", trace_begin);
+	}
+	freeRaster(&image);
+	if (!job->video_format)
+		job->encode_time = secondsSince(start_time);
+}
+
+static int renderSequence(render_job *job, raster_image *image, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour line_colour){
+	/**
+	 * \brief Writes a video of the fractal being drawn, adding a run of lines in each frame.
+	 *
+	 * The image is never cleared between frames, so each frame only draws the lines added since
+	 * the last one and the whole sequence costs one pass over the line list plus the writing of
+	 * each frame. There is no limit on the number of frames. The last frame always holds the
+	 * whole fractal.
+	 *
+	 * Anti-aliased lines are added to coverage levels kept for the whole video instead, and each
+	 * frame is the background with the levels blended over it, so lines crossing between frames
+	 * look the same as in a single image.
+	 *
+	 * \param[out] job 			the job, which is given the time spent drawing and writing.
+	 * \param[out] image 		the cleared image, fitted to the job's size.
+	 * \param[in] line_list 		the lines to be drawn.
+	 * \param[in] scale 			how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] line_colour 	colour for the lines.
+	 *
+	 * \return 					1 if every frame was written, 0 if not.
+	 */
+
+	video_stream video;
+	long long per_frame = job->lines_per_frame;
+	long long drawn = 0;
+	long long next = 0;
+	Uint32 colour = rasterColour(line_colour);
+	Uint8 *levels = NULL;
+	coordinate start;
+	coordinate end;
+	long long i = 0;
+	int written = 1;
+	Uint64 start_time = 0;
+
+	structInitVideoStream(&video);
+
+	//working out how many lines go in each frame
+	if (per_frame < 1 && job->frames > 0)
+		per_frame = (job->segments + job->frames - 1)/job->frames;
+	if (per_frame < 1)
+		per_frame = job->segments/RENDER_DEFAULT_FRAMES + 1;
+
+	if (job->antialias){
+		levels = (Uint8*)calloc((size_t)job->width*job->height, sizeof(Uint8));
+		if (levels == NULL){
+			fprintf(stderr, "%s: coverage memory allocation failed\n", job->out);
+			return 0;
+		}
+	}
+
+	if (!openVideo(&video, job->out, job->video_format, job->width, job->height, job->fps)){
+		free(levels);
+		return 0;
+	}
+
+	while (written && drawn < job->segments){
+		start_time = SDL_GetPerformanceCounter();
+		next = drawn + per_frame < job->segments ? drawn + per_frame : job->segments;
+		if (levels != NULL){
+			for (i = drawn; i < next; i++){
+				start.x_pos = offset.x_pos + scale*line_list[i].start.x_pos;
+				start.y_pos = offset.y_pos + scale*line_list[i].start.y_pos;
+				end.x_pos = offset.x_pos + scale*line_list[i].end.x_pos;
+				end.y_pos = offset.y_pos + scale*line_list[i].end.y_pos;
+				rasterLineAA(image, levels, start, end);
+			}
+			clearRaster(image, bg_colour);
+			blendCoverage(image, levels, colour);
+		}
+		else
+			rasterFractal(image, line_list + drawn, next - drawn, scale, offset, line_colour, 0);
+		drawn = next;
+		job->raster_time += secondsSince(start_time);
+
+		start_time = SDL_GetPerformanceCounter();
+		written = writeVideoFrame(&video, image);
+		job->encode_time += secondsSince(start_time);
+	}
+	free(levels);
+
+	if (!closeVideo(&video) || !written){
+		fprintf(stderr, "%s: could not write every frame\n", job->out);
+		return 0;
+	}
+
+	return 1;
+}
+
+void printRenderJob(render_job *job){
+	/**
+	 * \brief Prints the line count, wall time and peak memory of a finished render job.
+	 *
+	 * The peak resident memory is for the whole run so far, so it only goes up from one job to
+	 * the next. Jobs writing a video to stdout are reported on stderr so the video is not spoiled.
+	 *
+	 * \param[in] job 		the finished job.
+	 */
+
+	fprintf(strcmp(job->out, "-") == 0 ? stderr : stdout, "%s: %s depth %d, %lld lines%s, %.3f s, peak RSS %ld KB%s\n", job->out, job->label, job->lsys.iterations, job->segments,
+		job->from_store ? " (stored)" : "", job->rewrite_time + job->turtle_time + job->raster_time + job->encode_time, peakMemory(),
+		job->saved ? "" : ", FAILED");
+}
+
+long peakMemory(){
+	/**
+	 * \brief Returns the peak resident memory of the program in kilobytes.
+	 */
+
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	//reported in bytes rather than kilobytes on macOS
+	return usage.ru_maxrss/1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+static int drawDensity(render_job *job, raster_image *image, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Draws how many lines pass through each pixel of an image, coloured from the job's palette.
+	 *
+	 * \param[in] job 			the job, giving the tone mapping and palette.
+	 * \param[out] image 		the image, the size of the job.
+	 * \param[in] line_list 	the lines.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] bg_colour 	background colour, used by the mono palette.
+	 * \param[in] ln_colour 	line colour, used by the mono palette.
+	 *
+	 * \return 					1 if sucessfull, 0 if memory for the counts could not be allocated.
+	 */
+
+	density_map map;
+	Uint32 colours[256];
+
+	structInitDensityMap(&map);
+	if (!initDensity(&map, image->width, image->height))
+		return 0;
+
+	accumulateLines(&map, line_list, job->segments, scale, offset);
+	makePalette(colours, job->palette, bg_colour, ln_colour);
+	toneMapDensity(&map, image, job->tone, job->gamma, colours);
+
+	freeDensity(&map);
+	return 1;
+}
+
+static char *ruleForKey(lsystem *lsys, char *key){
+	/**
+	 * \brief Returns the rule of an lsystem named by a setting key, or NULL if there is none.
+	 *
+	 * \param[in] lsys 		the lsystem holding the rules.
+	 * \param[in] key 		a key such as "rule_F" or "rule_plus".
+	 */
+
+	if (strcmp(key, "rule_A") == 0) return lsys->rule_A;
+	if (strcmp(key, "rule_B") == 0) return lsys->rule_B;
+	if (strcmp(key, "rule_F") == 0) return lsys->rule_F;
+	if (strcmp(key, "rule_f") == 0) return lsys->rule_f;
+	if (strcmp(key, "rule_X") == 0) return lsys->rule_X;
+	if (strcmp(key, "rule_Y") == 0) return lsys->rule_Y;
+	if (strcmp(key, "rule_plus") == 0) return lsys->rule_plus;
+	if (strcmp(key, "rule_minus") == 0) return lsys->rule_minus;
+	if (strcmp(key, "rule_store") == 0) return lsys->rule_store;
+	if (strcmp(key, "rule_pop") == 0) return lsys->rule_pop;
+
+	return NULL;
+}
+
+static void printUsage(){
+	/**
+	 * \brief Prints how the headless renderer is used.
+	 */
+
+	int i = 0;
+
+	printf("usage: drawsystem --render preset=NAME [depth=N] [angle=DEGREES] [size=WxH] [out=FILE] [format=png|png-stored|qoi|bmp|svg] [tile=N] [antialias=on|off] [--render ...]\n");
+	printf("       drawsystem --render axiom=AXIOM rule_F=RULE ... [depth=N] [angle=DEGREES] [size=WxH] [out=FILE]\n");
+	printf("       add mode=density [tone=log|gamma] [gamma=G] [palette=mono|fire|ice|viridis] to draw line density\n");
+	printf("       add video=y4m|rgb [frames=N | lines_per_frame=N] [fps=N] to write the drawing as a video, out=- for stdout\n");
+	printf("       add sweep=angle|length:FROM:TO [frames=N] [threads=N] to write a video of the angle or line length changing\n");
+	printf("       add threads=N to any other job to make its line list on N threads, without the string\n");
+	printf("       add grow=N [video=y4m|rgb] [fps=N] to write a video of the fractal growing, N frames for each level\n");
+	printf("       drawsystem --jobs FILE [threads=N] [budget=MB] [report=FILE]\n");
+	printf("       start with --trace FILE to write a Chrome trace of the run to FILE\n");
+	printf("presets:");
+	for (i = 0; i < PRESET_COUNT; i++)
+		printf(" %s", presetKey(i));
+	printf("\n");
+}
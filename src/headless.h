@@ -0,0 +1,44 @@
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+/** \brief Number of pixels left empty around the fractal in a headless render.*/
+#define RENDER_MARGIN 10
+/** \brief Number of frames in a video when neither the frame count nor the lines per frame is given.*/
+#define RENDER_DEFAULT_FRAMES 200
+
+
+/*
+ * Returns true if the command line asks for the headless renderer.
+ */
+int headlessRequested(int argc, char *argv[]);
+
+/*
+ * Runs every render job given on the command line without opening a window.
+ */
+int runHeadless(int argc, char *argv[], trace_log *trace);
+
+/*
+ * Reads one setting of the form key=value into a render job.
+ */
+int parseRenderSetting(render_job *job, char *setting);
+
+/*
+ * Checks a render job once all of its settings have been read and fills in its file name.
+ */
+int finishRenderJob(render_job *job);
+
+/*
+ * Makes and saves the image for a single render job, timing each stage.
+ */
+void renderJob(render_job *job);
+
+/*
+ * Prints the line count, wall time and peak memory of a finished render job.
+ */
+void printRenderJob(render_job *job);
+
+/*
+ * Returns the peak resident memory of the program in kilobytes.
+ */
+long peakMemory();
+#endif
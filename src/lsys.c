@@ -17,6 +17,7 @@
 #include <SDL2/SDL_ttf.h>
 #include "structs.h"
 #include "lsys.h"
+#include "trace.h"
 
 
 /** \def M_PI
@@ -27,7 +28,14 @@
 #endif
 
 
-void iteration(lsystem *lsys){
+/** \brief Functions for the pre defined rule sets, in the order they appear on the options screen.*/
+static void (*presets[PRESET_COUNT])(lsystem *lsys) = {sierpinski, dragon, plant1, plant2, islands, snowflake, quadKoch, gosper};
+
+/** \brief Short names for the pre defined rule sets, in the same order.*/
+static char *preset_keys[PRESET_COUNT] = {"sierpinski", "dragon", "plant1", "plant2", "islands", "snowflake", "quadkoch", "gosper"};
+
+
+int iteration(lsystem *lsys){
     /**
      * \brief Performes a single iteration of character replacement for a string.
      *
@@ -35,51 +43,56 @@ void iteration(lsystem *lsys){
      * the required amout of memory before finaly creating the new string, freeing the old 
      * one, thensetting the poonter to point at the newly created string.
      *
+     * The replacements are copied to the end of the new string through a pointer rather than
+     * with strcat(), which would search for the end of the string again for every character.
+     * If the lsystem is being made on the worker thread and the job is cancelled part way
+     * through, the new string is thrown away and the old one is left in place.
+     *
      * \param[out] lsys        the lsystem that holds the rules for character replacement and the string
+     *
+     * \return                  returns 1 if sucessfull, and 0 if memory allocation failed or the job was cancelled.
      */
 
     int i = 0; // A counter to be used for iterating through arrays.
+    int oldLen = strlen(lsys->string); // Length of the string being replaced.
     int newLen = 1; // Counter for the new lenght of the characger string.
-    char character; // Container to hold the character in the string which is currently beign looked at.
+    int ruleLen = 0; // Length of the replacement string currently being copied.
+    char *rule = NULL; // Replacement string for the character which is currently beign looked at.
     char *temp = NULL; // Temporary character to hold the new string while it is being created.
+    char *end = NULL; // Pointer to the end of the new string.
+    Uint64 trace_begin = traceBegin(lsys->trace); // Time the iteration began, when it is being traced.
 
     // Finding the lenght of the new string.
-    for(i = 0; i < strlen(lsys->string); i++){
-        character = (lsys->string)[i];
-        switch(character){
-            case 'A': newLen += strlen(lsys->rule_A); break;
-            case 'B': newLen += strlen(lsys->rule_B); break;
-            case 'F': newLen += strlen(lsys->rule_F); break;
-            case 'f': newLen += strlen(lsys->rule_f); break;
-            case 'X': newLen += strlen(lsys->rule_X); break;
-            case 'Y': newLen += strlen(lsys->rule_Y); break;
-            case '+': newLen += strlen(lsys->rule_plus); break;
-            case '-': newLen += strlen(lsys->rule_minus); break;
-            case '[': newLen += strlen(lsys->rule_store); break;
-            case ']': newLen += strlen(lsys->rule_pop); break;
-            default : break;
-        }
+    for(i = 0; i < oldLen; i++){
+        rule = getRule(lsys, (lsys->string)[i]);
+        if (rule != NULL)
+            newLen += strlen(rule);
     }
 
     // Allocating memory for new string.
     temp = (char*)calloc(newLen, sizeof(char));
+    if (temp == NULL){
+        printf("string memory allocation failed\n");
+        traceEnd(lsys->trace, "iteration", trace_begin);
+        return 0;
+    }
 
     // Running through the string a second time to copy the required replacements 
     // into the newly allocatd memory.
-    for(i = 0; i < strlen(lsys->string); i++){
-        character = (lsys->string)[i];
-        switch(character){
-            case 'A': strcat(temp, lsys->rule_A); break;
-            case 'B': strcat(temp, lsys->rule_B); break;
-            case 'F': strcat(temp, lsys->rule_F); break;
-            case 'f': strcat(temp, lsys->rule_f); break;
-            case 'X': strcat(temp, lsys->rule_X); break;
-            case 'Y': strcat(temp, lsys->rule_Y); break;
-            case '+': strcat(temp, lsys->rule_plus); break;
-            case '-': strcat(temp, lsys->rule_minus); break;
-            case '[': strcat(temp, lsys->rule_store); break;
-            case ']': strcat(temp, lsys->rule_pop); break;
-            default : break;
+    end = temp;
+    for(i = 0; i < oldLen; i++){
+        rule = getRule(lsys, (lsys->string)[i]);
+        if (rule != NULL){
+            ruleLen = strlen(rule);
+            memcpy(end, rule, ruleLen);
+            end += ruleLen;
+        }
+
+        // Checking for cancellation every so often.
+        if ((i & 0xffff) == 0 && jobCancelled(lsys)){
+            free(temp);
+            traceEnd(lsys->trace, "iteration", trace_begin);
+            return 0;
         }
     }
 
@@ -87,24 +100,22 @@ void iteration(lsystem *lsys){
     free(lsys->string);
     (lsys->string) = temp;
     temp = NULL;
+    traceEnd(lsys->trace, "iteration", trace_begin);
+    return 1;
 }
 
-int makeString(lsystem *lsys){
+int startString(lsystem *lsys){
     /**
-     * \brief takes in the axiom and the rules and produces the final string, using the
-     * \brief number of iterations specified by the user.
+     * \brief Sets the string to a copy of the axiom, which is the string at a depth of 0.
      *
-     * Firstly, memory is allocated for the axiom to be places in the string container, this 
-     * allocation is then checked before the iteration() function is then run on the string 
-     * for the required number of iterations.
+     * Each call to iteration() after this makes the string one level deeper, which is how
+     * makeString() and the growth videos in grow.c both make their strings.
      *
-     * \param[out] lsys      a pointer to the lsystem that contaisn the rules, axiom, old string, and number of iterations.
+     * \param[out] lsys      a pointer to the lsystem that holds the axiom, and is given the new string.
      *
      * \return               returns 1 if sucessfull, and 0 if memory allocation failed.
      */
 
-    int i;
-
     // Allocating and checking that memory for the string was correctly allocated.
     lsys->string = (char*)calloc(strlen(lsys->axiom)+1, sizeof(char));
     if(lsys->string == NULL){
@@ -114,11 +125,43 @@ int makeString(lsystem *lsys){
 
     // Coppying the axiom to the string holder.
     strcpy(lsys->string, lsys->axiom);
+    return 1;
+}
+
+int makeString(lsystem *lsys){
+    /**
+     * \brief takes in the axiom and the rules and produces the final string, using the
+     * \brief number of iterations specified by the user.
+     *
+     * Firstly, the axiom is copied into the string container by startString(), before the
+     * iteration() function is then run on the string for the required number of iterations.
+     *
+     * \param[out] lsys      a pointer to the lsystem that contaisn the rules, axiom, old string, and number of iterations.
+     *
+     * \return               returns 1 if sucessfull, and 0 if memory allocation failed or the job was cancelled.
+     */
+
+    int i;
+    Uint64 trace_begin = traceBegin(lsys->trace);
+
+    if (!startString(lsys))
+        return 0;
+
     for(i = 0; i < lsys->iterations; i++){
-        iteration(lsys);
+        // Stopping on a failed allocation or a cancelled job, as the string would be at the wrong depth.
+        if (!iteration(lsys) || jobCancelled(lsys)){
+            free(lsys->string);
+            lsys->string = NULL;
+            traceEnd(lsys->trace, "makeString", trace_begin);
+            return 0;
+        }
+
+        // String making is the first half of the job when reporting progress.
+        reportProgress(lsys, 50*(i+1)/lsys->iterations);
     }
 
     // Return 1 if all happened sucessfully.
+    traceEnd(lsys->trace, "makeString", trace_begin);
     return 1;
 }
 
@@ -204,9 +247,118 @@ void resetLines(lsystem *lsys){
 	 */
 	
 	free(lsys->line_list);
+	lsys->line_list = NULL;
+	lsys->line_list_length = 0;
+	lsys->geometry_version++;
 	lsys->remake_lines_flag = 1;
 }
 
+char *getRule(lsystem *lsys, char character){
+    /**
+     * \brief Looks up the replacement string for a single character.
+     *
+     * Characters without a rule are dropped by iteration(), so NULL is returned for
+     * them to let the caller tell them apart from characters that map to themselves.
+     *
+     * \param[in] lsys          lsystem that holds the rules.
+     * \param[in] character     the character to look up.
+     *
+     * \return                  the replacement string, or NULL if the character has no rule.
+     */
+
+    switch(character){
+        case 'A': return lsys->rule_A;
+        case 'B': return lsys->rule_B;
+        case 'F': return lsys->rule_F;
+        case 'f': return lsys->rule_f;
+        case 'X': return lsys->rule_X;
+        case 'Y': return lsys->rule_Y;
+        case '+': return lsys->rule_plus;
+        case '-': return lsys->rule_minus;
+        case '[': return lsys->rule_store;
+        case ']': return lsys->rule_pop;
+        default : return NULL;
+    }
+}
+
+int jobCancelled(lsystem *lsys){
+    /**
+     * \brief Checks whether the job that is making this lsystem has been cancelled.
+     *
+     * Only lsystems being made on the worker thread have a cancel flag, so for any
+     * other lsystem this is always false.
+     *
+     * \param[in] lsys      lsystem being made.
+     *
+     * \return              true (1) if the job has been cancelled, false (0) if not.
+     */
+
+    return lsys->cancel_flag != NULL && SDL_AtomicGet(lsys->cancel_flag);
+}
+
+void reportProgress(lsystem *lsys, int percent){
+    /**
+     * \brief Publishes how far through making the string and line list the job is.
+     *
+     * \param[out] lsys     lsystem being made.
+     * \param[in] percent   progress from 0 to 100.
+     */
+
+    if (lsys->progress != NULL)
+        SDL_AtomicSet(lsys->progress, percent);
+}
+
+int loadPreset(lsystem *lsys, int index){
+    /**
+     * \brief Loads one of the pre defined rule sets by its position in the list.
+     *
+     * \param[out] lsys     lsystem for the rules to be copied to.
+     * \param[in] index     position of the rule set, from 0 to PRESET_COUNT-1.
+     *
+     * \return              1 if sucessfull, 0 if there is no rule set at index.
+     */
+
+    if (index < 0 || index >= PRESET_COUNT)
+        return 0;
+
+    presets[index](lsys);
+    return 1;
+}
+
+int findPreset(char *key){
+    /**
+     * \brief Finds a pre defined rule set by its short name (the name of its function in lower case).
+     *
+     * \param[in] key       short name such as "dragon" or "quadkoch".
+     *
+     * \return              position of the rule set, or -1 if there is none with that name.
+     */
+
+    int i = 0;
+
+    for (i = 0; i < PRESET_COUNT; i++){
+        if (strcmp(key, preset_keys[i]) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+char *presetKey(int index){
+    /**
+     * \brief Returns the short name of a pre defined rule set.
+     *
+     * \param[in] index     position of the rule set, from 0 to PRESET_COUNT-1.
+     *
+     * \return              the short name, or NULL if there is no rule set at index.
+     */
+
+    if (index < 0 || index >= PRESET_COUNT)
+        return NULL;
+
+    return preset_keys[index];
+}
+
 void sierpinski(lsystem *lsys){
     /** 
      * \brief Copy Sierpinski Triangle rules to the lsystem.
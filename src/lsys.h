@@ -9,7 +9,12 @@
 /*
  * \brief performs a single iteration of character replacement
  */
-void iteration(lsystem *lsys);
+int iteration(lsystem *lsys);
+
+/*
+ * \brief sets the string to a copy of the axiom, the string at a depth of 0
+ */
+int startString(lsystem *lsys);
 
 /*
  * \brief makes the final string from rules defined in the lsystem
@@ -46,6 +51,21 @@ void resetString(lsystem* lsys);
  */
 void resetLines(lsystem *lsys);
 
+/*
+ * \brief returns the replacement string for a character, or NULL if it has no rule
+ */
+char *getRule(lsystem *lsys, char character);
+
+/*
+ * \brief returns true if the worker thread job making the lsystem has been cancelled
+ */
+int jobCancelled(lsystem *lsys);
+
+/*
+ * \brief publishes the progress of the worker thread job making the lsystem
+ */
+void reportProgress(lsystem *lsys, int percent);
+
 
 
 
@@ -53,6 +73,26 @@ void resetLines(lsystem *lsys);
 *   Pre Defined Lsystem Rule Sets    *
 *************************************/
 
+/** \def PRESET_COUNT
+ *   \brief The number of pre defined rule sets
+ */
+#define PRESET_COUNT 8
+
+/*
+ * \brief loads the pre defined rule set at index into the lsystem
+ */
+int loadPreset(lsystem *lsys, int index);
+
+/*
+ * \brief returns the index of the pre defined rule set with a given short name, or -1
+ */
+int findPreset(char *key);
+
+/*
+ * \brief returns the short name of the pre defined rule set at index
+ */
+char *presetKey(int index);
+
 /*
   * \brief rule set for a sierpinski triange
   */
@@ -10,10 +10,22 @@
  *
  * Once all variables have been declared and initilaised, a while loop that 
  * checks for events and handles window drawing operations for different 
- * click events is entered and only exited when the program is quit.
+ * click events is entered and only exited when the program is quit. Each
+ * time round the loop every waiting event is handled before the screen is
+ * drawn, and it is only drawn and presented if one of them changed it, 
+ * while a progress bar is moving, or while the fractal is still being drawn
+ * a slice at a time.
  *
  * When the program is quit, all variables that need freeing/destroying are
  * handlend and the program exits.
+ *
+ * If the program is started with --render on the command line, the headless
+ * renderer is run instead and no window is opened.
+ *
+ * If the command line starts with --trace FILE, the stages of making, drawing
+ * and saving the fractal and the handling of events are recorded on every
+ * thread (see trace.c), and written to FILE as Chrome trace event JSON when
+ * the program exits, or whenever TRACE_KEY is pressed.
 */
 
 #include <stdio.h>
@@ -23,6 +35,17 @@
 #include <SDL2/SDL_ttf.h>
 #include "structs.h"
 #include "lsys.h"
+#include "worker.h"
+#include "cache.h"
+#include "spec.h"
+#include "raster.h"
+#include "export.h"
+#include "coverage.h"
+#include "textcache.h"
+#include "frame.h"
+#include "scrub.h"
+#include "trace.h"
+#include "headless.h"
 #include "ui.h"
 
 
@@ -32,7 +55,7 @@
 int init();
 
 
-int main(){
+int main(int argc, char *argv[]){
     /**
      * \brief Intialisinf variables for, and controling the running of the program.
      *
@@ -40,9 +63,34 @@ int main(){
      * before frawing the rewuired window defined by the win_flag. Runs functions for handeling 
      * click events for changing the win_flag and parameters within the L-System.
      *
+     * \param[in] argc     number of command line arguments.
+     * \param[in] argv     the command line arguments, see headless.c for the --render jobs.
+     *
      * \return   0 if the program runs sucessfully.
      */
 
+    //recording a trace of where the time goes if asked to, the rest of the command line is read as usual
+    trace_log trace;
+    trace_log *tracing = NULL;
+    structInitTraceLog(&trace);
+    if (argc > 2 && strcmp(argv[1], "--trace") == 0){
+        if (startTrace(&trace, argv[2]))
+            tracing = &trace;
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    //rendering straight to files without initialising video or fonts
+    if (headlessRequested(argc, argv)){
+        int failed = runHeadless(argc, argv, tracing);
+        if (tracing != NULL){
+            writeTrace(tracing);
+            freeTrace(tracing);
+        }
+        return failed;
+    }
+
 	//Initialising SDL elements.
     if (init()){
     	printf("ERROR: initialisation error.\n");
@@ -65,8 +113,8 @@ int main(){
         structInitBtn(&(options_screen_buttons[i]));
     createOptionsScreenButtons(options_screen_buttons, arial_body);
 
-    btn draw_screen_buttons[9];
-    for (i = 0; i < 9; i++)
+    btn draw_screen_buttons[14];
+    for (i = 0; i < 14; i++)
         structInitBtn(&(draw_screen_buttons[i]));
     createDrawScreenButtons(draw_screen_buttons, arial_title, arial_body);
 
@@ -81,6 +129,43 @@ int main(){
     SDL_Colour ln_default = {0, 0, 0, 255};
     lsys.bg_colour = bg_default;
     lsys.ln_colour = ln_default;
+    lsys.trace = tracing;
+
+    //starting the worker thread that makes strings and line lists in the background
+    gen_worker worker;
+    structInitGenWorker(&worker);
+    if (!startWorker(&worker)){
+        printf("ERROR: worker thread could not be started.\n");
+        return 1;
+    }
+
+    //starting the speculative scheduler that fills the geometry cache while the program is idle,
+    //nothing has been drawn yet so every pre defined rule set is a candidate
+    geom_cache cache;
+    structInitGeomCache(&cache);
+    spec_scheduler spec;
+    structInitSpecScheduler(&spec);
+    if (!initCache(&cache, CACHE_BUDGET) || !startSpeculation(&spec, &cache)){
+        printf("ERROR: speculative scheduler could not be started.\n");
+        return 1;
+    }
+    lsystem nothing_drawn;
+    structInitLsystem(&nothing_drawn);
+    nothing_drawn.trace = tracing;
+    speculate(&spec, &nothing_drawn);
+
+    //setting up the exporter that saves image sequences in the background
+    seq_exporter exporter;
+    structInitSeqExporter(&exporter);
+    exporter.trace = tracing;
+    if (!initExporter(&exporter)){
+        printf("ERROR: sequence exporter could not be set up.\n");
+        return 1;
+    }
+
+    //the fractal is drawn through a coverage mask, which is allocated when it is first drawn
+    coverage_mask coverage;
+    structInitCoverageMask(&coverage);
 
     //setting window flag to the opening window
     int win_flag = 1;
@@ -94,54 +179,138 @@ int main(){
                                 win_width,
                                 win_height,
                                 SDL_WINDOW_SHOWN);
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+
+    //attaching a cache of rendered text to the window, so labels are only rendered once
+    text_cache text;
+    structInitTextCache(&text);
+    SDL_SetWindowData(window, TEXT_CACHE_DATA, &text);
+
+    //the parts of each screen that never change are drawn once into a layer
+    ui_layers layers;
+    structInitUiLayers(&layers);
+
+    //dragging the angle and line length on the drawing screen
+    scrub_state scrub;
+    structInitScrubState(&scrub);
+
+    //counting frames and events, and measuring input to present latency and the time of each stage
+    frame_stats frames;
+    structInitFrameStats(&frames);
 
     //entering screen drawing and refresh loop
     int go = 1;
+    int dirty = 1;
+    int busy = 0;
+    int was_busy = 0;
+    int drawing = 0;
+    Uint64 trace_begin = 0;
+    SDL_Event event;
     while (go){
 
-    	//clear screen at the start of evey loop
-    	
-    	//deciding on the window to be drawn
-    	switch(win_flag){
-    		case 1: drawHomeScreen(renderer, home_screen_buttons, arial_title, arial_body); break;
-    		case 2: drawOptionsScreen(renderer, options_screen_buttons, arial_title, arial_body, &lsys); break;
-    		case 3: drawDrawingScreen(renderer, draw_screen_buttons, arial_title, arial_body, &lsys); break;
+    	//while the worker thread or a sequence export is busy the screen is refreshed regularly
+    	//to keep the progress bars moving, and once more when it finishes to show the result
+    	busy = workerBusy(&worker) || exportBusy(&exporter);
+    	if (busy || was_busy || drawing)
+    		dirty = 1;
+    	was_busy = busy;
+
+    	//drawing the window to be shown, only if something on it has changed
+    	if (dirty){
+    		trace_begin = traceBegin(tracing);
+    		startFrame(&frames);
+    		switch(win_flag){
+    			case 1: drawHomeScreen(renderer, home_screen_buttons, arial_title, arial_body, &layers); break;
+    			case 2: drawOptionsScreen(renderer, options_screen_buttons, arial_title, arial_body, &lsys, &layers); break;
+    			case 3: drawDrawingScreen(renderer, draw_screen_buttons, arial_title, arial_body, &lsys, &worker, &spec, &exporter, &coverage, &layers, &scrub, &(frames.stages)); break;
+    		}
+
+    		//rendering what has been drawn to the renderer to the screen, which waits for vsync
+    		presentFrame(renderer, &frames);
+    		traceEnd(tracing, "frame", trace_begin);
+    		dirty = 0;
+
+    		//the fractal is drawn a slice at a time, and carries on from where it stopped next frame
+    		drawing = win_flag == 3 && !coverageDone(&coverage, &lsys);
     	}
 
-    	//checking for events
-    	SDL_Event event;
-    	SDL_WaitEvent(&event);
-
-    	if (event.type == SDL_QUIT)
-    		go = 0;
-
-    	//click event on the home screen
-    	if (event.type == SDL_MOUSEBUTTONDOWN && win_flag == 1){
-    		win_flag = homeScreenClick(event, home_screen_buttons, win_flag);
-    		continue;
+    	//while the fractal is being drawn only events already waiting are handled, otherwise
+    	//waiting for an event, or only until the progress bars next need refreshing
+    	if (drawing){
+    		if (!SDL_PollEvent(&event))
+    			continue;
     	}
-
-    	//click event on the options screen
-    	if (event.type == SDL_MOUSEBUTTONDOWN && win_flag == 2){
-    		win_flag = optionsScreenClick(renderer, event, options_screen_buttons, win_flag, &lsys);
-    		continue;
+    	else if (busy){
+    		if (!SDL_WaitEventTimeout(&event, 100))
+    			continue;
     	}
-
-    	//click event on the draw screen
-    	if (event.type == SDL_MOUSEBUTTONDOWN && win_flag == 3){
-    		win_flag = drawScreenClick(renderer, event, draw_screen_buttons, win_flag, &lsys, arial_title, arial_body);
+    	else if (!SDL_WaitEvent(&event))
     		continue;
-    	}
-    	//rendering what has been drawn to the renderer to the screen
-    	SDL_RenderPresent(renderer);
+
+    	//handling that event and every other one already waiting before anything is drawn
+    	trace_begin = traceBegin(tracing);
+    	do {
+    		if (noteEvent(&frames, &event))
+    			dirty = 1;
+
+    		if (event.type == SDL_QUIT)
+    			go = 0;
+
+    		//writing the trace recorded so far without quitting
+    		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == TRACE_KEY && tracing != NULL)
+    			writeTrace(tracing);
+
+    		//textures drawn into, like the static layers, are lost when the renderer is reset
+    		if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET)
+    			invalidateLayers(&layers);
+
+    		//click events on each screen
+    		if (event.type == SDL_MOUSEBUTTONDOWN){
+    			switch(win_flag){
+    				case 1: win_flag = homeScreenClick(event, home_screen_buttons, win_flag); break;
+    				case 2: win_flag = optionsScreenClick(renderer, event, options_screen_buttons, win_flag, &lsys, &spec); break;
+    				case 3: win_flag = drawScreenClick(renderer, event, draw_screen_buttons, win_flag, &lsys, arial_title, arial_body, &worker, &exporter, &coverage, &scrub); break;
+    			}
+    		}
+
+    		//dragging the angle or line length, the fractal is remade once for all the motion before the next frame
+    		if (event.type == SDL_MOUSEMOTION && scrubMotion(&scrub, &lsys, event.motion.xrel)){
+    			noteInput(&frames, event.motion.timestamp);
+    			dirty = 1;
+    		}
+
+    		//letting go of a drag, which remakes the fractal at full depth if a preview is shown
+    		if (event.type == SDL_MOUSEBUTTONUP && scrub.active != SCRUB_NONE){
+    			finishScrub(&scrub, &lsys);
+    			dirty = 1;
+    		}
+    	} while (go && SDL_PollEvent(&event));
+    	traceEnd(tracing, "events", trace_begin);
     }
 
-    //freeing lsystem elements
-    if (win_flag == 3){
-        free(lsys.string);
-        free(lsys.line_list);
+    //stopping the background threads before anything they could be using is freed
+    stopWorker(&worker);
+    stopSpeculation(&spec);
+    stopExporter(&exporter);
+    if (tracing != NULL){
+        writeTrace(tracing);
+        freeTrace(tracing);
     }
+    printf("geometry cache: %d hits, %d misses\n", cache.hits, cache.misses);
+    freeCache(&cache);
+
+    //freeing lsystem elements and anything kept for a drag
+    freeScrub(&scrub);
+    free(lsys.string);
+    free(lsys.line_list);
+
+    //freeing the coverage mask, static layers and text cache before the renderer their textures belong to
+    freeCoverage(&coverage);
+    freeLayers(&layers);
+    SDL_SetWindowData(window, TEXT_CACHE_DATA, NULL);
+    printf("text cache: %d hits, %d misses\n", text.hits, text.misses);
+    printFrameStats(&frames);
+    freeTextCache(&text);
 
     //freeing fonts
     TTF_CloseFont(arial_body);
@@ -0,0 +1,310 @@
+/**
+ * \file poster.c
+ *
+ * \brief A source file for drawing images far larger than memory, such as posters for
+ * print, one row of tiles at a time.
+ *
+ * A 20000x20000 image is 1.6 GB of pixels, so it is never held whole. The image is split
+ * into tiles, and first every line is put in the bin of each row of tiles it crosses,
+ * under the leftmost tile it touches in that row, so the lines of each tile are drawn
+ * together. Then each row of tiles is drawn into one band of pixels, only from its own
+ * bins, and its scanlines are streamed to a PNG file before the band is reused for the
+ * next row. The band is at most POSTER_BAND_BYTES, so the pixels held do not grow with
+ * the size of the image, and the bins only grow with the number of lines.
+ *
+ * Each tile rounds points exactly as the whole picture would be rounded, so a poster
+ * has the same pixels as the same image drawn in one go. Anti-aliased lines are drawn into
+ * coverage levels for the band, which keep the largest coverage whatever order lines are
+ * drawn in, and reach one pixel further than aliased lines, so they are binned with a
+ * margin of a pixel.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+#include "encode.h"
+#include "headless.h"
+#include "timing.h"
+#include "poster.h"
+
+
+/*
+ * Works out the size of the tiles and bands a poster is drawn in.
+ */
+static void posterLayout(render_job *job, int *tile_width, int *band_height, int *columns, int *bands);
+
+/*
+ * Finds the tiles a line crosses, returning false if it is wholly outside the image.
+ */
+static int lineTiles(line *ln, double scale, coordinate offset, int width, int height, int tile_width, int band_height, int margin, int *column, int *first_band, int *last_band);
+
+
+int posterRequested(render_job *job){
+	/**
+	 * \brief Returns true if a render job's image is to be drawn in tiles as a poster.
+	 *
+	 * Images are drawn as posters if a tile size is given, or if their pixels would take more
+	 * than POSTER_AUTO_BYTES. Videos and svg files are never drawn in tiles.
+	 *
+	 * \param[in] job 		the job, after finishRenderJob().
+	 */
+
+	if (job->video_format || job->image_format == IMAGE_SVG)
+		return 0;
+
+	return job->tile_size > 0 || (double)job->width*job->height*sizeof(Uint32) > POSTER_AUTO_BYTES;
+}
+
+size_t posterBytes(render_job *job, double segments){
+	/**
+	 * \brief Returns the number of bytes drawing a poster is expected to hold, not counting the line list.
+	 *
+	 * This is the band (and its coverage levels for anti-aliased lines), the bins (one entry for most lines, as few cross between rows of tiles)
+	 * and the buffers of the PNG stream.
+	 *
+	 * \param[in] job 		the job.
+	 * \param[in] segments 	number of lines in the job's line list.
+	 *
+	 * \return 				the expected number of bytes.
+	 */
+
+	int tile_width = 0;
+	int band_height = 0;
+	int columns = 0;
+	int bands = 0;
+	double bytes = 0;
+
+	posterLayout(job, &tile_width, &band_height, &columns, &bands);
+
+	bytes = (double)job->width*band_height*(sizeof(Uint32) + (job->antialias ? 1 : 0));
+	bytes += 2*((double)columns*bands + 1)*sizeof(size_t) + segments*sizeof(int);
+	bytes += 2*DEFLATE_WINDOW + PNG_CHUNK_BYTES + (65536 + DEFLATE_WINDOW)*sizeof(int) + 6.0*job->width;
+
+	return bytes < (double)((size_t)-1) ? (size_t)bytes : (size_t)-1;
+}
+
+int renderPoster(render_job *job, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Draws a render job's image one row of tiles at a time, streaming the rows to a PNG file.
+	 *
+	 * The time spent binning and drawing is added to the job's raster time and the time spent
+	 * writing to its encode time.
+	 *
+	 * \param[out] job 			the job, with its image saved as PNG or stored PNG.
+	 * \param[in] line_list 	the lines to be drawn.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] ln_colour 	colour for the lines.
+	 *
+	 * \return 					1 if sucessfull, 0 if memory could not be allocated or the file could not be written.
+	 */
+
+	Uint32 colour = rasterColour(ln_colour);
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	raster_image band;
+	png_stream png;
+	Uint8 *levels = NULL;
+	FILE *file = NULL;
+	size_t *starts = NULL;
+	size_t *next = NULL;
+	int *bins = NULL;
+	coordinate start;
+	coordinate end;
+	int tile_width = 0;
+	int band_height = 0;
+	int columns = 0;
+	int bands = 0;
+	int tiles = 0;
+	int column = 0;
+	int first_band = 0;
+	int last_band = 0;
+	int saved = 0;
+	int b = 0;
+	int t = 0;
+	int i = 0;
+	size_t k = 0;
+
+	structInitRasterImage(&band);
+	posterLayout(job, &tile_width, &band_height, &columns, &bands);
+	tiles = columns*bands;
+
+	//counting the lines in each bin, then setting out where each bin starts
+	starts = (size_t*)calloc(tiles+1, sizeof(size_t));
+	next = (size_t*)malloc(tiles*sizeof(size_t));
+	if (starts == NULL || next == NULL){
+		printf("poster bin memory allocation failed\n");
+		free(starts);
+		free(next);
+		return 0;
+	}
+	for (i = 0; i < job->segments; i++){
+		if (lineTiles(&(line_list[i]), scale, offset, job->width, job->height, tile_width, band_height, job->antialias, &column, &first_band, &last_band))
+			for (b = first_band; b <= last_band; b++)
+				starts[b*columns + column + 1]++;
+	}
+	for (t = 0; t < tiles; t++){
+		starts[t+1] += starts[t];
+		next[t] = starts[t];
+	}
+
+	//filling the bins, keeping the lines of each bin in order
+	bins = (int*)malloc((starts[tiles] > 0 ? starts[tiles] : 1)*sizeof(int));
+	if (bins == NULL){
+		printf("poster bin memory allocation failed\n");
+		free(starts);
+		free(next);
+		return 0;
+	}
+	for (i = 0; i < job->segments; i++){
+		if (lineTiles(&(line_list[i]), scale, offset, job->width, job->height, tile_width, band_height, job->antialias, &column, &first_band, &last_band))
+			for (b = first_band; b <= last_band; b++)
+				bins[next[b*columns + column]++] = i;
+	}
+	free(next);
+	job->raster_time += secondsSince(start_time);
+
+	if (job->antialias){
+		levels = (Uint8*)malloc((size_t)job->width*band_height);
+		if (levels == NULL){
+			printf("poster coverage memory allocation failed\n");
+			free(starts);
+			free(bins);
+			return 0;
+		}
+	}
+
+	file = fopen(job->out, "wb");
+	if (file == NULL || !initRaster(&band, job->width, band_height) || !openPNGStream(&png, file, job->width, job->height, job->image_format != IMAGE_PNG_STORED)){
+		printf("Could not save %s\n", job->out);
+		if (file != NULL)
+			fclose(file);
+		freeRaster(&band);
+		free(levels);
+		free(starts);
+		free(bins);
+		return 0;
+	}
+
+	for (b = 0; b < bands; b++){
+		//drawing the lines of each tile in the row into the band
+		start_time = SDL_GetPerformanceCounter();
+		band.y_origin = b*band_height;
+		band.height = job->height - band.y_origin < band_height ? job->height - band.y_origin : band_height;
+		clearRaster(&band, bg_colour);
+		if (levels != NULL)
+			memset(levels, 0, (size_t)band.width*band.height);
+		for (t = b*columns; t < (b+1)*columns; t++){
+			for (k = starts[t]; k < starts[t+1]; k++){
+				i = bins[k];
+				start.x_pos = offset.x_pos + scale*line_list[i].start.x_pos;
+				start.y_pos = offset.y_pos + scale*line_list[i].start.y_pos;
+				end.x_pos = offset.x_pos + scale*line_list[i].end.x_pos;
+				end.y_pos = offset.y_pos + scale*line_list[i].end.y_pos;
+				if (levels != NULL)
+					rasterLineAA(&band, levels, start, end);
+				else
+					rasterLine(&band, start, end, colour);
+			}
+		}
+		if (levels != NULL)
+			blendCoverage(&band, levels, colour);
+		job->raster_time += secondsSince(start_time);
+
+		//streaming its scanlines out
+		start_time = SDL_GetPerformanceCounter();
+		for (i = 0; i < band.height; i++)
+			writePNGRow(&png, band.pixels + (size_t)i*band.width);
+		job->encode_time += secondsSince(start_time);
+	}
+
+	start_time = SDL_GetPerformanceCounter();
+	saved = closePNGStream(&png);
+	if (fclose(file) != 0)
+		saved = 0;
+	if (!saved)
+		printf("Could not save %s\n", job->out);
+	job->encode_time += secondsSince(start_time);
+
+	freeRaster(&band);
+	free(levels);
+	free(starts);
+	free(bins);
+	return saved;
+}
+
+static void posterLayout(render_job *job, int *tile_width, int *band_height, int *columns, int *bands){
+	/**
+	 * \brief Works out the size of the tiles and bands a poster is drawn in.
+	 *
+	 * Tiles are square unless a row of them would be more than POSTER_BAND_BYTES, in which case
+	 * they are made shorter.
+	 *
+	 * \param[in] job 			the job.
+	 * \param[out] tile_width 	width of each tile in pixels.
+	 * \param[out] band_height 	height of each row of tiles in pixels.
+	 * \param[out] columns 		number of tiles in each row.
+	 * \param[out] bands 		number of rows of tiles.
+	 */
+
+	double max_height = (double)POSTER_BAND_BYTES/((double)job->width*sizeof(Uint32));
+
+	*tile_width = job->tile_size > 0 ? job->tile_size : POSTER_TILE;
+	if (*tile_width > job->width)
+		*tile_width = job->width;
+
+	*band_height = *tile_width;
+	if (*band_height > max_height)
+		*band_height = max_height;
+	if (*band_height > job->height)
+		*band_height = job->height;
+	if (*band_height < 1)
+		*band_height = 1;
+
+	*columns = (job->width + *tile_width - 1) / *tile_width;
+	*bands = (job->height + *band_height - 1) / *band_height;
+}
+
+static int lineTiles(line *ln, double scale, coordinate offset, int width, int height, int tile_width, int band_height, int margin, int *column, int *first_band, int *last_band){
+	/**
+	 * \brief Finds the tiles a line crosses, returning false if it is wholly outside the image.
+	 *
+	 * Points are placed and rounded the same way rasterLine() rounds them.
+	 *
+	 * \param[in] ln 			the line.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] width 		width of the image in pixels.
+	 * \param[in] height 		height of the image in pixels.
+	 * \param[in] tile_width 	width of each tile in pixels.
+	 * \param[in] band_height 	height of each row of tiles in pixels.
+	 * \param[in] margin 		number of pixels further than its rounded points the line may reach.
+	 * \param[out] column 		the leftmost column of tiles the line touches.
+	 * \param[out] first_band 	the top row of tiles the line touches.
+	 * \param[out] last_band 	the bottom row of tiles the line touches.
+	 */
+
+	double x0 = round(offset.x_pos + scale*ln->start.x_pos);
+	double y0 = round(offset.y_pos + scale*ln->start.y_pos);
+	double xn = round(offset.x_pos + scale*ln->end.x_pos);
+	double yn = round(offset.y_pos + scale*ln->end.y_pos);
+	double min_x = fmin(x0, xn) - margin;
+	double max_x = fmax(x0, xn) + margin;
+	double min_y = fmin(y0, yn) - margin;
+	double max_y = fmax(y0, yn) + margin;
+
+	if (max_x < 0 || min_x >= width || max_y < 0 || min_y >= height)
+		return 0;
+
+	*column = min_x < 0 ? 0 : (int)min_x / tile_width;
+	*first_band = min_y < 0 ? 0 : (int)min_y / band_height;
+	*last_band = max_y >= height ? (height-1) / band_height : (int)max_y / band_height;
+
+	return 1;
+}
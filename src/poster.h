@@ -0,0 +1,27 @@
+#ifndef _POSTER_H_
+#define _POSTER_H_
+
+/** \brief Width of the tiles a poster is drawn in unless another tile size is given.*/
+#define POSTER_TILE 1024
+/** \brief Largest number of bytes the row of tiles being drawn may hold, which limits how tall it is.*/
+#define POSTER_BAND_BYTES (64*1024*1024)
+/** \brief Images with more bytes of pixels than this are drawn as posters even when no tile size is given.*/
+#define POSTER_AUTO_BYTES (256*1024*1024)
+
+
+/*
+ * Returns true if a render job's image is to be drawn in tiles as a poster.
+ */
+int posterRequested(render_job *job);
+
+/*
+ * Returns the number of bytes drawing a poster is expected to hold, not counting the line list.
+ */
+size_t posterBytes(render_job *job, double segments);
+
+/*
+ * Draws a render job's image one row of tiles at a time, streaming the rows to a PNG file.
+ */
+int renderPoster(render_job *job, line *line_list, double scale, coordinate offset, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+#endif
@@ -0,0 +1,378 @@
+/**
+ * \file raster.c
+ *
+ * \brief A source file for drawing fractals into an image in memory on the CPU.
+ *
+ * Used by the headless renderer, which has no window or renderer to draw to. Images
+ * are held as ARGB8888 pixels, the same format the drawing screen is read back in
+ * when it is saved, and are written out with SDL_SaveBMP(), which does not need the
+ * video subsystem.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "raster.h"
+
+
+int initRaster(raster_image *image, int width, int height){
+	/**
+	 * \brief Allocates the pixels of an image.
+	 *
+	 * \param[out] image 	an image initialised with structInitRasterImage().
+	 * \param[in] width 	width of the image in pixels.
+	 * \param[in] height 	height of the image in pixels.
+	 *
+	 * \return 				1 if sucessfull, 0 if the size is not valid or memory allocation failed.
+	 */
+
+	if (width < 1 || height < 1)
+		return 0;
+
+	image->pixels = (Uint32*)malloc((size_t)width*height*sizeof(Uint32));
+	if (image->pixels == NULL){
+		printf("image memory allocation failed\n");
+		return 0;
+	}
+
+	image->width = width;
+	image->height = height;
+	return 1;
+}
+
+void freeRaster(raster_image *image){
+	/**
+	 * \brief Frees the pixels of an image.
+	 *
+	 * \param[out] image 	the image to be freed.
+	 */
+
+	free(image->pixels);
+	structInitRasterImage(image);
+}
+
+Uint32 rasterColour(SDL_Colour colour){
+	/**
+	 * \brief Packs a colour into an ARGB8888 pixel.
+	 *
+	 * \param[in] colour 	the colour to be packed.
+	 *
+	 * \return 				the pixel.
+	 */
+
+	return ((Uint32)colour.a << 24) | ((Uint32)colour.r << 16) | ((Uint32)colour.g << 8) | (Uint32)colour.b;
+}
+
+void clearRaster(raster_image *image, SDL_Colour colour){
+	/**
+	 * \brief Fills an image with a single colour.
+	 *
+	 * \param[out] image 	the image to be cleared.
+	 * \param[in] colour 	the background colour.
+	 */
+
+	Uint32 pixel = rasterColour(colour);
+	size_t count = (size_t)image->width*image->height;
+	size_t i = 0;
+
+	for (i = 0; i < count; i++)
+		image->pixels[i] = pixel;
+}
+
+void rasterLine(raster_image *image, coordinate start, coordinate end, Uint32 colour){
+	/**
+	 * \brief Draws a line to an image with the bresenham line drawing algorithm.
+	 *
+	 * Works in the same way as drawLine() on the drawing screen, but writes straight to the
+	 * pixels of the image and only draws the points that are inside it. Points are rounded
+	 * before the image's origin is taken away, so a tile draws exactly the pixels the whole
+	 * picture would.
+	 *
+	 * \param[out] image 	the image to be drawn to.
+	 * \param[in] start 	start point of the line.
+	 * \param[in] end 		end point of the line.
+	 * \param[in] colour 	colour of the line as an ARGB8888 pixel.
+	 */
+
+	int x0 = round(start.x_pos) - image->x_origin;
+	int y0 = round(start.y_pos) - image->y_origin;
+
+	int xn = round(end.x_pos) - image->x_origin;
+	int yn = round(end.y_pos) - image->y_origin;
+
+	int dx = abs(xn-x0);
+	int sx = x0<xn ? 1 : -1;
+
+	int dy = abs(yn-y0);
+	int sy = y0<yn ? 1 : -1;
+
+	int error = (dx>dy ? dx : -dy)/2;
+	int e2;
+
+	//skipping lines that are wholly off one side of the image
+	if ((x0 < 0 && xn < 0) || (y0 < 0 && yn < 0) || (x0 >= image->width && xn >= image->width) || (y0 >= image->height && yn >= image->height))
+		return;
+
+	while (1){
+
+		//only draws points inside the image
+		if (x0 >= 0 && x0 < image->width && y0 >= 0 && y0 < image->height)
+			image->pixels[(size_t)y0*image->width + x0] = colour;
+
+		//breaks if the end of the line has been reached
+		if (x0 == xn && y0 == yn)
+			break;
+
+		e2 = error;
+		if (e2 > -dx){
+			error -= dy;
+			x0 += sx;
+		}
+
+		if (e2 < dy){
+			error += dx;
+			y0 += sy;
+		}
+	}
+}
+
+void rasterLineAA(raster_image *image, Uint8 *levels, coordinate start, coordinate end){
+	/**
+	 * \brief Draws an anti-aliased line into the coverage levels of an image with Xiaolin Wu's algorithm.
+	 *
+	 * For each pixel along the longer axis of the line, the point of the line there is split
+	 * between the two pixels either side of it on the shorter axis, so a line between pixel
+	 * centres has its full coverage of 255 shared between them. Each level keeps the largest
+	 * coverage any line gives it, so the order lines are drawn in does not matter, and joins and
+	 * crossings are not darkened. The point is worked out afresh for each pixel rather than
+	 * stepped along, so a tile gives the same levels as the whole picture.
+	 *
+	 * \param[in] image 	the image the levels belong to, giving their size and origin.
+	 * \param[out] levels 	array of one coverage level from 0 to 255 for each pixel of the image.
+	 * \param[in] start 	start point of the line.
+	 * \param[in] end 		end point of the line.
+	 */
+
+	double x0 = start.x_pos;
+	double y0 = start.y_pos;
+	double x1 = end.x_pos;
+	double y1 = end.y_pos;
+	int steep = fabs(y1-y0) > fabs(x1-x0);
+	double swap = 0;
+	double gradient = 0;
+	double minor = 0;
+	int major_origin = steep ? image->y_origin : image->x_origin;
+	int major_size = steep ? image->height : image->width;
+	int minor_origin = steep ? image->x_origin : image->y_origin;
+	int minor_size = steep ? image->width : image->height;
+	size_t major_stride = steep ? image->width : 1;
+	size_t minor_stride = steep ? 1 : image->width;
+	Uint8 *pixel = NULL;
+	int first = 0;
+	int last = 0;
+	int major = 0;
+	int row = 0;
+	int level = 0;
+
+	//stepping along x for shallow lines and y for steep ones, from the smaller end
+	if (steep){
+		swap = x0; x0 = y0; y0 = swap;
+		swap = x1; x1 = y1; y1 = swap;
+	}
+	if (x0 > x1){
+		swap = x0; x0 = x1; x1 = swap;
+		swap = y0; y0 = y1; y1 = swap;
+	}
+	gradient = x1 > x0 ? (y1-y0)/(x1-x0) : 0;
+
+	//skipping lines that are wholly off one side of the image
+	if (fmax(y0, y1) < minor_origin - 1 || fmin(y0, y1) >= minor_origin + minor_size)
+		return;
+
+	//only stepping over the part of the line inside the image
+	first = round(x0) - major_origin;
+	last = round(x1) - major_origin;
+	if (first < 0)
+		first = 0;
+	if (last >= major_size)
+		last = major_size-1;
+
+	for (major = first; major <= last; major++){
+		minor = y0 + gradient*(major + major_origin - x0);
+		row = floor(minor);
+		level = (minor - row)*255 + 0.5;
+		row -= minor_origin;
+
+		if (row >= 0 && row < minor_size){
+			pixel = levels + major*major_stride + (size_t)row*minor_stride;
+			if (*pixel < 255-level)
+				*pixel = 255-level;
+		}
+		if (row+1 >= 0 && row+1 < minor_size){
+			pixel = levels + major*major_stride + (size_t)(row+1)*minor_stride;
+			if (*pixel < level)
+				*pixel = level;
+		}
+	}
+}
+
+void blendCoverage(raster_image *image, Uint8 *levels, Uint32 colour){
+	/**
+	 * \brief Blends a colour over each pixel of an image by its coverage level.
+	 *
+	 * A level of 0 leaves the pixel as it is and 255 gives it the colour. The red and blue
+	 * channels are blended together in one multiply and green in another, each rounded exactly
+	 * to the nearest of 255 steps, which gives the same colours as the table from makePalette().
+	 *
+	 * \param[out] image 	the image to be blended into.
+	 * \param[in] levels 	array of one coverage level from 0 to 255 for each pixel of the image.
+	 * \param[in] colour 	the line colour as an ARGB8888 pixel.
+	 */
+
+	Uint32 *pixels = image->pixels;
+	size_t count = (size_t)image->width*image->height;
+	Uint32 colour_rb = colour & 0x00ff00ff;
+	Uint32 colour_g = colour & 0x0000ff00;
+	Uint32 rb = 0;
+	Uint32 g = 0;
+	Uint32 level = 0;
+	size_t i = 0;
+
+	for (i = 0; i < count; i++){
+		level = levels[i];
+		if (level == 0)
+			continue;
+
+		rb = (pixels[i] & 0x00ff00ff)*(255-level) + colour_rb*level + 0x00800080;
+		g = (pixels[i] & 0x0000ff00)*(255-level) + colour_g*level + 0x00008000;
+		rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+		g = ((g + ((g >> 8) & 0x0000ff00)) >> 8) & 0x0000ff00;
+		pixels[i] = (pixels[i] & 0xff000000) | rb | g;
+	}
+}
+
+void rasterFractal(raster_image *image, line *line_list, int length, double scale, coordinate offset, SDL_Colour line_colour, int antialias){
+	/**
+	 * \brief Draws a line list to an image, scaling and moving each line as it is drawn.
+	 *
+	 * Each point is drawn at offset + scale*point, so a line list made with a line length of 1
+	 * can be drawn at any size without making a placed copy of it. Anti-aliased lines are drawn
+	 * into coverage levels for the whole image, which are then blended over it in one pass, and
+	 * are drawn aliased if the levels cannot be allocated.
+	 *
+	 * \param[out] image 		the image to be drawn to.
+	 * \param[in] line_list 	the lines to be drawn.
+	 * \param[in] length 		number of lines in the line list.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] line_colour 	colour for the lines to be drawn.
+	 * \param[in] antialias 	true to draw anti-aliased lines with rasterLineAA().
+	 */
+
+	Uint32 colour = rasterColour(line_colour);
+	Uint8 *levels = NULL;
+	coordinate start;
+	coordinate end;
+	int i = 0;
+
+	if (antialias){
+		levels = (Uint8*)calloc((size_t)image->width*image->height, sizeof(Uint8));
+		if (levels == NULL)
+			printf("coverage memory allocation failed, drawing aliased lines\n");
+	}
+
+	for (i = 0; i < length; i++){
+		start.x_pos = offset.x_pos + scale*line_list[i].start.x_pos;
+		start.y_pos = offset.y_pos + scale*line_list[i].start.y_pos;
+		end.x_pos = offset.x_pos + scale*line_list[i].end.x_pos;
+		end.y_pos = offset.y_pos + scale*line_list[i].end.y_pos;
+		if (levels != NULL)
+			rasterLineAA(image, levels, start, end);
+		else
+			rasterLine(image, start, end, colour);
+	}
+
+	if (levels != NULL){
+		blendCoverage(image, levels, colour);
+		free(levels);
+	}
+}
+
+void fitLines(line *line_list, int length, int width, int height, int margin, double *scale, coordinate *offset){
+	/**
+	 * \brief Finds the scale and offset that fit a line list inside an image of the given size.
+	 *
+	 * The bounding box of the lines is scaled to fill the image, less a margin on every side,
+	 * without changing its shape, and is centred in the image.
+	 *
+	 * \param[in] line_list 	the lines to be fitted.
+	 * \param[in] length 		number of lines in the line list.
+	 * \param[in] width 		width of the image in pixels.
+	 * \param[in] height 		height of the image in pixels.
+	 * \param[in] margin 		number of pixels to leave empty around the lines.
+	 * \param[out] scale 		how much to scale each point by.
+	 * \param[out] offset 		where to move the origin of the line list to.
+	 */
+
+	coordinate min;
+	coordinate max;
+	double x_scale = 0;
+	double y_scale = 0;
+	int i = 0;
+
+	structInitCoord(&min);
+	structInitCoord(&max);
+	if (length > 0){
+		min = line_list[0].start;
+		max = line_list[0].start;
+	}
+
+	//finding the bounding box of the lines
+	for (i = 0; i < length; i++){
+		min.x_pos = fmin(min.x_pos, fmin(line_list[i].start.x_pos, line_list[i].end.x_pos));
+		min.y_pos = fmin(min.y_pos, fmin(line_list[i].start.y_pos, line_list[i].end.y_pos));
+		max.x_pos = fmax(max.x_pos, fmax(line_list[i].start.x_pos, line_list[i].end.x_pos));
+		max.y_pos = fmax(max.y_pos, fmax(line_list[i].start.y_pos, line_list[i].end.y_pos));
+	}
+
+	//using the tighter of the two directions, ignoring a direction the lines do not move in
+	x_scale = max.x_pos > min.x_pos ? (width - 2*margin)/(max.x_pos - min.x_pos) : HUGE_VAL;
+	y_scale = max.y_pos > min.y_pos ? (height - 2*margin)/(max.y_pos - min.y_pos) : HUGE_VAL;
+	*scale = fmin(x_scale, y_scale);
+	if (*scale == HUGE_VAL || *scale <= 0)
+		*scale = 1;
+
+	offset->x_pos = width/2.0 - *scale*(min.x_pos + max.x_pos)/2;
+	offset->y_pos = height/2.0 - *scale*(min.y_pos + max.y_pos)/2;
+}
+
+int saveRaster(raster_image *image, char *name){
+	/**
+	 * \brief Saves an image as a bmp file.
+	 *
+	 * \param[in] image 	the image to be saved.
+	 * \param[in] name 		file name for the image.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	int saved = 0;
+	SDL_Surface *out = SDL_CreateRGBSurfaceFrom(image->pixels, image->width, image->height, 32, image->width*sizeof(Uint32), 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+
+	if (out == NULL){
+		printf("Could not make surface for %s: %s\n", name, SDL_GetError());
+		return 0;
+	}
+
+	saved = SDL_SaveBMP(out, name) == 0;
+	if (!saved)
+		printf("Could not save %s: %s\n", name, SDL_GetError());
+
+	SDL_FreeSurface(out);
+	return saved;
+}
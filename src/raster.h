@@ -0,0 +1,54 @@
+#ifndef _RASTER_H_
+#define _RASTER_H_
+
+/*
+ * Allocates the pixels of an image.
+ */
+int initRaster(raster_image *image, int width, int height);
+
+/*
+ * Frees the pixels of an image.
+ */
+void freeRaster(raster_image *image);
+
+/*
+ * Packs a colour into an ARGB8888 pixel.
+ */
+Uint32 rasterColour(SDL_Colour colour);
+
+/*
+ * Fills an image with a single colour.
+ */
+void clearRaster(raster_image *image, SDL_Colour colour);
+
+/*
+ * Draws a line to an image with the bresenham line drawing algorithm.
+ */
+void rasterLine(raster_image *image, coordinate start, coordinate end, Uint32 colour);
+
+/*
+ * Draws an anti-aliased line into the coverage levels of an image with Xiaolin Wu's algorithm.
+ */
+void rasterLineAA(raster_image *image, Uint8 *levels, coordinate start, coordinate end);
+
+/*
+ * Blends a colour over each pixel of an image by its coverage level.
+ */
+void blendCoverage(raster_image *image, Uint8 *levels, Uint32 colour);
+
+/*
+ * Draws a line list to an image, scaling and moving each line as it is drawn.
+ */
+void rasterFractal(raster_image *image, line *line_list, int length, double scale, coordinate offset, SDL_Colour line_colour, int antialias);
+
+/*
+ * Finds the scale and offset that fit a line list inside an image of the given size.
+ */
+void fitLines(line *line_list, int length, int width, int height, int margin, double *scale, coordinate *offset);
+
+/*
+ * Saves an image as a bmp file.
+ */
+int saveRaster(raster_image *image, char *name);
+
+#endif
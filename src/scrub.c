@@ -0,0 +1,338 @@
+/**
+ * \file scrub.c
+ *
+ * \brief A source file for dragging the angle and line length of the fractal on the drawing
+ * screen, with the fractal following the mouse.
+ *
+ * Neither setting changes the string, so a drag never remakes it. A change of line length
+ * only scales and moves a line list made with a line length of 1, which is kept for the
+ * whole drag. A change of angle runs the turtle over the string again, which is done on the
+ * drawing screen's thread so the fractal changes on the same frame as the mouse. The turtle
+ * is timed on each run, and if running it over the whole string would take longer than the
+ * budget for a frame, it is run over a string made at a lower depth instead, which is kept
+ * until the drag ends. The depth is picked from the expected length of each depth's string
+ * from stringLength(), so only the one string picked is made. When the drag ends with a preview on screen, the line list is remade
+ * at full depth in the usual way. Nothing is remade while the worker thread is still making
+ * the string for a new depth, so a line list is never made from the old depth's string.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "seek.h"
+#include "worker.h"
+#include "timing.h"
+#include "scrub.h"
+
+
+/*
+ * Makes the unit line list from the line list on screen, undoing its line length and start point.
+ */
+static int unplaceLines(scrub_state *scrub, lsystem *lsys);
+
+/*
+ * Returns the deepest string the turtle is expected to get through within the budget.
+ */
+static char *scrubString(scrub_state *scrub, lsystem *lsys, double budget, int *depth);
+
+/*
+ * Runs the turtle over a string at the lsystem's angle to make the unit line list, timing it.
+ */
+static int scrubTurtle(scrub_state *scrub, lsystem *lsys, double budget);
+
+
+void startScrub(scrub_state *scrub, lsystem *lsys, gen_worker *worker, int setting){
+	/**
+	 * \brief Starts dragging the angle or line length.
+	 *
+	 * When the line length is dragged and the line list on screen is up to date, it is turned
+	 * back into a unit line list here, before the length changes, so the drag never needs the
+	 * turtle.
+	 *
+	 * \param[out] scrub 	the scrub state, which should not be in a drag.
+	 * \param[in] lsys 		lsystem being drawn.
+	 * \param[in] worker 	worker thread, checked for a line list still being made.
+	 * \param[in] setting 	SCRUB_ANGLE or SCRUB_LENGTH.
+	 */
+
+	freeScrub(scrub);
+	scrub->active = setting;
+
+	if (setting == SCRUB_LENGTH && lsys->line_list != NULL && !workerBusy(worker) && !lsys->remake_lines_flag && !lsys->remake_string_flag)
+		unplaceLines(scrub, lsys);
+}
+
+int scrubMotion(scrub_state *scrub, lsystem *lsys, int x_rel){
+	/**
+	 * \brief Changes the setting being dragged by a horizontal movement of the mouse.
+	 *
+	 * The angle changes by SCRUB_ANGLE_STEP degrees a pixel and is kept between 0 and 180
+	 * degrees. The line length changes by 1 every SCRUB_LENGTH_STEP pixels and is kept between
+	 * 1 and 20, as it is by the line length buttons.
+	 *
+	 * \param[out] scrub 	the scrub state.
+	 * \param[out] lsys 		lsystem whose angle or line length is changed.
+	 * \param[in] x_rel 		pixels the mouse moved to the right, negative to the left.
+	 *
+	 * \return 				1 if the setting changed, 0 if not.
+	 */
+
+	double degrees = 0;
+	int length = lsys->length;
+
+	if (scrub->active == SCRUB_ANGLE){
+		degrees = rtod(lsys->angle) + x_rel*SCRUB_ANGLE_STEP;
+		degrees = degrees < 0 ? 0 : (degrees > 180 ? 180 : degrees);
+
+		//keeping the angle to a tenth of a degree so values like 25.7 can be reached exactly
+		degrees = (int)(degrees*10 + 0.5)/10.0;
+		if (dtor(degrees) == lsys->angle)
+			return 0;
+		lsys->angle = dtor(degrees);
+	}
+	else if (scrub->active == SCRUB_LENGTH){
+		scrub->drag += x_rel;
+		length += scrub->drag/SCRUB_LENGTH_STEP;
+		scrub->drag %= SCRUB_LENGTH_STEP;
+		length = length < 1 ? 1 : (length > 20 ? 20 : length);
+		if (length == lsys->length)
+			return 0;
+		lsys->length = length;
+	}
+	else
+		return 0;
+
+	scrub->changed = 1;
+	return 1;
+}
+
+int applyScrub(scrub_state *scrub, lsystem *lsys, gen_worker *worker, double budget){
+	/**
+	 * \brief Remakes the line list for a changed angle or line length, at a lower depth if the full depth would not fit in the budget.
+	 *
+	 * Called once a frame, so however many times the mouse moved since the last frame, the line
+	 * list is only remade once. Any job on the worker thread is cancelled, as its line list would
+	 * be for the angle or line length from before the drag. While the worker is still making a
+	 * string for a new depth, the string held is for the old depth, so nothing is remade and the
+	 * job is left to finish. The change stays unapplied until the new string is collected, or is
+	 * remade from it when the drag ends.
+	 *
+	 * \param[out] scrub 	the scrub state.
+	 * \param[out] lsys 		lsystem given the new line list.
+	 * \param[out] worker 	worker thread, whose jobs are cancelled.
+	 * \param[in] budget 	time in milliseconds the turtle is expected to finish within.
+	 *
+	 * \return 				1 if the line list was remade, 0 if not.
+	 */
+
+	if (scrub->active == SCRUB_NONE || !scrub->changed || worker->string_outstanding)
+		return 0;
+
+	cancelJobs(worker);
+
+	//only running the turtle when the angle has changed
+	if ((scrub->unit_lines == NULL || scrub->unit_angle != lsys->angle) && !scrubTurtle(scrub, lsys, budget))
+		return 0;
+
+	if (!placeLines(lsys, scrub->unit_lines, scrub->unit_length))
+		return 0;
+
+	scrub->changed = 0;
+	return 1;
+}
+
+void finishScrub(scrub_state *scrub, lsystem *lsys){
+	/**
+	 * \brief Ends a drag, asking for the full depth line list if a preview is on screen.
+	 *
+	 * The line list is also remade if the last change of the drag has not been applied. Either
+	 * way it is remade by the geometry cache or the worker thread, from the string already held.
+	 *
+	 * \param[out] scrub 	the scrub state, freed.
+	 * \param[out] lsys 		lsystem being drawn.
+	 */
+
+	if (scrub->active == SCRUB_NONE)
+		return;
+
+	if (scrub->changed || (scrub->unit_lines != NULL && scrub->unit_depth < lsys->iterations))
+		lsys->remake_lines_flag = 1;
+
+	freeScrub(scrub);
+}
+
+void freeScrub(scrub_state *scrub){
+	/**
+	 * \brief Frees the lines and strings held by a scrub state.
+	 *
+	 * The time the turtle takes for each character is kept for the next drag.
+	 *
+	 * \param[out] scrub 	the scrub state, left out of a drag.
+	 */
+
+	double char_cost = scrub->char_cost;
+
+	free(scrub->unit_lines);
+	free(scrub->preview_string);
+	structInitScrubState(scrub);
+	scrub->char_cost = char_cost;
+}
+
+static int unplaceLines(scrub_state *scrub, lsystem *lsys){
+	/**
+	 * \brief Makes the unit line list from the line list on screen, undoing its line length and start point.
+	 *
+	 * \param[out] scrub 	the scrub state, given the unit lines.
+	 * \param[in] lsys 		lsystem holding a line list placed at its line length and start point.
+	 *
+	 * \return 				1 if sucessfull, 0 if there are no lines or memory allocation failed.
+	 */
+
+	int i = 0;
+	double scale = 1.0/lsys->length;
+	coordinate start = lsys->start;
+	line *lines = lsys->line_list;
+
+	//an empty line list is left for the turtle to make again, as no unit lines means none were made
+	if (lsys->line_list_length == 0)
+		return 0;
+
+	scrub->unit_lines = (line*)malloc(lsys->line_list_length*sizeof(line));
+	if (scrub->unit_lines == NULL){
+		printf("memory allocation for line list failed\n");
+		return 0;
+	}
+
+	for (i = 0; i < lsys->line_list_length; i++){
+		scrub->unit_lines[i].start.x_pos = (lines[i].start.x_pos - start.x_pos)*scale;
+		scrub->unit_lines[i].start.y_pos = (lines[i].start.y_pos - start.y_pos)*scale;
+		scrub->unit_lines[i].end.x_pos = (lines[i].end.x_pos - start.x_pos)*scale;
+		scrub->unit_lines[i].end.y_pos = (lines[i].end.y_pos - start.y_pos)*scale;
+	}
+
+	scrub->unit_length = lsys->line_list_length;
+	scrub->unit_angle = lsys->angle;
+	scrub->unit_depth = lsys->iterations;
+	return 1;
+}
+
+static char *scrubString(scrub_state *scrub, lsystem *lsys, double budget, int *depth){
+	/**
+	 * \brief Returns the deepest string the turtle is expected to get through within the budget.
+	 *
+	 * The lsystem's own string is used if it fits, and then the preview string kept from earlier
+	 * in the drag. If neither fits, the deepest lower depth whose string is expected to fit is
+	 * found from the lengths given by stringLength(), down to a depth of 1, and only the string
+	 * for that depth is made, to be kept for the rest of the drag.
+	 *
+	 * \param[out] scrub 	the scrub state, which holds the preview string.
+	 * \param[in] lsys 		lsystem holding the string and rules.
+	 * \param[in] budget 	time in milliseconds the turtle is expected to finish within.
+	 * \param[out] depth 	depth of the string returned.
+	 *
+	 * \return 				the string, or NULL if the lsystem has no string or memory allocation failed.
+	 */
+
+	lsystem preview;
+	int target = 0;
+
+	if (lsys->string == NULL)
+		return NULL;
+
+	if (strlen(lsys->string)*scrub->char_cost <= budget){
+		*depth = lsys->iterations;
+		return lsys->string;
+	}
+
+	//keeping the preview string while it fits, or when it is already as shallow as it goes
+	if (scrub->preview_string != NULL && (scrub->preview_chars*scrub->char_cost <= budget || scrub->preview_depth <= 1)){
+		*depth = scrub->preview_depth;
+		return scrub->preview_string;
+	}
+
+	//finding the deepest lower depth expected to fit, without making any strings
+	target = (scrub->preview_string == NULL ? lsys->iterations : scrub->preview_depth) - 1;
+	while (target > 1 && stringLength(lsys, target)*scrub->char_cost > budget)
+		target--;
+	if (target < 1){
+		*depth = lsys->iterations;
+		return lsys->string;
+	}
+
+	//making the string for that depth only, the rules are copied but nothing else is shared
+	free(scrub->preview_string);
+	scrub->preview_string = NULL;
+	preview = *lsys;
+	preview.iterations = target;
+	preview.string = NULL;
+	preview.line_list = NULL;
+	preview.cancel_flag = NULL;
+	preview.progress = NULL;
+	if (!makeString(&preview))
+		return NULL;
+
+	scrub->preview_string = preview.string;
+	scrub->preview_chars = strlen(preview.string);
+	scrub->preview_depth = target;
+	*depth = target;
+	return scrub->preview_string;
+}
+
+static int scrubTurtle(scrub_state *scrub, lsystem *lsys, double budget){
+	/**
+	 * \brief Runs the turtle over a string at the lsystem's angle to make the unit line list, timing it.
+	 *
+	 * The time taken for each character is kept, so the next string is picked from how long the
+	 * turtle really takes on this computer. Very short strings are not timed, as the time is
+	 * mostly overhead.
+	 *
+	 * \param[out] scrub 	the scrub state, given the unit lines.
+	 * \param[in] lsys 		lsystem holding the string, rules and angle.
+	 * \param[in] budget 	time in milliseconds the turtle is expected to finish within.
+	 *
+	 * \return 				1 if sucessfull, 0 if there is no string or memory allocation failed.
+	 */
+
+	lsystem unit;
+	Uint64 start_time = 0;
+	double elapsed = 0;
+	size_t chars = 0;
+	int depth = 0;
+	char *string = scrubString(scrub, lsys, budget, &depth);
+
+	if (string == NULL)
+		return 0;
+
+	//running the turtle on a copy made with a line length of 1 from (0, 0)
+	unit = *lsys;
+	unit.string = string;
+	unit.line_list = NULL;
+	unit.cancel_flag = NULL;
+	unit.progress = NULL;
+	unit.length = 1;
+	unit.start.x_pos = 0;
+	unit.start.y_pos = 0;
+
+	start_time = SDL_GetPerformanceCounter();
+	unit.line_list_length = stringToTurtle(&unit);
+	elapsed = millisecondsSince(start_time);
+	if (unit.line_list == NULL)
+		return 0;
+
+	chars = strlen(string);
+	if (chars >= 4096)
+		scrub->char_cost = elapsed/chars;
+
+	free(scrub->unit_lines);
+	scrub->unit_lines = unit.line_list;
+	scrub->unit_length = unit.line_list_length;
+	scrub->unit_angle = lsys->angle;
+	scrub->unit_depth = depth;
+	return 1;
+}
@@ -0,0 +1,37 @@
+#ifndef _SCRUB_H_
+#define _SCRUB_H_
+
+/** \brief Time in milliseconds the drawing screen spends remaking the line list each frame of a drag.*/
+#define SCRUB_BUDGET 8
+/** \brief Degrees the angle changes by for each pixel dragged.*/
+#define SCRUB_ANGLE_STEP 0.1
+/** \brief Pixels dragged for each step of the line length.*/
+#define SCRUB_LENGTH_STEP 10
+
+
+/*
+ * Starts dragging the angle or line length.
+ */
+void startScrub(scrub_state *scrub, lsystem *lsys, gen_worker *worker, int setting);
+
+/*
+ * Changes the setting being dragged by a horizontal movement of the mouse.
+ */
+int scrubMotion(scrub_state *scrub, lsystem *lsys, int x_rel);
+
+/*
+ * Remakes the line list for a changed angle or line length, at a lower depth if the full depth would not fit in the budget.
+ */
+int applyScrub(scrub_state *scrub, lsystem *lsys, gen_worker *worker, double budget);
+
+/*
+ * Ends a drag, asking for the full depth line list if a preview is on screen.
+ */
+void finishScrub(scrub_state *scrub, lsystem *lsys);
+
+/*
+ * Frees the lines and strings held by a scrub state.
+ */
+void freeScrub(scrub_state *scrub);
+
+#endif
@@ -0,0 +1,614 @@
+/**
+ * \file seek.c
+ *
+ * \brief A source file for functions used to jump to any line of an lsystem without
+ * generating the string or the lines that come before it.
+ *
+ * For every symbol and every depth up to the fractal depth, the number of lines the
+ * symbol expands to and the net movement of the turtle across that expansion are
+ * stored in a table. Walking down from the axiom, any expansion that lies completely
+ * before the line being looked for can then be stepped over in one go by applying its
+ * net movement, so only one path down the derivation tree is ever expanded. This lets
+ * the lines in a range [a, b) be made independently of the rest, so the work of
+ * drawing a large fractal can be shared out between threads or processes. shardTurtle()
+ * does this for a headless job given threads=, and the benchmark suite uses checkRange()
+ * to make sure a range matches the same lines made by stringToTurtle(). stringLength()
+ * works out the length of the string one depth at a time in the same way, for the memory
+ * estimates of the batch runner and the speculative scheduler.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "turtle.h"
+#include "lsys.h"
+#include "trace.h"
+#include "seek.h"
+
+
+/*
+ * Returns the aggregate for a character at a depth in the table.
+ */
+static seg_aggregate *getAggregate(seek_table *table, int depth, char character);
+
+/*
+ * Appends the movement in one closed aggregate to the end of another.
+ */
+static void composeAggregate(seg_aggregate *total, seg_aggregate *next);
+
+/*
+ * Combines the aggregates for a replacement string into the aggregate for the symbol it replaces.
+ */
+static void combineRule(seek_table *table, int depth, char *rule, seg_aggregate *out);
+
+/*
+ * Walks through the expansion of a string of symbols, skipping and then writing out lines.
+ */
+static int walkSymbols(lsystem *lsys, seek_table *table, seek_walk *walk, char *symbols, int depth);
+
+/*
+ * Frees any turtle states left on the stack at the end of a walk.
+ */
+static void freeStack(turtle_state **root);
+
+/*
+ * Makes one share of a line list, as the body of a thread.
+ */
+static int shardThread(void *data);
+
+
+int makeSeekTable(lsystem *lsys, seek_table *table){
+	/**
+	 * \brief Builds the table of aggregates for every symbol at every depth up to the fractal depth.
+	 *
+	 * Depth 0 holds the action of each character on its own. Each deeper level is then made by
+	 * combining the aggregates one level up for the characters in that symbol's replacement
+	 * string, so the whole table takes O(depth x rule length) work for each symbol. Movement is
+	 * stored for a line length of 1 so the same table works for any line length, but the table
+	 * has to be rebuilt if the rules, angle or depth change.
+	 *
+	 * \param[in] lsys 		lsystem that holds the rules, angle and depth.
+	 * \param[out] table 	the table to be filled.
+	 *
+	 * \return 				1 if sucessfull, 0 if memory allocation failed.
+	 */
+
+	int depth = 0;
+	int i = 0;
+	char *rule = NULL;
+	seg_aggregate *agg = NULL;
+
+	//allocating and checking memory for the table
+	table->aggregates = (seg_aggregate*)calloc((lsys->iterations+1)*SEEK_SYMBOLS, sizeof(seg_aggregate));
+	if (table->aggregates == NULL){
+		printf("memory allocation for seek table failed\n");
+		return 0;
+	}
+	table->depth = lsys->iterations;
+	table->angle = lsys->angle;
+
+	//depth 0 is the action of each character on the turtle, calloc has already made
+	//every character a closed aggregate that does nothing
+	for (i = 0; i < SEEK_SYMBOLS; i++){
+		agg = &(table->aggregates[i]);
+		switch(i){
+			case 'A':
+			case 'B':
+			case 'F': agg->segments = 1; agg->dy = -1; break;
+			case 'f': agg->dy = -1; break;
+			case '+': agg->heading = lsys->angle; break;
+			case '-': agg->heading = -lsys->angle; break;
+			case '[': agg->kind = AGG_PUSH; break;
+			case ']': agg->kind = AGG_POP; break;
+			default : break;
+		}
+	}
+
+	//each deeper level is made from the level above, characters without a rule are
+	//dropped by iteration() so they are left as aggregates that do nothing
+	for (depth = 1; depth <= table->depth; depth++){
+		for (i = 0; i < SEEK_SYMBOLS; i++){
+			rule = getRule(lsys, (char)i);
+			if (rule != NULL)
+				combineRule(table, depth-1, rule, &(table->aggregates[depth*SEEK_SYMBOLS + i]));
+		}
+	}
+
+	return 1;
+}
+
+void freeSeekTable(seek_table *table){
+	/**
+	 * \brief Frees the aggregates held by a seek table.
+	 *
+	 * \param[out] table 	the table to be freed.
+	 */
+
+	free(table->aggregates);
+	table->aggregates = NULL;
+}
+
+long long totalSegments(lsystem *lsys, seek_table *table){
+	/**
+	 * \brief Adds up the number of lines drawn by each character of the axiom at full depth.
+	 *
+	 * This is the length the line list would have after stringToTurtle(), found without
+	 * making the string. Very deep lsystems are capped at LLONG_MAX.
+	 *
+	 * \param[in] lsys 		lsystem that holds the axiom.
+	 * \param[in] table 	table built for the lsystem.
+	 *
+	 * \return 				the total number of lines.
+	 */
+
+	int i = 0;
+	long long total = 0;
+	long long segments = 0;
+
+	for (i = 0; lsys->axiom[i] != 0; i++){
+		segments = getAggregate(table, table->depth, lsys->axiom[i])->segments;
+		total = (total > LLONG_MAX - segments) ? LLONG_MAX : total + segments;
+	}
+
+	return total;
+}
+
+double stringLength(lsystem *lsys, int depth){
+	/**
+	 * \brief Returns the length of the string an lsystem makes at a given depth, without making it.
+	 *
+	 * Every character grows the same way wherever it is in the string, so the length each
+	 * character grows to is worked out one depth at a time from the lengths at the depth before.
+	 * Characters without a rule are dropped by iteration(), so they have a length of 0 from a
+	 * depth of 1 on. Doubles are used so that very deep lsystems give a huge length rather than
+	 * overflowing.
+	 *
+	 * \param[in] lsys 		the lsystem.
+	 * \param[in] depth 	the fractal depth.
+	 *
+	 * \return 				the number of characters in the string, not counting its terminating null.
+	 */
+
+	double lengths[SEEK_SYMBOLS];
+	double next[SEEK_SYMBOLS];
+	double total = 0;
+	char *rule = NULL;
+	int c = 0;
+	int i = 0;
+
+	for (c = 0; c < SEEK_SYMBOLS; c++)
+		lengths[c] = 1;
+
+	for (i = 0; i < depth; i++){
+		for (c = 0; c < SEEK_SYMBOLS; c++){
+			rule = getRule(lsys, c);
+			if (rule == NULL){
+				next[c] = 0;
+				continue;
+			}
+			for (next[c] = 0; *rule != '\0'; rule++)
+				next[c] += lengths[*rule & (SEEK_SYMBOLS-1)];
+		}
+		memcpy(lengths, next, sizeof(lengths));
+	}
+
+	for (rule = lsys->axiom; *rule != '\0'; rule++)
+		total += lengths[*rule & (SEEK_SYMBOLS-1)];
+
+	return total;
+}
+
+int seekSegment(lsystem *lsys, seek_table *table, long long index, turtle_state *turtle){
+	/**
+	 * \brief Finds the position and heading of the turtle just before it draws the line at index.
+	 *
+	 * \param[in] lsys 		lsystem that holds the axiom, rules, start point and line length.
+	 * \param[in] table 	table built for the lsystem.
+	 * \param[in] index 	index of the line in the order stringToTurtle() would produce them.
+	 * \param[out] turtle 	the turtle state at that line (the next pointer is left as NULL).
+	 *
+	 * \return 				1 if the line exists, 0 if index is past the end of the line list.
+	 */
+
+	int found = 0;
+	seek_walk walk;
+	structInitSeekWalk(&walk);
+
+	walk.skip = index;
+	walk.emit = 1;
+	walk.turtle.pos = lsys->start;
+
+	found = walkSymbols(lsys, table, &walk, lsys->axiom, table->depth);
+	freeStack(&(walk.root));
+
+	*turtle = walk.turtle;
+	turtle->next = NULL;
+	return found;
+}
+
+long long rangeToTurtle(lsystem *lsys, seek_table *table, long long first, long long last, line *out){
+	/**
+	 * \brief Writes the lines with indexes in the range [first, last) to an array.
+	 *
+	 * The lines before first are stepped over using the table, and the turtle stack at that
+	 * point is rebuilt along the way so that brackets closed inside the range still return the
+	 * turtle to the right place. Nothing is written to the lsystem and the table is only read,
+	 * so any number of ranges can be made at the same time from different threads.
+	 *
+	 * \param[in] lsys 		lsystem that holds the axiom, rules, start point and line length.
+	 * \param[in] table 	table built for the lsystem.
+	 * \param[in] first 	index of the first line to be written.
+	 * \param[in] last 		index one past the last line to be written.
+	 * \param[out] out 		array with room for at least (last - first) lines.
+	 *
+	 * \return 				the number of lines written, which is less than asked for if last is past the end.
+	 */
+
+	seek_walk walk;
+	structInitSeekWalk(&walk);
+
+	if (last <= first)
+		return 0;
+
+	walk.skip = first;
+	walk.emit = last - first;
+	walk.out = out;
+	walk.turtle.pos = lsys->start;
+
+	walkSymbols(lsys, table, &walk, lsys->axiom, table->depth);
+	freeStack(&(walk.root));
+
+	return walk.out_pos;
+}
+
+int shardTurtle(lsystem *lsys, int thread_count){
+	/**
+	 * \brief Makes the line list in shares on several threads with rangeToTurtle(), without generating the string.
+	 *
+	 * The number of lines is found from the seek table, the line list is allocated once and each
+	 * thread makes an equal share of it straight into its place. A share whose thread could not
+	 * be started is made on this thread. The lines match those made by stringToTurtle() to within
+	 * SEEK_TOLERANCE of a line length, as the turtle is moved over the lines before each share in
+	 * larger steps. The old line list is replaced as stringToTurtle() would replace it.
+	 *
+	 * \param[out] lsys 			lsystem that holds the axiom, rules, start point and line length, and is given the line list.
+	 * \param[in] thread_count 	number of threads to share the lines between.
+	 *
+	 * \return 					the number of lines, with the line list left as NULL if it could not be made or has no lines.
+	 */
+
+	seek_table table;
+	turtle_shard *shards = NULL;
+	SDL_Thread **threads = NULL;
+	line *line_list = NULL;
+	long long total = 0;
+	long long written = 0;
+	Uint64 trace_begin = traceBegin(lsys->trace);
+	int i = 0;
+
+	structInitSeekTable(&table);
+	free(lsys->line_list);
+	lsys->line_list = NULL;
+	lsys->geometry_version++;
+
+	if (thread_count < 1)
+		thread_count = 1;
+
+	//finding the number of lines and allocating the whole line list up front
+	if (!makeSeekTable(lsys, &table))
+		return 0;
+	total = totalSegments(lsys, &table);
+	if (total < 0 || total > INT_MAX){
+		printf("line list of %lld lines is too long\n", total);
+		freeSeekTable(&table);
+		return 0;
+	}
+	if (total < thread_count)
+		thread_count = total > 0 ? (int)total : 1;
+
+	line_list = (line*)calloc(total, sizeof(line));
+	shards = (turtle_shard*)calloc(thread_count, sizeof(turtle_shard));
+	threads = (SDL_Thread**)calloc(thread_count, sizeof(SDL_Thread*));
+	if ((line_list == NULL && total > 0) || shards == NULL || threads == NULL){
+		printf("memory allocation for line list failed\n");
+		free(line_list);
+		free(shards);
+		free(threads);
+		freeSeekTable(&table);
+		return 0;
+	}
+
+	//giving each thread an equal share of the lines
+	for (i = 0; i < thread_count; i++){
+		structInitTurtleShard(&(shards[i]));
+		shards[i].lsys = lsys;
+		shards[i].table = &table;
+		shards[i].first = total*i/thread_count;
+		shards[i].last = total*(i+1)/thread_count;
+		shards[i].out = line_list + shards[i].first;
+		if (i > 0)
+			threads[i] = SDL_CreateThread(shardThread, "turtle shard", &(shards[i]));
+	}
+
+	//making the first share, and any that could not be given a thread, on this thread
+	for (i = 0; i < thread_count; i++){
+		if (threads[i] == NULL)
+			shardThread(&(shards[i]));
+	}
+	for (i = 0; i < thread_count; i++){
+		if (threads[i] != NULL)
+			SDL_WaitThread(threads[i], NULL);
+		written += shards[i].written;
+	}
+
+	free(shards);
+	free(threads);
+	freeSeekTable(&table);
+
+	if (written != total){
+		printf("line list was not fully made\n");
+		free(line_list);
+		return 0;
+	}
+
+	lsys->line_list = line_list;
+	traceEnd(lsys->trace, "shardTurtle", trace_begin);
+	return (int)total;
+}
+
+int checkRange(lsystem *lsys, seek_table *table, long long first, long long last){
+	/**
+	 * \brief Checks that the lines made by rangeToTurtle() for a range match the same range of the lsystem's line list.
+	 *
+	 * The line list is expected to have been made by stringToTurtle() with a line length of 1.
+	 * Lines match if every coordinate is within SEEK_TOLERANCE, as the lines made by seeking
+	 * can differ from the turtle's in the last few bits.
+	 *
+	 * \param[in] lsys 		lsystem that holds the line list made by stringToTurtle().
+	 * \param[in] table 	table built for the lsystem.
+	 * \param[in] first 	index of the first line to be checked.
+	 * \param[in] last 		index one past the last line to be checked, at most the length of the line list.
+	 *
+	 * \return 				1 if every line matches, 0 if one does not or memory allocation failed.
+	 */
+
+	line *range = NULL;
+	line *expected = NULL;
+	long long written = 0;
+	long long i = 0;
+	int matches = 1;
+
+	if (last <= first)
+		return 1;
+
+	range = (line*)calloc(last - first, sizeof(line));
+	if (range == NULL){
+		printf("memory allocation for range failed\n");
+		return 0;
+	}
+
+	written = rangeToTurtle(lsys, table, first, last, range);
+	matches = written == last - first;
+	for (i = 0; matches && i < written; i++){
+		expected = &(lsys->line_list[first + i]);
+		matches = fabs(range[i].start.x_pos - expected->start.x_pos) <= SEEK_TOLERANCE
+			&& fabs(range[i].start.y_pos - expected->start.y_pos) <= SEEK_TOLERANCE
+			&& fabs(range[i].end.x_pos - expected->end.x_pos) <= SEEK_TOLERANCE
+			&& fabs(range[i].end.y_pos - expected->end.y_pos) <= SEEK_TOLERANCE;
+	}
+
+	free(range);
+	return matches;
+}
+
+static seg_aggregate *getAggregate(seek_table *table, int depth, char character){
+	/**
+	 * \brief Returns the aggregate for a character at a depth in the table.
+	 *
+	 * Characters outside of the 7 bit range have no rules so they share the
+	 * aggregate of the null character, which does nothing.
+	 *
+	 * \param[in] table 		the table to look in.
+	 * \param[in] depth 		depth of the expansion.
+	 * \param[in] character 	the character being expanded.
+	 *
+	 * \return 					pointer to the aggregate.
+	 */
+
+	int symbol = (unsigned char)character;
+
+	if (symbol >= SEEK_SYMBOLS)
+		symbol = 0;
+
+	return &(table->aggregates[depth*SEEK_SYMBOLS + symbol]);
+}
+
+static void composeAggregate(seg_aggregate *total, seg_aggregate *next){
+	/**
+	 * \brief Appends the movement of one closed aggregate to another.
+	 *
+	 * The movement in next is stored as if it started at a heading of 0, so it is rotated by
+	 * the heading reached at the end of total before being added on.
+	 *
+	 * \param[out] total 	the aggregate being added to.
+	 * \param[in] next 		the aggregate that follows it.
+	 */
+
+	double c = cos(total->heading);
+	double s = sin(total->heading);
+
+	total->dx += next->dx*c - next->dy*s;
+	total->dy += next->dx*s + next->dy*c;
+	total->heading += next->heading;
+}
+
+static void combineRule(seek_table *table, int depth, char *rule, seg_aggregate *out){
+	/**
+	 * \brief Combines the aggregates for the characters of a replacement string into one aggregate.
+	 *
+	 * A small stack is kept so that brackets inside the rule can be matched. If the rule pops more
+	 * than it stores, stores more than it pops, or uses an expansion which is already open, the
+	 * result is marked as open and will be walked through instead of stepped over.
+	 *
+	 * \param[in] table 	the table, filled up to depth.
+	 * \param[in] depth 	depth of the characters in the rule.
+	 * \param[in] rule 		the replacement string.
+	 * \param[out] out 		the aggregate for the symbol one level down.
+	 */
+
+	//a rule can store at most one position per character
+	seg_aggregate stack[40];
+	int stack_pos = 0;
+	int i = 0;
+	seg_aggregate *next = NULL;
+
+	//a rule that is a single bracket stays a single bracket at every depth
+	if (strlen(rule) == 1){
+		next = getAggregate(table, depth, rule[0]);
+		if (next->kind == AGG_PUSH || next->kind == AGG_POP){
+			*out = *next;
+			return;
+		}
+	}
+
+	for (i = 0; rule[i] != 0; i++){
+		next = getAggregate(table, depth, rule[i]);
+
+		//line counts are capped rather than allowed to overflow
+		if (out->segments > LLONG_MAX - next->segments)
+			out->segments = LLONG_MAX;
+		else
+			out->segments += next->segments;
+
+		switch(next->kind){
+			case AGG_CLOSED: composeAggregate(out, next); break;
+			case AGG_PUSH: if (stack_pos < 40) stack[stack_pos++] = *out; break;
+			case AGG_POP:
+				if (stack_pos == 0){
+					out->kind = AGG_OPEN;
+				}
+				else {
+					//the line count keeps running across the pop
+					stack_pos--;
+					out->dx = stack[stack_pos].dx;
+					out->dy = stack[stack_pos].dy;
+					out->heading = stack[stack_pos].heading;
+				}
+				break;
+			default : out->kind = AGG_OPEN; break;
+		}
+	}
+
+	if (stack_pos != 0)
+		out->kind = AGG_OPEN;
+}
+
+static int walkSymbols(lsystem *lsys, seek_table *table, seek_walk *walk, char *symbols, int depth){
+	/**
+	 * \brief Walks through the expansion of a string of symbols at a given depth.
+	 *
+	 * Closed expansions that lie completely inside the lines still to be skipped are stepped over
+	 * by moving the turtle by their net movement. Any other expansion is walked into through its
+	 * rule, until at depth 0 the lines themselves are reached and written out. Only the path down
+	 * to the first line wanted is expanded, so reaching any line takes O(depth x rule length) steps.
+	 *
+	 * \param[in] lsys 		lsystem that holds the rules and line length.
+	 * \param[in] table 	table built for the lsystem.
+	 * \param[out] walk 	state of the walk, updated as symbols are passed.
+	 * \param[in] symbols 	string of symbols to walk through.
+	 * \param[in] depth 	how many more times each symbol would be expanded.
+	 *
+	 * \return 				1 once the walk has finished, 0 if the end of the symbols was reached first.
+	 */
+
+	int i = 0;
+	char *rule = NULL;
+	seg_aggregate *agg = NULL;
+	double c = 0;
+	double s = 0;
+
+	for (i = 0; symbols[i] != 0; i++){
+		agg = getAggregate(table, depth, symbols[i]);
+
+		if (agg->kind == AGG_PUSH){
+			savePos(&(walk->root), walk->turtle);
+			continue;
+		}
+		if (agg->kind == AGG_POP){
+			popPos(&(walk->root), &(walk->turtle));
+			continue;
+		}
+
+		//stepping over a closed expansion that is being skipped, or that draws nothing
+		if (agg->kind == AGG_CLOSED && agg->segments <= walk->skip){
+			c = cos(walk->turtle.heading);
+			s = sin(walk->turtle.heading);
+			walk->turtle.pos.x_pos += lsys->length * (agg->dx*c - agg->dy*s);
+			walk->turtle.pos.y_pos += lsys->length * (agg->dx*s + agg->dy*c);
+			walk->turtle.heading += agg->heading;
+			walk->skip -= agg->segments;
+			continue;
+		}
+
+		//a line drawing character that is not being skipped
+		if (depth == 0){
+			//seeking stops just before the line is drawn
+			if (walk->out == NULL)
+				return 1;
+
+			coordinate start = walk->turtle.pos;
+			penUpLine(&(walk->turtle), lsys->length);
+			line new_line = {start, walk->turtle.pos};
+			walk->out[walk->out_pos++] = new_line;
+
+			walk->emit--;
+			if (walk->emit == 0)
+				return 1;
+			continue;
+		}
+
+		//walking into the expansion
+		rule = getRule(lsys, symbols[i]);
+		if (rule != NULL && walkSymbols(lsys, table, walk, rule, depth-1))
+			return 1;
+	}
+
+	return 0;
+}
+
+static void freeStack(turtle_state **root){
+	/**
+	 * \brief Frees any turtle states left on the stack at the end of a walk.
+	 *
+	 * \param[out] root 	pointer pointer to the top of the turtle stack.
+	 */
+
+	turtle_state *temp = NULL;
+
+	while (*root != NULL){
+		temp = *root;
+		*root = (*root)->next;
+		free(temp);
+	}
+}
+
+static int shardThread(void *data){
+	/**
+	 * \brief Makes one share of a line list, as the body of a thread.
+	 *
+	 * \param[out] data 	the turtle_shard to be made, which is given the number of lines written.
+	 *
+	 * \return 				0 when the share has been made.
+	 */
+
+	turtle_shard *shard = (turtle_shard*)data;
+
+	shard->written = rangeToTurtle(shard->lsys, shard->table, shard->first, shard->last, shard->out);
+	return 0;
+}
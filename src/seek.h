@@ -0,0 +1,59 @@
+#ifndef _SEEK_H_
+#define _SEEK_H_
+
+/** \brief Number of symbols held at each depth of a seek table (one for each 7 bit character).*/
+#define SEEK_SYMBOLS 128
+
+/** \brief The expansion moves the turtle but leaves the turtle stack as it found it.*/
+#define AGG_CLOSED 0
+/** \brief The expansion is a single store of the turtle position.*/
+#define AGG_PUSH 1
+/** \brief The expansion is a single pop of the turtle position.*/
+#define AGG_POP 2
+/** \brief The expansion has unbalanced brackets and has to be walked through to be applied.*/
+#define AGG_OPEN 3
+/** \brief Largest difference in any coordinate between a line made by rangeToTurtle() and the same line made by stringToTurtle(), for a line length of 1.*/
+#define SEEK_TOLERANCE 1e-6
+
+
+/*
+ * Builds the per symbol, per depth aggregates for the current rules, angle and depth.
+ */
+int makeSeekTable(lsystem *lsys, seek_table *table);
+
+/*
+ * Frees the aggregates held by a seek table.
+ */
+void freeSeekTable(seek_table *table);
+
+/*
+ * Returns the number of lines the lsystem would draw, without generating the string.
+ */
+long long totalSegments(lsystem *lsys, seek_table *table);
+
+/*
+ * Returns the length of the string an lsystem makes at a given depth, without making it.
+ */
+double stringLength(lsystem *lsys, int depth);
+
+/*
+ * Finds the turtle state just before the line at index is drawn.
+ */
+int seekSegment(lsystem *lsys, seek_table *table, long long index, turtle_state *turtle);
+
+/*
+ * Writes the lines in the range [first, last) to an array, without generating the lines before them.
+ */
+long long rangeToTurtle(lsystem *lsys, seek_table *table, long long first, long long last, line *out);
+
+/*
+ * Makes the line list in shares on several threads with rangeToTurtle(), without generating the string.
+ */
+int shardTurtle(lsystem *lsys, int thread_count);
+
+/*
+ * Checks that the lines made by rangeToTurtle() for a range match the same range of the lsystem's line list.
+ */
+int checkRange(lsystem *lsys, seek_table *table, long long first, long long last);
+
+#endif
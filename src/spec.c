@@ -0,0 +1,249 @@
+/**
+ * \file spec.c
+ *
+ * \brief A source file for the speculative scheduler, which makes the lsystems the
+ * user is likely to ask for next while the program is otherwise idle.
+ *
+ * Whenever a new fractal is shown, a list of candidates is built: the same lsystem
+ * one level deeper and one level shallower, and then the pre defined rule sets at
+ * their default settings, most often picked first. A low priority thread works down
+ * the list and puts each finished string and line list in the geometry cache, where
+ * the drawing screen finds them when the user clicks. Candidates that are already
+ * cached, or that would not fit in the cache budget, are skipped. Large candidates are
+ * written to the geometry store as well, so they are ready on the next run.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "seek.h"
+#include "cache.h"
+#include "store.h"
+#include "spec.h"
+
+
+/*
+ * Main loop of the speculative scheduler thread.
+ */
+static int specThread(void *data);
+
+/*
+ * Returns true if the string and line list for an lsystem would fit in the cache budget.
+ */
+static int fitsBudget(lsystem *lsys, geom_cache *cache);
+
+
+int startSpeculation(spec_scheduler *spec, geom_cache *cache){
+	/**
+	 * \brief Creates the lock and condition for the scheduler and starts its thread.
+	 *
+	 * \param[out] spec 	a scheduler initialised with structInitSpecScheduler().
+	 * \param[in] cache 	the cache that finished candidates are put in.
+	 *
+	 * \return 				1 if sucessfull, 0 if the thread could not be started.
+	 */
+
+	spec->cache = cache;
+	spec->lock = SDL_CreateMutex();
+	spec->wake = SDL_CreateCond();
+	if (spec->lock == NULL || spec->wake == NULL){
+		printf("Could not create speculation lock: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	spec->thread = SDL_CreateThread(specThread, "speculation", spec);
+	if (spec->thread == NULL){
+		printf("Could not start speculation thread: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	return 1;
+}
+
+void stopSpeculation(spec_scheduler *spec){
+	/**
+	 * \brief Drops the candidate being made and waits for the scheduler thread to exit.
+	 *
+	 * \param[out] spec 	the scheduler to be stopped.
+	 */
+
+	if (spec->thread != NULL){
+		SDL_LockMutex(spec->lock);
+		spec->quit = 1;
+		SDL_AtomicSet(&(spec->cancel), 1);
+		SDL_CondSignal(spec->wake);
+		SDL_UnlockMutex(spec->lock);
+		SDL_WaitThread(spec->thread, NULL);
+		spec->thread = NULL;
+	}
+
+	SDL_DestroyCond(spec->wake);
+	SDL_DestroyMutex(spec->lock);
+	spec->wake = NULL;
+	spec->lock = NULL;
+}
+
+void speculate(spec_scheduler *spec, lsystem *lsys){
+	/**
+	 * \brief Replaces the candidates with the lsystems most likely to be asked for next.
+	 *
+	 * The depth buttons are the most common next click, so the lsystem one level deeper and
+	 * one level shallower come first. They are followed by every other pre defined rule set at
+	 * its default settings, ordered by how often each has been picked. The candidate being made
+	 * is dropped, as it may no longer be wanted, and will be picked up again if it is.
+	 *
+	 * \param[out] spec 	the scheduler.
+	 * \param[in] lsys 		the lsystem that has just been drawn.
+	 */
+
+	int order[PRESET_COUNT];
+	int i = 0;
+	int j = 0;
+	int temp = 0;
+	lsystem next;
+
+	SDL_LockMutex(spec->lock);
+	spec->candidate_count = 0;
+	spec->next_candidate = 0;
+
+	//one level deeper and one level shallower, within the same limits as the depth buttons
+	if (lsys->iterations < lsys->iteration_limit){
+		next = *lsys;
+		next.iterations += 1;
+		spec->candidates[spec->candidate_count++] = next;
+	}
+	if (lsys->iterations > 1){
+		next = *lsys;
+		next.iterations -= 1;
+		spec->candidates[spec->candidate_count++] = next;
+	}
+
+	//ordering the pre defined rule sets by how often they have been picked
+	for (i = 0; i < PRESET_COUNT; i++)
+		order[i] = i;
+	for (i = 1; i < PRESET_COUNT; i++){
+		for (j = i; j > 0 && spec->preset_uses[order[j]] > spec->preset_uses[order[j-1]]; j--){
+			temp = order[j];
+			order[j] = order[j-1];
+			order[j-1] = temp;
+		}
+	}
+
+	//each rule set at the settings it has when picked on the options screen
+	for (i = 0; i < PRESET_COUNT && spec->candidate_count < SPEC_MAX_CANDIDATES; i++){
+		structInitLsystem(&next);
+		loadPreset(&next, order[i]);
+		next.trace = lsys->trace;
+		if (strcmp(next.name, lsys->name) != 0)
+			spec->candidates[spec->candidate_count++] = next;
+	}
+
+	//the copies must not share the string and line list being drawn
+	for (i = 0; i < spec->candidate_count; i++){
+		spec->candidates[i].string = NULL;
+		spec->candidates[i].line_list = NULL;
+		spec->candidates[i].line_list_length = 0;
+	}
+
+	SDL_AtomicSet(&(spec->cancel), 1);
+	SDL_CondSignal(spec->wake);
+	SDL_UnlockMutex(spec->lock);
+}
+
+void notePresetUse(spec_scheduler *spec, int index){
+	/**
+	 * \brief Records that a pre defined rule set was picked on the options screen.
+	 *
+	 * \param[out] spec 	the scheduler.
+	 * \param[in] index 	position of the rule set that was picked.
+	 */
+
+	if (index >= 0 && index < PRESET_COUNT)
+		spec->preset_uses[index]++;
+}
+
+static int specThread(void *data){
+	/**
+	 * \brief Works down the list of candidates, putting each one in the cache.
+	 *
+	 * The thread runs at low priority so that it only uses time the rest of the program does
+	 * not. Each candidate is made with the normal makeString() and stringToTurtle() functions,
+	 * checking the cancel flag so that a change of candidates stops it quickly.
+	 *
+	 * \param[in] data 		the spec_scheduler that owns the thread.
+	 *
+	 * \return 				0 when the scheduler is stopped.
+	 */
+
+	spec_scheduler *spec = (spec_scheduler*)data;
+	lsystem job;
+
+	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+	while (1){
+		//waiting for a candidate
+		SDL_LockMutex(spec->lock);
+		while (spec->next_candidate >= spec->candidate_count && !spec->quit)
+			SDL_CondWait(spec->wake, spec->lock);
+
+		if (spec->quit){
+			SDL_UnlockMutex(spec->lock);
+			break;
+		}
+
+		job = spec->candidates[spec->next_candidate++];
+		SDL_AtomicSet(&(spec->cancel), 0);
+		SDL_UnlockMutex(spec->lock);
+
+		if (cacheContains(spec->cache, &job) || !fitsBudget(&job, spec->cache))
+			continue;
+
+		//making the candidate, with a line list of unit length from (0, 0) as the cache holds them
+		job.cancel_flag = &(spec->cancel);
+		job.length = 1;
+		structInitCoord(&(job.start));
+		if (!makeString(&job))
+			continue;
+
+		job.line_list_length = stringToTurtle(&job);
+		if (!jobCancelled(&job) && job.line_list != NULL)
+			storeGeometry(&job, job.string, job.line_list, job.line_list_length);
+		if (jobCancelled(&job) || job.line_list == NULL || !cacheInsert(spec->cache, &job, job.string, job.line_list, job.line_list_length)){
+			free(job.string);
+			free(job.line_list);
+		}
+	}
+
+	return 0;
+}
+
+static int fitsBudget(lsystem *lsys, geom_cache *cache){
+	/**
+	 * \brief Returns true if the string and line list for an lsystem would fit in the cache budget.
+	 *
+	 * The number of lines is found from a seek table and the length of the string from
+	 * stringLength(), without making either, so that candidates too big to keep are skipped
+	 * before any time is spent on them. They are counted as cacheInsert() counts them. Only half
+	 * of the budget is allowed for any one candidate so it cannot push out everything else.
+	 *
+	 * \param[in] lsys 		the candidate.
+	 * \param[in] cache 	the cache it would be put in.
+	 */
+
+	double bytes = sizeof(geom_entry) + stringLength(lsys, lsys->iterations) + 1;
+	seek_table table;
+	structInitSeekTable(&table);
+
+	if (!makeSeekTable(lsys, &table))
+		return 0;
+	bytes += (double)totalSegments(lsys, &table)*sizeof(line);
+	freeSeekTable(&table);
+
+	return bytes <= cache->budget/2;
+}
@@ -0,0 +1,24 @@
+#ifndef _SPEC_H_
+#define _SPEC_H_
+
+/*
+ * Starts the low priority speculative scheduler thread.
+ */
+int startSpeculation(spec_scheduler *spec, geom_cache *cache);
+
+/*
+ * Stops the speculative scheduler thread.
+ */
+void stopSpeculation(spec_scheduler *spec);
+
+/*
+ * Replaces the candidates with the lsystems most likely to be asked for after the one given.
+ */
+void speculate(spec_scheduler *spec, lsystem *lsys);
+
+/*
+ * Records that a pre defined rule set was picked on the options screen.
+ */
+void notePresetUse(spec_scheduler *spec, int index);
+
+#endif
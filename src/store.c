@@ -0,0 +1,282 @@
+/**
+ * \file store.c
+ *
+ * \brief A source file for the geometry store, which keeps large line lists in files
+ * so that they do not have to be made again every time the program is started.
+ *
+ * Each file is named after the hash of the lsystem it holds and starts with a
+ * geom_file_header giving the layout version, the hash, the depth, the angle, the
+ * axiom and rules, the bounding box and the number of lines. The line list follows
+ * the header, made with a line length of 1 from (0, 0) as in the geometry cache, and
+ * the string comes last. Files are opened with mmap, so the geometry cache can point
+ * straight into them and nothing is read until it is drawn.
+ *
+ * Files are written under a temporary name made unique by mkstemp() and renamed into
+ * place when complete, so a file that is half written, or one being written by two
+ * threads or processes at once, is never opened. Files with a different version, a different definition or the wrong size
+ * are ignored and replaced when the geometry is next made. The hash is stored in the
+ * byte order of the machine that wrote it, so files from a machine of the other byte
+ * order do not match either.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "cache.h"
+#include "store.h"
+
+
+/*
+ * Writes the path of the geometry file for a hash into name.
+ */
+static void storePath(char *name, unsigned long long hash);
+
+/*
+ * Fills in the parts of a header that identify the lsystem.
+ */
+static void fillHeader(geom_file_header *header, lsystem *key, unsigned long long hash);
+
+/*
+ * Returns true if a header read from a file matches the one expected.
+ */
+static int headerMatches(geom_file_header *found, geom_file_header *expected);
+
+
+int storeGeometry(lsystem *key, char *string, line *line_list, int line_list_length){
+	/**
+	 * \brief Writes the string and line list for an lsystem to a geometry file in the cache directory.
+	 *
+	 * Line lists shorter than STORE_MIN_LINES are not written, and neither are ones that are
+	 * already stored. The cache directory is made if it does not exist.
+	 *
+	 * \param[in] key 				the lsystem the geometry was made from.
+	 * \param[in] string 			the string.
+	 * \param[in] line_list 		the line list made with a line length of 1 from (0, 0).
+	 * \param[in] line_list_length 	the number of lines in the line list.
+	 *
+	 * \return 						1 if the geometry is stored, 0 if it was not written.
+	 */
+
+	char name[64];
+	char temp_name[96];
+	geom_file_header header;
+	geom_entry stored;
+	FILE *file = NULL;
+	int written = 0;
+	int fd = -1;
+	int i = 0;
+	unsigned long long hash = hashLsystem(key);
+
+	if (line_list_length < STORE_MIN_LINES)
+		return 0;
+
+	if (openStoredGeometry(key, hash, &stored)){
+		closeStoredGeometry(&stored);
+		return 1;
+	}
+
+	if (mkdir(STORE_DIR, 0755) != 0 && errno != EEXIST){
+		printf("Could not make the %s directory\n", STORE_DIR);
+		return 0;
+	}
+
+	//finding the bounding box of the lines
+	fillHeader(&header, key, hash);
+	header.segment_count = line_list_length;
+	header.string_length = strlen(string);
+	header.bbox_min = line_list[0].start;
+	header.bbox_max = line_list[0].start;
+	for (i = 0; i < line_list_length; i++){
+		if (line_list[i].end.x_pos < header.bbox_min.x_pos) header.bbox_min.x_pos = line_list[i].end.x_pos;
+		if (line_list[i].end.y_pos < header.bbox_min.y_pos) header.bbox_min.y_pos = line_list[i].end.y_pos;
+		if (line_list[i].end.x_pos > header.bbox_max.x_pos) header.bbox_max.x_pos = line_list[i].end.x_pos;
+		if (line_list[i].end.y_pos > header.bbox_max.y_pos) header.bbox_max.y_pos = line_list[i].end.y_pos;
+		if (line_list[i].start.x_pos < header.bbox_min.x_pos) header.bbox_min.x_pos = line_list[i].start.x_pos;
+		if (line_list[i].start.y_pos < header.bbox_min.y_pos) header.bbox_min.y_pos = line_list[i].start.y_pos;
+		if (line_list[i].start.x_pos > header.bbox_max.x_pos) header.bbox_max.x_pos = line_list[i].start.x_pos;
+		if (line_list[i].start.y_pos > header.bbox_max.y_pos) header.bbox_max.y_pos = line_list[i].start.y_pos;
+	}
+
+	//writing under a name no other thread or process will use, then renaming the finished file into place
+	storePath(name, hash);
+	sprintf(temp_name, "%s.XXXXXX", name);
+
+	//mkstemp() only lets the owner read the file, which would keep other users from the store
+	fd = mkstemp(temp_name);
+	if (fd >= 0)
+		fchmod(fd, 0644);
+	file = fd < 0 ? NULL : fdopen(fd, "wb");
+	if (file == NULL){
+		printf("Could not write geometry file %s\n", temp_name);
+		if (fd >= 0){
+			close(fd);
+			remove(temp_name);
+		}
+		return 0;
+	}
+
+	written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(line_list, sizeof(line), line_list_length, file) == (size_t)line_list_length
+		&& fwrite(string, 1, header.string_length+1, file) == (size_t)(header.string_length+1);
+
+	if (fclose(file) != 0 || !written || rename(temp_name, name) != 0){
+		printf("Could not write geometry file %s\n", name);
+		remove(temp_name);
+		return 0;
+	}
+
+	return 1;
+}
+
+int openStoredGeometry(lsystem *key, unsigned long long hash, geom_entry *entry){
+	/**
+	 * \brief Maps the geometry file for an lsystem into memory and points the entry at its string and line list.
+	 *
+	 * The file is checked against the lsystem and against its own size before it is used. The
+	 * mapping is read only and private, so the entry must not be written to, and it stays valid
+	 * even if the file is replaced while it is open.
+	 *
+	 * \param[in] key 		the lsystem to look for.
+	 * \param[in] hash 		hash of the lsystem from hashLsystem().
+	 * \param[out] entry 	the entry whose string, line_list, line_list_length, mapping and mapping_size are set.
+	 *
+	 * \return 				1 if the file was found and mapped, 0 if not.
+	 */
+
+	char name[64];
+	geom_file_header expected;
+	geom_file_header *header = NULL;
+	struct stat info;
+	void *mapping = NULL;
+	int file = -1;
+	size_t size = 0;
+	char *string = NULL;
+
+	storePath(name, hash);
+	file = open(name, O_RDONLY);
+	if (file < 0)
+		return 0;
+
+	if (fstat(file, &info) != 0 || (size_t)info.st_size < sizeof(geom_file_header)){
+		close(file);
+		return 0;
+	}
+
+	size = info.st_size;
+	mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED)
+		return 0;
+
+	//checking the file was made from this lsystem and holds as many bytes as its header says
+	header = (geom_file_header*)mapping;
+	fillHeader(&expected, key, hash);
+	if (!headerMatches(header, &expected)
+		|| header->segment_count < 1 || header->segment_count > 0x7fffffff
+		|| header->string_length < 0 || header->string_length > (long long)size
+		|| size != sizeof(geom_file_header) + header->segment_count*sizeof(line) + header->string_length + 1){
+		munmap(mapping, size);
+		return 0;
+	}
+
+	string = (char*)mapping + sizeof(geom_file_header) + header->segment_count*sizeof(line);
+	if (string[header->string_length] != '\0'){
+		munmap(mapping, size);
+		return 0;
+	}
+
+	entry->string = string;
+	entry->line_list = (line*)((char*)mapping + sizeof(geom_file_header));
+	entry->line_list_length = header->segment_count;
+	entry->mapping = mapping;
+	entry->mapping_size = size;
+
+	return 1;
+}
+
+void closeStoredGeometry(geom_entry *entry){
+	/**
+	 * \brief Unmaps a geometry file opened with openStoredGeometry().
+	 *
+	 * \param[out] entry 	the entry pointing into the file.
+	 */
+
+	munmap(entry->mapping, entry->mapping_size);
+	entry->mapping = NULL;
+	entry->mapping_size = 0;
+	entry->string = NULL;
+	entry->line_list = NULL;
+	entry->line_list_length = 0;
+}
+
+static void storePath(char *name, unsigned long long hash){
+	/**
+	 * \brief Writes the path of the geometry file for a hash into name.
+	 *
+	 * \param[out] name 	a character array of at least 64 characters.
+	 * \param[in] hash 		hash of the lsystem from hashLsystem().
+	 */
+
+	sprintf(name, "%s/%016llx.geom", STORE_DIR, hash);
+}
+
+static void fillHeader(geom_file_header *header, lsystem *key, unsigned long long hash){
+	/**
+	 * \brief Fills in the parts of a header that identify the lsystem.
+	 *
+	 * The whole header is cleared first so that the unused ends of the strings are written
+	 * as zeros.
+	 *
+	 * \param[out] header 	the header to be filled.
+	 * \param[in] key 		the lsystem.
+	 * \param[in] hash 		hash of the lsystem from hashLsystem().
+	 */
+
+	memset(header, 0, sizeof(geom_file_header));
+	strcpy(header->magic, "LSYSGEO");
+	header->version = STORE_VERSION;
+	header->depth = key->iterations;
+	header->hash = hash;
+	header->angle = key->angle;
+	strcpy(header->axiom, key->axiom);
+	strcpy(header->rules[0], key->rule_A);
+	strcpy(header->rules[1], key->rule_B);
+	strcpy(header->rules[2], key->rule_F);
+	strcpy(header->rules[3], key->rule_f);
+	strcpy(header->rules[4], key->rule_X);
+	strcpy(header->rules[5], key->rule_Y);
+	strcpy(header->rules[6], key->rule_plus);
+	strcpy(header->rules[7], key->rule_minus);
+	strcpy(header->rules[8], key->rule_store);
+	strcpy(header->rules[9], key->rule_pop);
+}
+
+static int headerMatches(geom_file_header *found, geom_file_header *expected){
+	/**
+	 * \brief Returns true if a header read from a file matches the one expected.
+	 *
+	 * The strings are compared up to their fixed lengths so that a damaged file without a
+	 * terminating null cannot be read past.
+	 *
+	 * \param[in] found 	the header at the start of the file.
+	 * \param[in] expected 	a header filled by fillHeader().
+	 */
+
+	return memcmp(found->magic, expected->magic, sizeof(found->magic)) == 0
+		&& found->version == expected->version
+		&& found->depth == expected->depth
+		&& found->hash == expected->hash
+		&& found->angle == expected->angle
+		&& memcmp(found->axiom, expected->axiom, sizeof(found->axiom)) == 0
+		&& memcmp(found->rules, expected->rules, sizeof(found->rules)) == 0;
+}
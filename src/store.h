@@ -0,0 +1,27 @@
+#ifndef _STORE_H_
+#define _STORE_H_
+
+/** \brief Directory the geometry files are kept in, next to the saves directory.*/
+#define STORE_DIR "cache"
+/** \brief Version of the geometry file layout, to be raised whenever geom_file_header or the layout changes.*/
+#define STORE_VERSION 1
+/** \brief Line lists shorter than this are quick enough to make again and are not written to disk.*/
+#define STORE_MIN_LINES 65536
+
+
+/*
+ * Writes the string and line list for an lsystem to a geometry file in the cache directory.
+ */
+int storeGeometry(lsystem *key, char *string, line *line_list, int line_list_length);
+
+/*
+ * Maps the geometry file for an lsystem into memory and points the entry at its string and line list.
+ */
+int openStoredGeometry(lsystem *key, unsigned long long hash, geom_entry *entry);
+
+/*
+ * Unmaps a geometry file opened with openStoredGeometry().
+ */
+void closeStoredGeometry(geom_entry *entry);
+
+#endif
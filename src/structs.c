@@ -39,12 +39,19 @@ void structInitLsystem(lsystem *lsys){
     lsys->iteration_limit= 0;
     lsys->img_file_num = 0;
     lsys->seq_file_num = 0;
+    lsys->save_format = 0;
+    lsys->density_flag = 0;
+    lsys->antialias_flag = 0;
     lsys->string = NULL;
     lsys->line_list = NULL;
     lsys->line_list_length = 0;
+    lsys->geometry_version = 0;
     lsys->remake_lines_flag = 0;
     lsys->remake_string_flag = 0;
     lsys->info_disp_flag = 0;
+    lsys->cancel_flag = NULL;
+    lsys->progress = NULL;
+    lsys->trace = NULL;
     strcpy(lsys->rule_A, "\0");
     strcpy(lsys->rule_B, "\0");
     strcpy(lsys->rule_F, "\0");
@@ -118,3 +125,540 @@ void structInitTurtleState(turtle_state *turtle){
 	turtle->heading = 0;
 	turtle->next = NULL;
 }
+
+void structInitSeekTable(seek_table *table){
+	/**
+	 * \brief Initilaises a seek_table structure
+	 *
+	 * For use when declaring a seek_table structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] table    The seek table to be initialized.
+	 */
+	table->depth = 0;
+	table->angle = 0;
+	table->aggregates = NULL;
+}
+
+void structInitSeekWalk(seek_walk *walk){
+	/**
+	 * \brief Initilaises a seek_walk structure
+	 *
+	 * For use when declaring a seek_walk structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] walk     The walk to be initialized.
+	 */
+	walk->skip = 0;
+	walk->emit = 0;
+	structInitTurtleState(&(walk->turtle));
+	walk->root = NULL;
+	walk->out = NULL;
+	walk->out_pos = 0;
+}
+
+void structInitTurtleShard(turtle_shard *shard){
+	/**
+	 * \brief Initilaises a turtle_shard structure
+	 *
+	 * For use when declaring a turtle_shard structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] shard    The shard to be initialized.
+	 */
+	shard->lsys = NULL;
+	shard->table = NULL;
+	shard->first = 0;
+	shard->last = 0;
+	shard->out = NULL;
+	shard->written = 0;
+}
+
+void structInitGenWorker(gen_worker *worker){
+	/**
+	 * \brief Initilaises a gen_worker structure
+	 *
+	 * For use when declaring a gen_worker structure to ensure that all
+	 * elements have defined values and predictable behavior. The thread
+	 * itself is started by startWorker().
+	 *
+	 * \param[out] worker   The worker to be initialized.
+	 */
+	worker->thread = NULL;
+	worker->lock = NULL;
+	worker->wake = NULL;
+	structInitLsystem(&(worker->job));
+	worker->job_pending = 0;
+	worker->quit = 0;
+	worker->string_outstanding = 0;
+	SDL_AtomicSet(&(worker->generation), 0);
+	SDL_AtomicSet(&(worker->cancel), 0);
+	SDL_AtomicSet(&(worker->progress), 0);
+	SDL_AtomicSet(&(worker->busy), 0);
+	worker->result = NULL;
+	worker->rewrite_time = -1;
+	worker->turtle_time = 0;
+}
+
+void structInitGeomCache(geom_cache *cache){
+	/**
+	 * \brief Initilaises a geom_cache structure
+	 *
+	 * For use when declaring a geom_cache structure to ensure that all
+	 * elements have defined values and predictable behavior. The lock and
+	 * budget are set up by initCache().
+	 *
+	 * \param[out] cache    The cache to be initialized.
+	 */
+	int i = 0;
+
+	cache->lock = NULL;
+	for (i = 0; i < CACHE_BUCKETS; i++)
+		cache->buckets[i] = NULL;
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	cache->entry_count = 0;
+	cache->bytes = 0;
+	cache->budget = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+void structInitSpecScheduler(spec_scheduler *spec){
+	/**
+	 * \brief Initilaises a spec_scheduler structure
+	 *
+	 * For use when declaring a spec_scheduler structure to ensure that all
+	 * elements have defined values and predictable behavior. The thread
+	 * itself is started by startSpeculation().
+	 *
+	 * \param[out] spec     The scheduler to be initialized.
+	 */
+	int i = 0;
+
+	spec->thread = NULL;
+	spec->lock = NULL;
+	spec->wake = NULL;
+	for (i = 0; i < SPEC_MAX_CANDIDATES; i++)
+		structInitLsystem(&(spec->candidates[i]));
+	spec->candidate_count = 0;
+	spec->next_candidate = 0;
+	spec->quit = 0;
+	SDL_AtomicSet(&(spec->cancel), 0);
+	spec->cache = NULL;
+	for (i = 0; i < 8; i++)
+		spec->preset_uses[i] = 0;
+}
+
+void structInitRasterImage(raster_image *image){
+	/**
+	 * \brief Initilaises a raster_image structure
+	 *
+	 * For use when declaring a raster_image structure to ensure that all
+	 * elements have defined values and predictable behavior. The pixels
+	 * are allocated by initRaster().
+	 *
+	 * \param[out] image    The image to be initialized.
+	 */
+
+	image->width = 0;
+	image->height = 0;
+	image->pixels = NULL;
+	image->x_origin = 0;
+	image->y_origin = 0;
+}
+
+void structInitRenderJob(render_job *job){
+	/**
+	 * \brief Initilaises a render_job structure
+	 *
+	 * For use when declaring a render_job structure to ensure that all
+	 * elements have defined values and predictable behavior. The image
+	 * size defaults to the size of the drawing area of the window.
+	 *
+	 * \param[out] job      The job to be initialized.
+	 */
+
+	structInitLsystem(&(job->lsys));
+	strcpy(job->label, "\0");
+	job->width = 1000;
+	job->height = 800;
+	strcpy(job->out, "\0");
+	job->video_format = 0;
+	job->image_format = -1;
+	job->precision = 1;
+	job->tile_size = 0;
+	job->density = 0;
+	job->tone = 0;
+	job->gamma = 2.2;
+	job->palette = 0;
+	job->antialias = 0;
+	job->frames = 0;
+	job->lines_per_frame = 0;
+	job->fps = 30;
+	job->sweep = 0;
+	job->sweep_from = 0;
+	job->sweep_to = 0;
+	job->threads = 0;
+	job->grow = 0;
+	job->segments = 0;
+	job->rewrite_time = 0;
+	job->turtle_time = 0;
+	job->raster_time = 0;
+	job->encode_time = 0;
+	job->peak_rss = 0;
+	job->expected_bytes = 0;
+	job->from_store = 0;
+	job->saved = 0;
+}
+
+void structInitDensityMap(density_map *map){
+	/**
+	 * \brief Initilaises a density_map structure
+	 *
+	 * For use when declaring a density_map structure to ensure that all
+	 * elements have defined values and predictable behavior. The counts
+	 * are allocated by initDensity().
+	 *
+	 * \param[out] map      The map to be initialized.
+	 */
+
+	map->width = 0;
+	map->height = 0;
+	map->counts = NULL;
+}
+
+void structInitCoverageMask(coverage_mask *mask){
+	/**
+	 * \brief Initilaises a coverage_mask structure
+	 *
+	 * For use when declaring a coverage_mask structure to ensure that all
+	 * elements have defined values and predictable behavior. The levels
+	 * are allocated by initCoverage().
+	 *
+	 * \param[out] mask     The mask to be initialized.
+	 */
+
+	SDL_Colour col = {0, 0, 0};
+
+	mask->width = 0;
+	mask->height = 0;
+	mask->levels = NULL;
+	mask->geometry_version = -1;
+	mask->density = 0;
+	mask->antialias = 0;
+	mask->drawn = 0;
+	structInitDensityMap(&(mask->map));
+	structInitRasterImage(&(mask->image));
+	mask->texture = NULL;
+	mask->composited = 0;
+	mask->bg_colour = col;
+	mask->ln_colour = col;
+	mask->raster_time = 0;
+}
+
+void structInitTextCache(text_cache *cache){
+	/**
+	 * \brief Initilaises a text_cache structure
+	 *
+	 * For use when declaring a text_cache structure to ensure that all
+	 * elements have defined values and predictable behavior. Every
+	 * entry starts empty.
+	 *
+	 * \param[out] cache    The cache to be initialized.
+	 */
+
+	SDL_Colour col = {0, 0, 0};
+	int i = 0;
+
+	for (i = 0; i < TEXT_CACHE_SIZE; i++){
+		cache->entries[i].font = NULL;
+		strcpy(cache->entries[i].text, "\0");
+		cache->entries[i].colour = col;
+		cache->entries[i].hash = 0;
+		cache->entries[i].texture = NULL;
+		cache->entries[i].width = 0;
+		cache->entries[i].height = 0;
+		cache->entries[i].last_used = 0;
+	}
+	cache->clock = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+void structInitTraceLog(trace_log *log){
+	/**
+	 * \brief Initilaises a trace_log structure
+	 *
+	 * For use when declaring a trace_log structure to ensure that all
+	 * elements have defined values and predictable behavior. Tracing is
+	 * started by startTrace().
+	 *
+	 * \param[out] log   The log to be initialized.
+	 */
+
+	int i = 0;
+
+	log->file[0] = '\0';
+	log->ring_id = 0;
+	for (i = 0; i < TRACE_THREADS; i++){
+		log->rings[i].thread = 0;
+		log->rings[i].events = NULL;
+		SDL_AtomicSet(&(log->rings[i].count), 0);
+		SDL_AtomicSet(&(log->rings[i].ready), 0);
+	}
+	SDL_AtomicSet(&(log->ring_count), 0);
+	log->origin = 0;
+}
+
+void structInitUiLayers(ui_layers *layers){
+	/**
+	 * \brief Initilaises a ui_layers structure
+	 *
+	 * For use when declaring a ui_layers structure to ensure that all
+	 * elements have defined values and predictable behavior. The
+	 * textures are made when each layer is first drawn.
+	 *
+	 * \param[out] layers   The layers to be initialized.
+	 */
+
+	int i = 0;
+
+	for (i = 0; i < UI_LAYERS; i++){
+		layers->textures[i] = NULL;
+		layers->valid[i] = 0;
+	}
+	layers->redraws = 0;
+}
+
+void structInitScrubState(scrub_state *scrub){
+	/**
+	 * \brief Initilaises a scrub_state structure
+	 *
+	 * For use when declaring a scrub_state structure to ensure that all
+	 * elements have defined values and predictable behavior. The turtle
+	 * is expected to take SCRUB_CHAR_COST for each character until it has
+	 * been timed.
+	 *
+	 * \param[out] scrub   The scrub state to be initialized.
+	 */
+
+	scrub->active = SCRUB_NONE;
+	scrub->drag = 0;
+	scrub->changed = 0;
+	scrub->unit_lines = NULL;
+	scrub->unit_length = 0;
+	scrub->unit_angle = 0;
+	scrub->unit_depth = 0;
+	scrub->preview_string = NULL;
+	scrub->preview_chars = 0;
+	scrub->preview_depth = 0;
+	scrub->char_cost = SCRUB_CHAR_COST;
+}
+
+void structInitStageTimings(stage_timings *timings){
+	/**
+	 * \brief Initilaises a stage_timings structure
+	 *
+	 * For use when declaring a stage_timings structure to ensure that all
+	 * elements have defined values and predictable behavior. Stages that
+	 * have not run yet are given -1.
+	 *
+	 * \param[out] timings   The timings to be initialized.
+	 */
+
+	timings->rewrite_time = -1;
+	timings->turtle_time = -1;
+	timings->present_time = 0;
+	timings->frame_time = 0;
+	timings->frame_start = 0;
+	timings->string_counted = 0;
+	timings->string_length = 0;
+}
+
+void structInitFrameStats(frame_stats *stats){
+	/**
+	 * \brief Initilaises a frame_stats structure
+	 *
+	 * For use when declaring a frame_stats structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] stats   The stats to be initialized.
+	 */
+
+	stats->frames = 0;
+	stats->events = 0;
+	stats->input_pending = 0;
+	stats->input_time = 0;
+	stats->latency_count = 0;
+	stats->latency_total = 0;
+	stats->latency_max = 0;
+	structInitStageTimings(&(stats->stages));
+}
+
+void structInitVideoStream(video_stream *video){
+	/**
+	 * \brief Initilaises a video_stream structure
+	 *
+	 * For use when declaring a video_stream structure to ensure that all
+	 * elements have defined values and predictable behavior. The stream is
+	 * opened by openVideo().
+	 *
+	 * \param[out] video    The stream to be initialized.
+	 */
+
+	video->file = NULL;
+	video->format = 0;
+	video->width = 0;
+	video->height = 0;
+	video->buffer = NULL;
+	video->frames = 0;
+}
+
+void structInitPngStream(png_stream *png){
+	/**
+	 * \brief Initilaises a png_stream structure
+	 *
+	 * For use when declaring a png_stream structure to ensure that all
+	 * elements have defined values and predictable behavior. The stream is
+	 * opened by openPNGStream().
+	 *
+	 * \param[out] png      The stream to be initialized.
+	 */
+
+	png->file = NULL;
+	png->width = 0;
+	png->height = 0;
+	png->rows = 0;
+	png->compress = 0;
+	png->row = NULL;
+	png->above = NULL;
+	png->window = NULL;
+	png->window_length = 0;
+	png->position = 0;
+	png->head = NULL;
+	png->previous = NULL;
+	png->out = NULL;
+	png->out_length = 0;
+	png->bits = 0;
+	png->bit_count = 0;
+	png->adler_a = 1;
+	png->adler_b = 0;
+	png->failed = 0;
+}
+
+void structInitBatchRunner(batch_runner *batch){
+	/**
+	 * \brief Initilaises a batch_runner structure
+	 *
+	 * For use when declaring a batch_runner structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] batch    The runner to be initialized.
+	 */
+
+	batch->jobs = NULL;
+	batch->job_count = 0;
+	batch->next_job = 0;
+	batch->lock = NULL;
+	batch->memory_free = NULL;
+	batch->budget = 0;
+	batch->reserved = 0;
+}
+
+void structInitBenchSettings(bench_settings *bench){
+	/**
+	 * \brief Initilaises a bench_settings structure
+	 *
+	 * For use when declaring a bench_settings structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] bench    The settings to be initialized.
+	 */
+
+	bench->repetitions = 0;
+	bench->warmup = 0;
+	bench->depths = 0;
+	bench->width = 0;
+	bench->height = 0;
+	bench->out = NULL;
+}
+
+void structInitSweepRunner(sweep_runner *sweep){
+	/**
+	 * \brief Initilaises a sweep_runner structure
+	 *
+	 * For use when declaring a sweep_runner structure to ensure that all
+	 * elements have defined values and predictable behavior.
+	 *
+	 * \param[out] sweep    The runner to be initialized.
+	 */
+
+	sweep->job = NULL;
+	structInitLsystem(&(sweep->lsys));
+	sweep->unit_lines = NULL;
+	sweep->unit_length = 0;
+	sweep->scale = 1;
+	structInitCoord(&(sweep->offset));
+	sweep->bg_colour.r = 255;
+	sweep->bg_colour.g = 255;
+	sweep->bg_colour.b = 255;
+	sweep->bg_colour.a = 255;
+	sweep->ln_colour.r = 0;
+	sweep->ln_colour.g = 0;
+	sweep->ln_colour.b = 0;
+	sweep->ln_colour.a = 255;
+	sweep->slots = NULL;
+	sweep->ready = NULL;
+	sweep->slot_count = 0;
+	sweep->next_frame = 0;
+	sweep->next_write = 0;
+	sweep->failed = 0;
+	sweep->lock = NULL;
+	sweep->changed = NULL;
+}
+
+void structInitSeqExporter(seq_exporter *exporter){
+	/**
+	 * \brief Initilaises a seq_exporter structure
+	 *
+	 * For use when declaring a seq_exporter structure to ensure that all
+	 * elements have defined values and predictable behavior. The lock is
+	 * created by initExporter().
+	 *
+	 * \param[out] exporter     The exporter to be initialized.
+	 */
+	int i = 0;
+
+	exporter->raster_thread = NULL;
+	for (i = 0; i < EXPORT_WRITERS; i++)
+		exporter->writers[i] = NULL;
+	exporter->lock = NULL;
+	exporter->changed = NULL;
+	exporter->line_list = NULL;
+	exporter->line_list_length = 0;
+	exporter->ln_colour.r = 0;
+	exporter->ln_colour.g = 0;
+	exporter->ln_colour.b = 0;
+	exporter->ln_colour.a = 255;
+	structInitRasterImage(&(exporter->frame));
+	exporter->levels = NULL;
+	for (i = 0; i < EXPORT_SLOTS; i++){
+		structInitRasterImage(&(exporter->slots[i]));
+		strcpy(exporter->slot_names[i], "\0");
+		exporter->free_slots[i] = 0;
+		exporter->queue[i] = 0;
+	}
+	exporter->free_count = 0;
+	exporter->queue_head = 0;
+	exporter->queue_count = 0;
+	exporter->raster_done = 0;
+	exporter->cancel = 0;
+	exporter->writers_running = 0;
+	exporter->format = 0;
+	exporter->frame_count = 0;
+	SDL_AtomicSet(&(exporter->frames_written), 0);
+	SDL_AtomicSet(&(exporter->busy), 0);
+	strcpy(exporter->base_time, "\0");
+	exporter->trace = NULL;
+}
@@ -58,6 +58,55 @@ typedef struct btn{
 }btn;
 
 
+/** \brief Most threads whose spans a trace log records.*/
+#define TRACE_THREADS 16
+/** \brief Number of spans each thread's ring buffer holds, a power of 2, the oldest are overwritten first.*/
+#define TRACE_EVENTS 65536
+
+/**
+ * A structure that holds one span of a trace, a named stage of work from when it began to when it ended.
+ */
+typedef struct trace_event{
+    /** \brief Name of the stage, a string that lives as long as the program.*/
+    const char *name;
+    /** \brief Performance counter value when the stage began.*/
+    Uint64 begin;
+    /** \brief Performance counter value when the stage ended.*/
+    Uint64 end;
+}trace_event;
+
+/**
+ * A structure that holds the spans recorded by one thread, which only that thread writes to.
+ */
+typedef struct trace_ring{
+    /** \brief Id of the thread that records into the ring.*/
+    SDL_threadID thread;
+    /** \brief Array of TRACE_EVENTS spans, NULL until the thread records its first span.*/
+    trace_event *events;
+    /** \brief Number of spans recorded, set after each span is written so a reader never sees a half written span.*/
+    SDL_atomic_t count;
+    /** \brief Set once the events are allocated and the thread id is set.*/
+    SDL_atomic_t ready;
+}trace_ring;
+
+/**
+ * A structure that holds a trace of where the program's time goes, as spans recorded into a ring
+ * buffer for each thread, written out as Chrome trace event JSON.
+ */
+typedef struct trace_log{
+    /** \brief File the trace is written to.*/
+    char file[256];
+    /** \brief Thread local storage slot holding each thread's ring.*/
+    SDL_TLSID ring_id;
+    /** \brief Ring buffer for each thread, handed out in the order threads record their first span.*/
+    trace_ring rings[TRACE_THREADS];
+    /** \brief Number of rings handed out, which can go past TRACE_THREADS when the threads run out.*/
+    SDL_atomic_t ring_count;
+    /** \brief Performance counter value when tracing started, which is time 0 in the trace.*/
+    Uint64 origin;
+}trace_log;
+
+
 /**
  * A structure that holds all of the information required for the creation and drawing of an lsystem
  */
@@ -84,6 +133,12 @@ typedef struct lsystem{
     int img_file_num;
     /** \brief A counter that counts how many images have been saved to a sequence so that conflicting names are not produced in a single run of the program.*/
     int seq_file_num;
+    /** \brief Format that images and sequences are saved in from the drawing screen (one of the IMAGE_ values in encode.h).*/
+    int save_format;
+    /** \brief A flag which shows how many lines pass through each pixel on the drawing screen instead of the lines.*/
+    int density_flag;
+    /** \brief A flag which draws anti-aliased lines on the drawing screen and in saved sequences.*/
+    int antialias_flag;
 
     //containers
     /** \brief A pointer to the L-System string to be drawn.*/
@@ -92,15 +147,27 @@ typedef struct lsystem{
     line *line_list;
     /** \brief A counter that recrds the length of the line list.*/
     int line_list_length;
+    /** \brief A counter that goes up each time the line list is replaced or freed, so anything drawn from it knows when it is out of date.*/
+    int geometry_version;
 
     //flags
     /** \brief A flag which tells the program to recalculate the line list.*/
     int remake_lines_flag;
     /** \brief A flag which tells the program to recalculate the string.*/
     int remake_string_flag;
-    /** \brief A flag which tells the program to display the L-System info to the screen.*/
+    /** \brief A flag which tells the program to display the L-System info to the screen, and with it the stage timings (one of the INFO_ values in ui.h).*/
     int info_disp_flag;
 
+    //worker thread
+    /** \brief Flag set by the worker thread when the job making this lsystem is cancelled (NULL when not on the worker thread).*/
+    SDL_atomic_t *cancel_flag;
+    /** \brief Percentage progress of the job making this lsystem (NULL when not on the worker thread).*/
+    SDL_atomic_t *progress;
+
+    //tracing
+    /** \brief Trace log that the stages of making and drawing this lsystem are recorded in (NULL when not tracing).*/
+    trace_log *trace;
+
     //rules
     /** \brief character replacement string for the 'A' chracter.*/
     char rule_A[40];
@@ -124,6 +191,745 @@ typedef struct lsystem{
     char rule_pop[40];
 }lsystem;
 
+
+/**
+ * A structure that summarises the expansion of one symbol to a given depth, holding the number
+ * of lines it draws and the net movement of the turtle across it, so that whole expansions can
+ * be stepped over without generating them.
+ */
+typedef struct seg_aggregate{
+    /** \brief Number of line drawing characters in the expansion.*/
+    long long segments;
+    /** \brief Net x movement of the turtle for a line length of 1, starting at a heading of 0.*/
+    double dx;
+    /** \brief Net y movement of the turtle for a line length of 1, starting at a heading of 0.*/
+    double dy;
+    /** \brief Net change in heading across the expansion (stored as radians).*/
+    double heading;
+    /** \brief How the expansion uses the turtle stack (one of the AGG_ values defined in seek.h).*/
+    int kind;
+}seg_aggregate;
+
+
+/**
+ * A structure that holds the aggregates for every symbol at every depth up to the depth of an lsystem.
+ */
+typedef struct seek_table{
+    /** \brief Deepest level held in the table (the number of iterations it was built for).*/
+    int depth;
+    /** \brief Angle the table was built with, as the net headings depend on it.*/
+    double angle;
+    /** \brief Array of (depth+1)*SEEK_SYMBOLS aggregates, stored one depth after another.*/
+    seg_aggregate *aggregates;
+}seek_table;
+
+
+/**
+ * A structure that holds the state of a walk through the derivation tree of an lsystem.
+ */
+typedef struct seek_walk{
+    /** \brief Number of lines still to be stepped over before any are written out.*/
+    long long skip;
+    /** \brief Number of lines still to be written out once skipping has finished.*/
+    long long emit;
+    /** \brief Current turtle.*/
+    turtle_state turtle;
+    /** \brief Pointer to the top of the turtle stack.*/
+    turtle_state *root;
+    /** \brief Array that the lines are written to, or NULL if the walk only seeks.*/
+    line *out;
+    /** \brief Number of lines written to the out array.*/
+    long long out_pos;
+}seek_walk;
+
+
+/**
+ * A structure that holds one share of a line list, made on its own thread by rangeToTurtle().
+ */
+typedef struct turtle_shard{
+    /** \brief lsystem that holds the axiom, rules, start point and line length, which is only read.*/
+    lsystem *lsys;
+    /** \brief Seek table built for the lsystem, which is only read.*/
+    seek_table *table;
+    /** \brief Index of the first line of the share.*/
+    long long first;
+    /** \brief Index one past the last line of the share.*/
+    long long last;
+    /** \brief Array the lines of the share are written to, with room for last - first lines.*/
+    line *out;
+    /** \brief Number of lines written once the share is made.*/
+    long long written;
+}turtle_shard;
+
+/**
+ * A structure that holds a string and line list made by the worker thread, ready to be swapped
+ * into the lsystem being drawn.
+ */
+typedef struct gen_result{
+    /** \brief The new L-System string, or NULL if only the line list was remade.*/
+    char *string;
+    /** \brief The new line list, made with a line length of 1 from (0, 0).*/
+    line *line_list;
+    /** \brief Number of lines in the line list.*/
+    int line_list_length;
+    /** \brief Number of the request that the result was made for.*/
+    int generation;
+    /** \brief Milliseconds spent making the string, or -1 if only the line list was remade.*/
+    double rewrite_time;
+    /** \brief Milliseconds spent making the line list.*/
+    double turtle_time;
+}gen_result;
+
+
+/**
+ * A structure that holds the state of the worker thread that makes strings and line lists in the
+ * background so that the window keeps responding while large L-Systems are made.
+ */
+typedef struct gen_worker{
+    /** \brief The worker thread.*/
+    SDL_Thread *thread;
+    /** \brief Lock protecting the job and the quit flag.*/
+    SDL_mutex *lock;
+    /** \brief Condition signalled when a job is submitted or the worker is stopped.*/
+    SDL_cond *wake;
+    /** \brief Copy of the lsystem for the job waiting to be started.*/
+    lsystem job;
+    /** \brief True if a job is waiting to be started.*/
+    int job_pending;
+    /** \brief Flag telling the worker thread to exit.*/
+    int quit;
+    /** \brief True while a string is being remade and has not been collected (only used by the UI thread).*/
+    int string_outstanding;
+    /** \brief Number of the newest request, results made for older requests are thrown away.*/
+    SDL_atomic_t generation;
+    /** \brief Set when a newer request means the running job should stop.*/
+    SDL_atomic_t cancel;
+    /** \brief Percentage progress of the running job.*/
+    SDL_atomic_t progress;
+    /** \brief True while a job is waiting or running.*/
+    SDL_atomic_t busy;
+    /** \brief Finished gen_result published by the worker thread, swapped out atomically by the UI thread.*/
+    void *result;
+    /** \brief Milliseconds the last collected result spent making its string, or -1 if it only remade the line list (only used by the UI thread).*/
+    double rewrite_time;
+    /** \brief Milliseconds the last collected result spent making its line list (only used by the UI thread).*/
+    double turtle_time;
+}gen_worker;
+
+/**
+ * A structure that holds one finished string and line list in the geometry cache.
+ */
+typedef struct geom_entry{
+    /** \brief Hash of the axiom, rules, angle and depth that the entry is found by.*/
+    unsigned long long hash;
+    /** \brief Copy of the lsystem the geometry was made from (its string and line list are not used).*/
+    lsystem key;
+    /** \brief The L-System string.*/
+    char *string;
+    /** \brief The line list, made with a line length of 1 starting from (0, 0).*/
+    line *line_list;
+    /** \brief Number of lines in the line list.*/
+    int line_list_length;
+    /** \brief Number of bytes held by the entry, its string and its line list, or by the entry and its mapped file.*/
+    size_t bytes;
+    /** \brief Start of the mapped geometry file the string and line list point into, or NULL if they were allocated.*/
+    void *mapping;
+    /** \brief Size of the mapped geometry file in bytes.*/
+    size_t mapping_size;
+    /** \brief Number of lookups copying out of the entry without the cache lock.*/
+    int users;
+    /** \brief True once the entry has been taken out of the cache while it still had users, so the last user frees it.*/
+    int removed;
+    /** \brief Pointer to the entry used just before this one.*/
+    struct geom_entry *prev;
+    /** \brief Pointer to the entry used just after this one.*/
+    struct geom_entry *next;
+    /** \brief Pointer to the next entry in the same hash bucket.*/
+    struct geom_entry *chain;
+}geom_entry;
+
+
+/**
+ * A structure for the header at the start of a stored geometry file, which is followed by the line
+ * list (made with a line length of 1 from (0, 0)) and then the string with its terminating null.
+ */
+typedef struct geom_file_header{
+    /** \brief Marks the file as stored geometry, always "LSYSGEO" with its null.*/
+    char magic[8];
+    /** \brief Version of the file layout, files with any other version are ignored.*/
+    int version;
+    /** \brief Fractal depth the geometry was made at.*/
+    int depth;
+    /** \brief Hash of the axiom, rules, angle and depth from hashLsystem().*/
+    unsigned long long hash;
+    /** \brief Angle the geometry was made with.*/
+    double angle;
+    /** \brief Number of lines in the line list.*/
+    long long segment_count;
+    /** \brief Length of the string, not counting its terminating null.*/
+    long long string_length;
+    /** \brief Smallest x and y reached by the lines.*/
+    coordinate bbox_min;
+    /** \brief Largest x and y reached by the lines.*/
+    coordinate bbox_max;
+    /** \brief Axiom the geometry was made from.*/
+    char axiom[40];
+    /** \brief Rules the geometry was made from, in the order they are held in the lsystem.*/
+    char rules[10][40];
+}geom_file_header;
+
+
+/** \brief Number of hash buckets in the geometry cache.*/
+#define CACHE_BUCKETS 64
+
+/**
+ * A structure that holds finished strings and line lists so they can be drawn without being remade,
+ * within a memory budget, freeing the least recently used first.
+ */
+typedef struct geom_cache{
+    /** \brief Lock protecting the entries, as the cache is filled from other threads.*/
+    SDL_mutex *lock;
+    /** \brief Hash table of entries, chained through the chain pointer.*/
+    geom_entry *buckets[CACHE_BUCKETS];
+    /** \brief Most recently used entry.*/
+    geom_entry *newest;
+    /** \brief Least recently used entry, the first to be freed.*/
+    geom_entry *oldest;
+    /** \brief Number of entries.*/
+    int entry_count;
+    /** \brief Number of bytes held by all of the entries.*/
+    size_t bytes;
+    /** \brief Maximum number of bytes the entries may hold.*/
+    size_t budget;
+    /** \brief Number of lookups that found their geometry in the cache.*/
+    int hits;
+    /** \brief Number of lookups that did not.*/
+    int misses;
+}geom_cache;
+
+
+/** \brief Maximum number of lsystems waiting to be made by the speculative scheduler.*/
+#define SPEC_MAX_CANDIDATES 12
+
+/**
+ * A structure that holds the state of the speculative scheduler, which uses idle time to make the
+ * lsystems the user is likely to ask for next.
+ */
+typedef struct spec_scheduler{
+    /** \brief The low priority thread that makes the candidates.*/
+    SDL_Thread *thread;
+    /** \brief Lock protecting the candidates and the quit flag.*/
+    SDL_mutex *lock;
+    /** \brief Condition signalled when new candidates are set or the scheduler is stopped.*/
+    SDL_cond *wake;
+    /** \brief Lsystems to be made, most likely first.*/
+    lsystem candidates[SPEC_MAX_CANDIDATES];
+    /** \brief Number of candidates.*/
+    int candidate_count;
+    /** \brief Index of the next candidate to be made.*/
+    int next_candidate;
+    /** \brief Flag telling the thread to exit.*/
+    int quit;
+    /** \brief Set when the candidates change so the one being made is dropped.*/
+    SDL_atomic_t cancel;
+    /** \brief Cache that finished candidates are put in.*/
+    geom_cache *cache;
+    /** \brief Number of times each of the 8 pre defined rule sets has been picked (only used by the UI thread).*/
+    int preset_uses[8];
+}spec_scheduler;
+
+/**
+ * A structure that holds an image in memory for drawing fractals on the CPU, without a window.
+ */
+typedef struct raster_image{
+    /** \brief Width of the image in pixels.*/
+    int width;
+    /** \brief Height of the image in pixels.*/
+    int height;
+    /** \brief Array of width*height pixels in ARGB8888 format, stored one row after another.*/
+    Uint32 *pixels;
+    /** \brief x position of the image's left edge in a larger picture it is one tile of, 0 for a whole picture.*/
+    int x_origin;
+    /** \brief y position of the image's top edge in a larger picture it is one tile of, 0 for a whole picture.*/
+    int y_origin;
+}raster_image;
+
+
+/**
+ * A structure that holds the number of lines that have passed through each pixel of an image, which
+ * is tone mapped into colours rather than drawn over and over.
+ */
+typedef struct density_map{
+    /** \brief Width of the map in pixels.*/
+    int width;
+    /** \brief Height of the map in pixels.*/
+    int height;
+    /** \brief Array of width*height counts, stored one row after another.*/
+    Uint32 *counts;
+}density_map;
+
+
+/**
+ * A structure that holds how much of each pixel of the drawing screen is covered by the fractal,
+ * so that changing its colours only recolours the pixels rather than drawing every line again.
+ */
+typedef struct coverage_mask{
+    /** \brief Width of the mask in pixels.*/
+    int width;
+    /** \brief Height of the mask in pixels.*/
+    int height;
+    /** \brief Array of width*height levels, 0 for the background colour up to 255 for the line colour.*/
+    Uint8 *levels;
+    /** \brief Geometry version of the line list the levels were drawn from, -1 if they have not been drawn.*/
+    int geometry_version;
+    /** \brief True if the levels are tone mapped line densities rather than the lines themselves.*/
+    int density;
+    /** \brief True if the lines were drawn anti-aliased.*/
+    int antialias;
+    /** \brief Number of lines of the line list drawn into the levels so far.*/
+    int drawn;
+    /** \brief Line densities counted so far when drawing densities, allocated when first needed.*/
+    density_map map;
+    /** \brief Pixels of the mask coloured with the colours below.*/
+    raster_image image;
+    /** \brief Texture the coloured pixels are copied to, made when first needed.*/
+    SDL_Texture *texture;
+    /** \brief True if the image and texture match the levels and colours.*/
+    int composited;
+    /** \brief Background colour the image was coloured with.*/
+    SDL_Colour bg_colour;
+    /** \brief Line colour the image was coloured with.*/
+    SDL_Colour ln_colour;
+    /** \brief Milliseconds spent drawing the line list into the levels so far, over every slice.*/
+    double raster_time;
+}coverage_mask;
+
+
+/** \brief Number of screens with a static layer: the home, options and drawing screens.*/
+#define UI_LAYERS 3
+
+/**
+ * A structure that holds the parts of each screen that do not change from one frame to the next,
+ * drawn once into a texture that is copied to the window at the start of every frame.
+ */
+typedef struct ui_layers{
+    /** \brief Texture holding each screen's static layer, NULL until it is first drawn.*/
+    SDL_Texture *textures[UI_LAYERS];
+    /** \brief True if each texture holds its screen's static layer.*/
+    int valid[UI_LAYERS];
+    /** \brief Number of times a layer has been drawn.*/
+    int redraws;
+}ui_layers;
+
+
+/** \brief Nothing is being dragged.*/
+#define SCRUB_NONE 0
+/** \brief The angle is being dragged.*/
+#define SCRUB_ANGLE 1
+/** \brief The line length is being dragged.*/
+#define SCRUB_LENGTH 2
+/** \brief Time in milliseconds the turtle is expected to take for each character of a string before it has been timed.*/
+#define SCRUB_CHAR_COST 0.00005
+
+/**
+ * A structure that holds a drag of the angle or line length on the drawing screen, and the
+ * lines and strings kept so each change only runs the turtle, or only places the lines.
+ */
+typedef struct scrub_state{
+    /** \brief Setting being dragged, SCRUB_NONE if there is no drag.*/
+    int active;
+    /** \brief Pixels dragged that have not yet added up to a step of the line length.*/
+    int drag;
+    /** \brief True if the angle or line length has changed since the line list was last made.*/
+    int changed;
+    /** \brief Line list made with a line length of 1 from (0, 0), NULL if there is none.*/
+    line *unit_lines;
+    /** \brief Number of lines in the unit line list.*/
+    int unit_length;
+    /** \brief Angle the unit lines were made with.*/
+    double unit_angle;
+    /** \brief Depth of the string the unit lines were made from.*/
+    int unit_depth;
+    /** \brief String made at a lower depth for previews, NULL until one is needed.*/
+    char *preview_string;
+    /** \brief Number of characters in the preview string.*/
+    size_t preview_chars;
+    /** \brief Depth the preview string was made at.*/
+    int preview_depth;
+    /** \brief Time in milliseconds the turtle is expected to take for each character of a string.*/
+    double char_cost;
+}scrub_state;
+
+
+/**
+ * A structure that holds how long each stage of making and showing the fractal last took, and
+ * how much the string holds, for the timings shown in the info overlay.
+ */
+typedef struct stage_timings{
+    /** \brief Milliseconds the last string took to make, or one of the STAGE_ values in frame.h if it was not made.*/
+    double rewrite_time;
+    /** \brief Milliseconds the last line list took to make, or one of the STAGE_ values in frame.h if it was not made.*/
+    double turtle_time;
+    /** \brief Milliseconds the last call to SDL_RenderPresent() took, including waiting for vsync.*/
+    double present_time;
+    /** \brief Milliseconds from the start of drawing the last frame to it being presented.*/
+    double frame_time;
+    /** \brief Performance counter value when drawing the current frame started.*/
+    Uint64 frame_start;
+    /** \brief True if string_length has been counted for the lsystem's current string.*/
+    int string_counted;
+    /** \brief Number of characters in the lsystem's string.*/
+    size_t string_length;
+}stage_timings;
+
+
+/**
+ * A structure that counts the frames and events of the window's main loop, and measures how long
+ * input takes to reach the screen.
+ */
+typedef struct frame_stats{
+    /** \brief Number of frames presented.*/
+    int frames;
+    /** \brief Number of events handled.*/
+    int events;
+    /** \brief True if input has changed the screen since the last frame was presented.*/
+    int input_pending;
+    /** \brief Time in milliseconds of the earliest input not yet presented.*/
+    Uint32 input_time;
+    /** \brief Number of input to present latencies measured.*/
+    int latency_count;
+    /** \brief Sum of the measured latencies in milliseconds.*/
+    double latency_total;
+    /** \brief Longest measured latency in milliseconds.*/
+    Uint32 latency_max;
+    /** \brief How long each stage of the last frame, and of the fractal it shows, took.*/
+    stage_timings stages;
+}frame_stats;
+
+
+/** \brief Number of rendered pieces of text the text cache holds.*/
+#define TEXT_CACHE_SIZE 128
+/** \brief Longest piece of text the text cache holds, including its terminating null.*/
+#define TEXT_CACHE_LENGTH 64
+
+/**
+ * A structure that holds one piece of text rendered to a texture, with the font and colour it was rendered in.
+ */
+typedef struct text_entry{
+    /** \brief Font the text was rendered in, NULL if the entry is empty.*/
+    TTF_Font *font;
+    /** \brief The text.*/
+    char text[TEXT_CACHE_LENGTH];
+    /** \brief Colour the text was rendered in.*/
+    SDL_Colour colour;
+    /** \brief Hash of the font, text and colour, checked before the text is compared.*/
+    Uint32 hash;
+    /** \brief The rendered text.*/
+    SDL_Texture *texture;
+    /** \brief Width of the texture in pixels.*/
+    int width;
+    /** \brief Height of the texture in pixels.*/
+    int height;
+    /** \brief Value of the cache's clock when the entry was last used.*/
+    Uint32 last_used;
+}text_entry;
+
+/**
+ * A structure that holds text rendered to textures so that text drawn every frame is only rendered
+ * once, replacing the least recently used text when it is full.
+ */
+typedef struct text_cache{
+    /** \brief The rendered text.*/
+    text_entry entries[TEXT_CACHE_SIZE];
+    /** \brief Clock counting lookups, used to find the least recently used entry.*/
+    Uint32 clock;
+    /** \brief Number of lookups that found their text in the cache.*/
+    int hits;
+    /** \brief Number of lookups that rendered their text.*/
+    int misses;
+}text_cache;
+
+
+/**
+ * A structure that holds an open video stream that frames are written to one after another.
+ */
+typedef struct video_stream{
+    /** \brief The file being written to, which may be stdout.*/
+    FILE *file;
+    /** \brief Format of the stream, one of the VIDEO_ values defined in video.h.*/
+    int format;
+    /** \brief Width of each frame in pixels.*/
+    int width;
+    /** \brief Height of each frame in pixels.*/
+    int height;
+    /** \brief Buffer a frame is converted into before it is written.*/
+    unsigned char *buffer;
+    /** \brief Number of frames written.*/
+    long frames;
+}video_stream;
+
+
+/**
+ * A structure that holds a PNG file being written a row at a time, compressing each row as it
+ * arrives so that the whole image never has to be held.
+ */
+typedef struct png_stream{
+    /** \brief The file being written to.*/
+    FILE *file;
+    /** \brief Width of the image in pixels.*/
+    int width;
+    /** \brief Height of the image in pixels.*/
+    int height;
+    /** \brief Number of rows written so far.*/
+    int rows;
+    /** \brief True to compress with deflate, false to store the rows uncompressed.*/
+    int compress;
+    /** \brief The filtered row being added, a filter byte followed by 3 bytes for each pixel.*/
+    unsigned char *row;
+    /** \brief The last row added before filtering, which the next row is stored as the difference from.*/
+    unsigned char *above;
+    /** \brief Filtered bytes not yet compressed, along with the bytes before them that runs can repeat.*/
+    unsigned char *window;
+    /** \brief Number of bytes in the window.*/
+    int window_length;
+    /** \brief Position of the next byte in the window to be compressed.*/
+    int position;
+    /** \brief Last window position each hash of 3 bytes was seen at, or -1.*/
+    int *head;
+    /** \brief Position seen before each position with the same hash, indexed by position modulo the window size.*/
+    int *previous;
+    /** \brief Compressed bytes waiting to be written as a chunk.*/
+    unsigned char *out;
+    /** \brief Number of compressed bytes waiting.*/
+    int out_length;
+    /** \brief Bits waiting to be added to the compressed bytes, lowest first.*/
+    unsigned long bits;
+    /** \brief Number of bits waiting.*/
+    int bit_count;
+    /** \brief First sum of the Adler-32 checksum of the filtered bytes.*/
+    unsigned long adler_a;
+    /** \brief Second sum of the Adler-32 checksum of the filtered bytes.*/
+    unsigned long adler_b;
+    /** \brief Set if memory could not be allocated or the file could not be written.*/
+    int failed;
+}png_stream;
+
+
+/**
+ * A structure that holds one image to be made by the headless renderer, and how long each stage
+ * of making it took.
+ */
+typedef struct render_job{
+    /** \brief The lsystem to be drawn, from a pre defined rule set or rules given with the job.*/
+    lsystem lsys;
+    /** \brief Short name used in the default file name, the preset name or "custom".*/
+    char label[40];
+    /** \brief Width of the image in pixels.*/
+    int width;
+    /** \brief Height of the image in pixels.*/
+    int height;
+    /** \brief File name for the image, or an empty string for a name made from the label and depth.*/
+    char out[256];
+    /** \brief Video format for a sequence showing the fractal being drawn (one of the VIDEO_ values in video.h), or 0 for a single image.*/
+    int video_format;
+    /** \brief Format for a single image (one of the IMAGE_ values in encode.h), or -1 to take it from the file name.*/
+    int image_format;
+    /** \brief Number of decimal places coordinates are rounded to in an svg.*/
+    int precision;
+    /** \brief Width of the tiles a large image is drawn in, or 0 to tile only images too large to hold.*/
+    int tile_size;
+    /** \brief True to draw how many lines pass through each pixel rather than the lines themselves.*/
+    int density;
+    /** \brief How a density image's counts are scaled, DENSITY_LOG or DENSITY_GAMMA from density.h.*/
+    int tone;
+    /** \brief Gamma used when a density image is scaled with DENSITY_GAMMA.*/
+    double gamma;
+    /** \brief Palette a density image is coloured with, one of the PALETTE_ values in density.h.*/
+    int palette;
+    /** \brief True to draw anti-aliased lines.*/
+    int antialias;
+    /** \brief Number of frames in the sequence, or 0 to use lines_per_frame.*/
+    int frames;
+    /** \brief Number of lines added in each frame, or 0 to use frames.*/
+    int lines_per_frame;
+    /** \brief Frame rate written in the header of a y4m stream.*/
+    int fps;
+    /** \brief Setting swept across the frames of a video (one of the SWEEP_ values in sweep.h), or 0 for no sweep.*/
+    int sweep;
+    /** \brief Value of the swept setting in the first frame, in degrees for the angle.*/
+    double sweep_from;
+    /** \brief Value of the swept setting in the last frame.*/
+    double sweep_to;
+    /** \brief Number of threads drawing the frames of a sweep, or 0 for one for each CPU core, and for any other job the number of threads making the line list.*/
+    int threads;
+    /** \brief Number of frames for each level of a video of the fractal growing from its axiom, or 0 for no growth.*/
+    int grow;
+
+    //results
+    /** \brief Number of lines drawn.*/
+    long long segments;
+    /** \brief Seconds spent making the string.*/
+    double rewrite_time;
+    /** \brief Seconds spent making the line list.*/
+    double turtle_time;
+    /** \brief Seconds spent drawing the line list to the image.*/
+    double raster_time;
+    /** \brief Seconds spent writing the image file.*/
+    double encode_time;
+    /** \brief Peak resident memory of the whole run in kilobytes when the job finished, from peakMemory().*/
+    long peak_rss;
+    /** \brief Number of bytes the job was expected to need at its peak, used by the batch runner.*/
+    size_t expected_bytes;
+    /** \brief True if the geometry was mapped in from the geometry store rather than made.*/
+    int from_store;
+    /** \brief True once the image has been saved.*/
+    int saved;
+}render_job;
+
+
+/**
+ * A structure that holds the state of the batch runner, which works through a list of render jobs
+ * with a pool of threads while keeping the memory they use together within a budget.
+ */
+typedef struct batch_runner{
+    /** \brief Array of the jobs to be run.*/
+    render_job *jobs;
+    /** \brief Number of jobs.*/
+    int job_count;
+    /** \brief Index of the next job to be started.*/
+    int next_job;
+    /** \brief Lock protecting next_job and reserved.*/
+    SDL_mutex *lock;
+    /** \brief Condition signalled when a job finishes and gives back its memory.*/
+    SDL_cond *memory_free;
+    /** \brief Maximum number of bytes the running jobs may expect to use together.*/
+    size_t budget;
+    /** \brief Number of bytes the running jobs expect to use.*/
+    size_t reserved;
+}batch_runner;
+
+
+/**
+ * A structure that holds the settings of the benchmark suite, which times each stage of making
+ * and drawing every pre defined rule set at several depths.
+ */
+typedef struct bench_settings{
+    /** \brief Number of timed runs of each stage, which the median and 95th percentile are taken from.*/
+    int repetitions;
+    /** \brief Number of untimed runs of each stage before it is timed, to warm the caches and allocator.*/
+    int warmup;
+    /** \brief Number of depths each rule set is timed at, counting down from its iteration limit.*/
+    int depths;
+    /** \brief Width of the image the lines are drawn into in pixels.*/
+    int width;
+    /** \brief Height of the image the lines are drawn into in pixels.*/
+    int height;
+    /** \brief File name the JSON report is written to.*/
+    char *out;
+}bench_settings;
+
+
+/**
+ * A structure that holds a video of a parameter sweep being drawn by a pool of threads, and the
+ * reorder buffer that holds the frames they finish until they can be written in order.
+ */
+typedef struct sweep_runner{
+    /** \brief The job being drawn.*/
+    render_job *job;
+    /** \brief lsystem holding the string the turtle runs over for each frame of an angle sweep, shared read only.*/
+    lsystem lsys;
+    /** \brief Line list made with a line length of 1 from (0, 0) for a line length sweep, shared read only.*/
+    line *unit_lines;
+    /** \brief Number of lines in the unit line list.*/
+    int unit_length;
+    /** \brief Scale that fits the unit lines to the image at the largest line length of the sweep.*/
+    double scale;
+    /** \brief Offset that fits the unit lines to the image at the largest line length of the sweep.*/
+    coordinate offset;
+    /** \brief Colour for the background.*/
+    SDL_Colour bg_colour;
+    /** \brief Colour for the lines.*/
+    SDL_Colour ln_colour;
+    /** \brief Array of slot_count images, frame i is drawn into slot i % slot_count.*/
+    raster_image *slots;
+    /** \brief Frame held in each slot ready to be written, or -1 if it is empty or still being drawn.*/
+    int *ready;
+    /** \brief Number of slots in the reorder buffer.*/
+    int slot_count;
+    /** \brief Index of the next frame to be drawn.*/
+    int next_frame;
+    /** \brief Index of the next frame to be written.*/
+    int next_write;
+    /** \brief True if a frame could not be drawn or written, which stops the threads.*/
+    int failed;
+    /** \brief Lock protecting the slots, frame indexes and failed flag.*/
+    SDL_mutex *lock;
+    /** \brief Signalled whenever a frame is drawn or written.*/
+    SDL_cond *changed;
+}sweep_runner;
+
+/** \brief Number of frame buffers shared by the sequence export threads.*/
+#define EXPORT_SLOTS 4
+/** \brief Number of threads writing sequence frames to disk.*/
+#define EXPORT_WRITERS 2
+
+/**
+ * A structure that holds the state of a sequence export, where one thread draws the frames into its
+ * own image and hands finished frames through a bounded queue to threads that write them to disk.
+ */
+typedef struct seq_exporter{
+    /** \brief Thread drawing the frames.*/
+    SDL_Thread *raster_thread;
+    /** \brief Threads writing finished frames to disk.*/
+    SDL_Thread *writers[EXPORT_WRITERS];
+    /** \brief Lock protecting the queue, the free slots and the flags.*/
+    SDL_mutex *lock;
+    /** \brief Condition signalled whenever a frame is queued or a slot is freed.*/
+    SDL_cond *changed;
+    /** \brief Copy of the line list being exported, placed as it is on the drawing screen.*/
+    line *line_list;
+    /** \brief Number of lines in the line list.*/
+    int line_list_length;
+    /** \brief Colour for the lines.*/
+    SDL_Colour ln_colour;
+    /** \brief Image the frames are drawn into, one line after another.*/
+    raster_image frame;
+    /** \brief Coverage levels of the frame when the lines are anti-aliased, NULL when they are not.*/
+    Uint8 *levels;
+    /** \brief Copies of finished frames waiting to be written, or free for the next frame.*/
+    raster_image slots[EXPORT_SLOTS];
+    /** \brief File name for the frame held in each slot.*/
+    char slot_names[EXPORT_SLOTS][100];
+    /** \brief Indices of the slots that are free.*/
+    int free_slots[EXPORT_SLOTS];
+    /** \brief Number of free slots.*/
+    int free_count;
+    /** \brief Indices of the slots waiting to be written, oldest first from queue_head.*/
+    int queue[EXPORT_SLOTS];
+    /** \brief Position of the oldest slot in the queue.*/
+    int queue_head;
+    /** \brief Number of slots in the queue.*/
+    int queue_count;
+    /** \brief True once every frame has been drawn and queued.*/
+    int raster_done;
+    /** \brief Flag telling every thread to stop.*/
+    int cancel;
+    /** \brief Number of writer threads that have not exited.*/
+    int writers_running;
+    /** \brief Format the frames are saved in (one of the IMAGE_ values in encode.h).*/
+    int format;
+    /** \brief Number of frames in the sequence.*/
+    int frame_count;
+    /** \brief Number of frames written to disk.*/
+    SDL_atomic_t frames_written;
+    /** \brief True from the start of an export until every thread has exited.*/
+    SDL_atomic_t busy;
+    /** \brief Time the export was started, used in the frame file names.*/
+    char base_time[40];
+    /** \brief Trace log that saving each frame is recorded in (NULL when not tracing).*/
+    trace_log *trace;
+}seq_exporter;
+
 /*
  * Initialisation function to be used whenever an L-System structure is declared.
  */
@@ -149,4 +955,114 @@ void structInitBtn(btn *ui_button);
  */
 void structInitTurtleState(turtle_state *turtle);
 
+/*
+ * Initialisation function to be used whenever a seek_table structure is declared.
+ */
+void structInitSeekTable(seek_table *table);
+
+/*
+ * Initialisation function to be used whenever a seek_walk structure is declared.
+ */
+void structInitSeekWalk(seek_walk *walk);
+
+/*
+ * Initialisation function to be used whenever a turtle_shard structure is declared.
+ */
+void structInitTurtleShard(turtle_shard *shard);
+
+/*
+ * Initialisation function to be used whenever a gen_worker structure is declared.
+ */
+void structInitGenWorker(gen_worker *worker);
+
+/*
+ * Initialisation function to be used whenever a geom_cache structure is declared.
+ */
+void structInitGeomCache(geom_cache *cache);
+
+/*
+ * Initialisation function to be used whenever a spec_scheduler structure is declared.
+ */
+void structInitSpecScheduler(spec_scheduler *spec);
+
+/*
+ * Initialisation function to be used whenever a raster_image structure is declared.
+ */
+void structInitRasterImage(raster_image *image);
+
+/*
+ * Initialisation function to be used whenever a render_job structure is declared.
+ */
+void structInitRenderJob(render_job *job);
+
+/*
+ * Initialisation function to be used whenever a density_map structure is declared.
+ */
+void structInitDensityMap(density_map *map);
+
+/*
+ * Initialisation function to be used whenever a coverage_mask structure is declared.
+ */
+void structInitCoverageMask(coverage_mask *mask);
+
+/*
+ * Initialisation function to be used whenever a text_cache structure is declared.
+ */
+void structInitTextCache(text_cache *cache);
+
+/*
+ * Initialisation function to be used whenever a trace_log structure is declared.
+ */
+void structInitTraceLog(trace_log *log);
+
+/*
+ * Initialisation function to be used whenever a ui_layers structure is declared.
+ */
+void structInitUiLayers(ui_layers *layers);
+
+/*
+ * Initialisation function to be used whenever a scrub_state structure is declared.
+ */
+void structInitScrubState(scrub_state *scrub);
+
+/*
+ * Initialisation function to be used whenever a stage_timings structure is declared.
+ */
+void structInitStageTimings(stage_timings *timings);
+
+/*
+ * Initialisation function to be used whenever a frame_stats structure is declared.
+ */
+void structInitFrameStats(frame_stats *stats);
+
+/*
+ * Initialisation function to be used whenever a video_stream structure is declared.
+ */
+void structInitVideoStream(video_stream *video);
+
+/*
+ * Initialisation function to be used whenever a png_stream structure is declared.
+ */
+void structInitPngStream(png_stream *png);
+
+/*
+ * Initialisation function to be used whenever a batch_runner structure is declared.
+ */
+void structInitBatchRunner(batch_runner *batch);
+
+/*
+ * Initialisation function to be used whenever a bench_settings structure is declared.
+ */
+void structInitBenchSettings(bench_settings *bench);
+
+/*
+ * Initialisation function to be used whenever a sweep_runner structure is declared.
+ */
+void structInitSweepRunner(sweep_runner *sweep);
+
+/*
+ * Initialisation function to be used whenever a seq_exporter structure is declared.
+ */
+void structInitSeqExporter(seq_exporter *exporter);
+
 #endif
@@ -0,0 +1,233 @@
+/**
+ * \file svg.c
+ *
+ * \brief A source file for exporting a line list as an svg file, which has no size limit
+ * and stays sharp at any zoom.
+ *
+ * The file is written as the line list is read, so nothing more than the file buffer is
+ * held however many lines there are. Each coordinate is scaled into the image and rounded
+ * to a fixed number of decimal places. The turtle draws most lines from where the last one
+ * ended, so lines that join up are written as one run of relative commands, using h and v
+ * for lines that only move in one direction and leaving out repeated command letters, and
+ * a relative move is only written where the turtle jumps. Every SVG_PATH_LINES lines a new
+ * path element is started, so no single attribute grows without limit.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "svg.h"
+
+
+/*
+ * Scales a value and rounds it to a whole number of steps of the precision.
+ */
+static long long quantize(double value, double scale, double offset, double steps);
+
+/*
+ * Writes a rounded value, separated from the number before it only where that is needed.
+ */
+static void writeNumber(FILE *file, long long value, int precision, int *separate);
+
+/*
+ * Writes a path command letter if it is not already the current command.
+ */
+static void writeCommand(FILE *file, char command, char *current, int *separate);
+
+
+int saveSVG(line *line_list, int length, double scale, coordinate offset, int width, int height, SDL_Colour bg_colour, SDL_Colour ln_colour, int precision, char *name){
+	/**
+	 * \brief Streams a line list to an svg file as paths of connected lines.
+	 *
+	 * Each point is placed at offset + scale*point, as rasterFractal() places it, and rounded
+	 * to precision decimal places. Lines that are shorter than the precision are left out.
+	 *
+	 * \param[in] line_list 	the lines to be written.
+	 * \param[in] length 		number of lines in the line list.
+	 * \param[in] scale 		how much to scale each point by.
+	 * \param[in] offset 		where to move the origin of the line list to.
+	 * \param[in] width 		width of the image.
+	 * \param[in] height 		height of the image.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] ln_colour 	colour for the lines.
+	 * \param[in] precision 	number of decimal places, from 0 to SVG_MAX_PRECISION.
+	 * \param[in] name 			file name for the svg.
+	 *
+	 * \return 					1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	FILE *file = fopen(name, "w");
+	double steps = 1;
+	long long pen_x = 0;
+	long long pen_y = 0;
+	long long start_x = 0;
+	long long start_y = 0;
+	long long end_x = 0;
+	long long end_y = 0;
+	char current = 0;
+	int separate = 0;
+	int path_lines = 0;
+	int written = 0;
+	int i = 0;
+
+	if (file == NULL){
+		printf("Could not save %s\n", name);
+		return 0;
+	}
+
+	if (precision < 0)
+		precision = 0;
+	if (precision > SVG_MAX_PRECISION)
+		precision = SVG_MAX_PRECISION;
+	for (i = 0; i < precision; i++)
+		steps *= 10;
+
+	fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n", width, height, width, height);
+	fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"#%02x%02x%02x\"/>\n", bg_colour.r, bg_colour.g, bg_colour.b);
+	fprintf(file, "<g fill=\"none\" stroke=\"#%02x%02x%02x\" stroke-width=\"1\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n", ln_colour.r, ln_colour.g, ln_colour.b);
+
+	for (i = 0; i < length; i++){
+		start_x = quantize(line_list[i].start.x_pos, scale, offset.x_pos, steps);
+		start_y = quantize(line_list[i].start.y_pos, scale, offset.y_pos, steps);
+		end_x = quantize(line_list[i].end.x_pos, scale, offset.x_pos, steps);
+		end_y = quantize(line_list[i].end.y_pos, scale, offset.y_pos, steps);
+		if (start_x == end_x && start_y == end_y)
+			continue;
+
+		//starting a new path element with an absolute move, or moving to a line that does not join on
+		if (path_lines == SVG_PATH_LINES){
+			fprintf(file, "\"/>\n");
+			path_lines = 0;
+		}
+		if (path_lines == 0){
+			fprintf(file, "<path d=\"");
+			current = 0;
+			writeCommand(file, 'M', &current, &separate);
+			writeNumber(file, start_x, precision, &separate);
+			writeNumber(file, start_y, precision, &separate);
+		}
+		else if (start_x != pen_x || start_y != pen_y){
+			//numbers after a move are lines, so the l can be left out after it
+			writeCommand(file, 'm', &current, &separate);
+			writeNumber(file, start_x - pen_x, precision, &separate);
+			writeNumber(file, start_y - pen_y, precision, &separate);
+			current = 'l';
+		}
+
+		//the line itself, relative to where it starts
+		if (end_y == start_y){
+			writeCommand(file, 'h', &current, &separate);
+			writeNumber(file, end_x - start_x, precision, &separate);
+		}
+		else if (end_x == start_x){
+			writeCommand(file, 'v', &current, &separate);
+			writeNumber(file, end_y - start_y, precision, &separate);
+		}
+		else {
+			writeCommand(file, 'l', &current, &separate);
+			writeNumber(file, end_x - start_x, precision, &separate);
+			writeNumber(file, end_y - start_y, precision, &separate);
+		}
+
+		pen_x = end_x;
+		pen_y = end_y;
+		path_lines++;
+	}
+
+	if (path_lines > 0)
+		fprintf(file, "\"/>\n");
+	fprintf(file, "</g>\n</svg>\n");
+
+	written = !ferror(file);
+	if (fclose(file) != 0)
+		written = 0;
+	if (!written)
+		printf("Could not save %s\n", name);
+
+	return written;
+}
+
+static long long quantize(double value, double scale, double offset, double steps){
+	/**
+	 * \brief Scales a value and rounds it to a whole number of steps of the precision.
+	 *
+	 * \param[in] value 	the value from the line list.
+	 * \param[in] scale 	how much to scale the value by.
+	 * \param[in] offset 	where to move the origin to.
+	 * \param[in] steps 	number of steps in each unit, 10 to the power of the precision.
+	 *
+	 * \return 				the rounded value in steps.
+	 */
+
+	return (long long)floor((offset + scale*value)*steps + 0.5);
+}
+
+static void writeNumber(FILE *file, long long value, int precision, int *separate){
+	/**
+	 * \brief Writes a rounded value, separated from the number before it only where that is needed.
+	 *
+	 * Trailing zeros after the decimal point are left out, and so is the decimal point if nothing
+	 * is left after it. A minus sign separates numbers on its own.
+	 *
+	 * \param[out] file 		the file being written.
+	 * \param[in] value 		the value in steps of the precision.
+	 * \param[in] precision 	number of decimal places.
+	 * \param[in,out] separate 	true if a number has been written since the last command letter.
+	 */
+
+	long long whole = 0;
+	long long fraction = 0;
+	long long steps = 1;
+	int places = precision;
+	int i = 0;
+
+	for (i = 0; i < precision; i++)
+		steps *= 10;
+
+	if (value < 0){
+		fputc('-', file);
+		value = -value;
+	}
+	else if (*separate)
+		fputc(' ', file);
+	*separate = 1;
+
+	whole = value/steps;
+	fraction = value % steps;
+	fprintf(file, "%lld", whole);
+	if (fraction == 0)
+		return;
+
+	while (fraction % 10 == 0){
+		fraction /= 10;
+		places--;
+	}
+	fprintf(file, ".%0*lld", places, fraction);
+}
+
+static void writeCommand(FILE *file, char command, char *current, int *separate){
+	/**
+	 * \brief Writes a path command letter if it is not already the current command.
+	 *
+	 * Numbers after a command carry on using it until another is written, so a run of lines
+	 * going the same way only needs one letter.
+	 *
+	 * \param[out] file 		the file being written.
+	 * \param[in] command 		the command letter.
+	 * \param[in,out] current 	the command in use, changed to command.
+	 * \param[out] separate 	cleared if a letter is written, as a number can follow it directly.
+	 */
+
+	if (*current == command)
+		return;
+
+	fputc(command, file);
+	*current = command;
+	*separate = 0;
+}
@@ -0,0 +1,17 @@
+#ifndef _SVG_H_
+#define _SVG_H_
+
+/** \brief Number of decimal places coordinates are rounded to unless another precision is given.*/
+#define SVG_DEFAULT_PRECISION 1
+/** \brief Largest number of decimal places coordinates can be rounded to.*/
+#define SVG_MAX_PRECISION 6
+/** \brief Number of lines written to each path element before another is started.*/
+#define SVG_PATH_LINES 10000
+
+
+/*
+ * Streams a line list to an svg file as paths of connected lines.
+ */
+int saveSVG(line *line_list, int length, double scale, coordinate offset, int width, int height, SDL_Colour bg_colour, SDL_Colour ln_colour, int precision, char *name);
+
+#endif
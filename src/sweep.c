@@ -0,0 +1,358 @@
+/**
+ * \file sweep.c
+ *
+ * \brief A source file for writing videos where the angle or line length of a fractal
+ * sweeps over a range from the first frame to the last.
+ *
+ * Neither setting changes the string, so it is made once and shared, read only, by a
+ * pool of threads. Each thread takes the next frame, runs its own turtle over the string
+ * at that frame's angle, or scales the one unit line list for that frame's line length,
+ * and draws the frame into a slot of a reorder buffer. Frames finish out of order, so the
+ * thread that started the sweep writes them from the reorder buffer in order, and a
+ * thread only takes a frame once the slot it will be drawn into has been written, which
+ * keeps the memory held to SWEEP_SLOTS_PER_THREAD images for each thread.
+ *
+ * Each frame of an angle sweep is fitted to the image on its own, as the shape changes.
+ * A line length sweep only changes the size, so the lines are fitted at the largest line
+ * length and the other frames are scaled about the centre of the image.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "raster.h"
+#include "video.h"
+#include "headless.h"
+#include "timing.h"
+#include "sweep.h"
+
+
+/*
+ * Main loop of each thread drawing frames.
+ */
+static int sweepThread(void *data);
+
+/*
+ * Draws one frame of a sweep into an image.
+ */
+static int drawSweepFrame(sweep_runner *sweep, int frame, raster_image *image);
+
+/*
+ * Returns the value of the swept setting in a frame.
+ */
+static double sweepValue(render_job *job, int frame);
+
+/*
+ * Returns the number of threads drawing a job's frames.
+ */
+static int sweepThreads(render_job *job);
+
+
+int findSweep(char *name){
+	/**
+	 * \brief Returns the sweep named by a setting value, or 0 if there is none.
+	 *
+	 * \param[in] name 		"angle" or "length".
+	 */
+
+	if (strcmp(name, "angle") == 0)
+		return SWEEP_ANGLE;
+	if (strcmp(name, "length") == 0)
+		return SWEEP_LENGTH;
+
+	return 0;
+}
+
+size_t sweepBytes(render_job *job, double segments){
+	/**
+	 * \brief Returns the number of bytes drawing a sweep is expected to hold, not counting the string or the shared line list.
+	 *
+	 * That is the images of the reorder buffer, a coverage level for each pixel of the frame each
+	 * thread is drawing with anti-aliased lines, and for an angle sweep the line list each thread
+	 * makes.
+	 *
+	 * \param[in] job 		the job.
+	 * \param[in] segments 	number of lines in each frame.
+	 *
+	 * \return 				the number of bytes.
+	 */
+
+	double threads = sweepThreads(job);
+	double pixels = (double)job->width*job->height;
+	double bytes = threads*SWEEP_SLOTS_PER_THREAD*pixels*sizeof(Uint32);
+
+	if (job->antialias)
+		bytes += threads*pixels;
+	if (job->sweep == SWEEP_ANGLE)
+		bytes += threads*segments*sizeof(line);
+
+	return bytes;
+}
+
+int renderSweep(render_job *job, lsystem *lsys, line *unit_lines, int unit_length, SDL_Colour bg_colour, SDL_Colour ln_colour){
+	/**
+	 * \brief Draws a video of a setting sweeping over a range, drawing the frames in parallel and writing them in order.
+	 *
+	 * The threads are started and this thread writes the frames as they become ready. The job is
+	 * given the time spent writing as its encode time, and the rest of the time as its raster
+	 * time, which includes the turtle for an angle sweep.
+	 *
+	 * \param[out] job 			the job, with a video format, frame count and sweep.
+	 * \param[in] lsys 			lsystem holding the string for an angle sweep.
+	 * \param[in] unit_lines 	line list made with a line length of 1 from (0, 0) for a line length sweep, NULL for an angle sweep.
+	 * \param[in] unit_length 	number of lines in the unit line list.
+	 * \param[in] bg_colour 	colour for the background.
+	 * \param[in] ln_colour 	colour for the lines.
+	 *
+	 * \return 					1 if every frame was written, 0 if not.
+	 */
+
+	sweep_runner sweep;
+	video_stream video;
+	SDL_Thread **threads = NULL;
+	int frames = job->frames > 0 ? job->frames : RENDER_DEFAULT_FRAMES;
+	int thread_count = sweepThreads(job);
+	int started = 0;
+	int frame = 0;
+	int slot = 0;
+	int written = 0;
+	int i = 0;
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	Uint64 write_time = 0;
+
+	structInitSweepRunner(&sweep);
+	structInitVideoStream(&video);
+	sweep.job = job;
+	sweep.lsys = *lsys;
+	sweep.lsys.line_list = NULL;
+	sweep.lsys.cancel_flag = NULL;
+	sweep.lsys.progress = NULL;
+	sweep.lsys.length = 1;
+	structInitCoord(&(sweep.lsys.start));
+	sweep.unit_lines = unit_lines;
+	sweep.unit_length = unit_length;
+	sweep.bg_colour = bg_colour;
+	sweep.ln_colour = ln_colour;
+	if (thread_count > frames)
+		thread_count = frames;
+
+	//every frame has the same number of lines whatever the angle
+	job->segments = job->sweep == SWEEP_ANGLE ? countMoves(lsys->string) : unit_length;
+
+	//fitting the lines at the largest line length, so every frame of a line length sweep fits
+	if (job->sweep == SWEEP_LENGTH)
+		fitLines(unit_lines, unit_length, job->width, job->height, RENDER_MARGIN, &(sweep.scale), &(sweep.offset));
+
+	//allocating the reorder buffer
+	sweep.slot_count = thread_count*SWEEP_SLOTS_PER_THREAD;
+	sweep.slots = (raster_image*)malloc(sweep.slot_count*sizeof(raster_image));
+	sweep.ready = (int*)malloc(sweep.slot_count*sizeof(int));
+	threads = (SDL_Thread**)malloc(thread_count*sizeof(SDL_Thread*));
+	sweep.lock = SDL_CreateMutex();
+	sweep.changed = SDL_CreateCond();
+	if (sweep.slots == NULL || sweep.ready == NULL || threads == NULL || sweep.lock == NULL || sweep.changed == NULL){
+		fprintf(stderr, "%s: sweep memory allocation failed\n", job->out);
+		sweep.failed = 1;
+	}
+	for (i = 0; !sweep.failed && i < sweep.slot_count; i++){
+		structInitRasterImage(&(sweep.slots[i]));
+		sweep.ready[i] = -1;
+	}
+	for (i = 0; !sweep.failed && i < sweep.slot_count; i++){
+		if (!initRaster(&(sweep.slots[i]), job->width, job->height)){
+			fprintf(stderr, "%s: sweep memory allocation failed\n", job->out);
+			sweep.failed = 1;
+		}
+	}
+
+	if (!sweep.failed && !openVideo(&video, job->out, job->video_format, job->width, job->height, job->fps))
+		sweep.failed = 1;
+
+	//starting the threads
+	for (i = 0; !sweep.failed && i < thread_count; i++){
+		threads[i] = SDL_CreateThread(sweepThread, "sweep", &sweep);
+		if (threads[i] == NULL){
+			fprintf(stderr, "Could not create sweep thread: %s\n", SDL_GetError());
+			break;
+		}
+		started++;
+	}
+	if (started == 0)
+		sweep.failed = 1;
+
+	//writing the frames in order as they become ready
+	for (frame = 0; frame < frames && !sweep.failed; frame++){
+		slot = frame % sweep.slot_count;
+
+		SDL_LockMutex(sweep.lock);
+		while (sweep.ready[slot] != frame && !sweep.failed)
+			SDL_CondWait(sweep.changed, sweep.lock);
+		SDL_UnlockMutex(sweep.lock);
+		if (sweep.failed)
+			break;
+
+		write_time = SDL_GetPerformanceCounter();
+		written = writeVideoFrame(&video, &(sweep.slots[slot]));
+		job->encode_time += secondsSince(write_time);
+
+		//freeing the slot for the frame slot_count frames on
+		SDL_LockMutex(sweep.lock);
+		sweep.ready[slot] = -1;
+		sweep.next_write = frame + 1;
+		if (!written)
+			sweep.failed = 1;
+		SDL_CondBroadcast(sweep.changed);
+		SDL_UnlockMutex(sweep.lock);
+	}
+
+	//stopping the threads, which finish on their own unless a frame failed
+	if (sweep.lock != NULL){
+		SDL_LockMutex(sweep.lock);
+		if (frame < frames)
+			sweep.failed = 1;
+		SDL_CondBroadcast(sweep.changed);
+		SDL_UnlockMutex(sweep.lock);
+	}
+	for (i = 0; i < started; i++)
+		SDL_WaitThread(threads[i], NULL);
+
+	if (video.file != NULL && !closeVideo(&video))
+		sweep.failed = 1;
+	if (sweep.failed)
+		fprintf(stderr, "%s: could not write every frame\n", job->out);
+
+	for (i = 0; sweep.slots != NULL && sweep.ready != NULL && i < sweep.slot_count; i++)
+		freeRaster(&(sweep.slots[i]));
+	free(sweep.slots);
+	free(sweep.ready);
+	free(threads);
+	if (sweep.changed != NULL)
+		SDL_DestroyCond(sweep.changed);
+	if (sweep.lock != NULL)
+		SDL_DestroyMutex(sweep.lock);
+
+	job->raster_time += secondsSince(start_time) - job->encode_time;
+	return !sweep.failed;
+}
+
+static int sweepThread(void *data){
+	/**
+	 * \brief Main loop of each thread drawing frames.
+	 *
+	 * Takes the next frame once its slot has been written, draws it without holding the lock and
+	 * marks it ready, until there are no frames left or a frame has failed.
+	 *
+	 * \param[in] data 		the sweep runner.
+	 *
+	 * \return 				0 when finished.
+	 */
+
+	sweep_runner *sweep = (sweep_runner*)data;
+	int frames = sweep->job->frames > 0 ? sweep->job->frames : RENDER_DEFAULT_FRAMES;
+	int frame = 0;
+	int slot = 0;
+	int drawn = 0;
+
+	SDL_LockMutex(sweep->lock);
+	while (1){
+		while (!sweep->failed && sweep->next_frame < frames && sweep->next_frame >= sweep->next_write + sweep->slot_count)
+			SDL_CondWait(sweep->changed, sweep->lock);
+		if (sweep->failed || sweep->next_frame >= frames)
+			break;
+
+		frame = sweep->next_frame++;
+		slot = frame % sweep->slot_count;
+		SDL_UnlockMutex(sweep->lock);
+
+		drawn = drawSweepFrame(sweep, frame, &(sweep->slots[slot]));
+
+		SDL_LockMutex(sweep->lock);
+		if (drawn)
+			sweep->ready[slot] = frame;
+		else
+			sweep->failed = 1;
+		SDL_CondBroadcast(sweep->changed);
+	}
+	SDL_UnlockMutex(sweep->lock);
+
+	return 0;
+}
+
+static int drawSweepFrame(sweep_runner *sweep, int frame, raster_image *image){
+	/**
+	 * \brief Draws one frame of a sweep into an image.
+	 *
+	 * For an angle sweep the turtle is run over the shared string with a copy of the lsystem, so
+	 * the line list belongs to this thread, and is freed once drawn.
+	 *
+	 * \param[in] sweep 		the sweep runner.
+	 * \param[in] frame 		index of the frame.
+	 * \param[out] image 	the image, the size of the job.
+	 *
+	 * \return 				1 if sucessfull, 0 if memory allocation failed.
+	 */
+
+	render_job *job = sweep->job;
+	lsystem lsys;
+	double value = sweepValue(job, frame);
+	double largest = job->sweep_from > job->sweep_to ? job->sweep_from : job->sweep_to;
+	double scale = 0;
+	coordinate offset;
+
+	clearRaster(image, sweep->bg_colour);
+
+	if (job->sweep == SWEEP_ANGLE){
+		lsys = sweep->lsys;
+		lsys.angle = dtor(value);
+		lsys.line_list_length = stringToTurtle(&lsys);
+		if (lsys.line_list == NULL)
+			return 0;
+		fitLines(lsys.line_list, lsys.line_list_length, job->width, job->height, RENDER_MARGIN, &scale, &offset);
+		rasterFractal(image, lsys.line_list, lsys.line_list_length, scale, offset, sweep->ln_colour, job->antialias);
+		free(lsys.line_list);
+		return 1;
+	}
+
+	//scaling the lines fitted at the largest line length about the centre of the image
+	scale = sweep->scale*value/largest;
+	offset.x_pos = job->width/2.0 - value/largest*(job->width/2.0 - sweep->offset.x_pos);
+	offset.y_pos = job->height/2.0 - value/largest*(job->height/2.0 - sweep->offset.y_pos);
+	rasterFractal(image, sweep->unit_lines, sweep->unit_length, scale, offset, sweep->ln_colour, job->antialias);
+	return 1;
+}
+
+static double sweepValue(render_job *job, int frame){
+	/**
+	 * \brief Returns the value of the swept setting in a frame.
+	 *
+	 * The value moves in equal steps from sweep_from in the first frame to sweep_to in the last.
+	 *
+	 * \param[in] job 		the job.
+	 * \param[in] frame 	index of the frame.
+	 */
+
+	int frames = job->frames > 0 ? job->frames : RENDER_DEFAULT_FRAMES;
+
+	if (frames < 2)
+		return job->sweep_from;
+
+	return job->sweep_from + (job->sweep_to - job->sweep_from)*frame/(frames - 1);
+}
+
+static int sweepThreads(render_job *job){
+	/**
+	 * \brief Returns the number of threads drawing a job's frames.
+	 *
+	 * \param[in] job 		the job, whose thread count is used if it was given.
+	 */
+
+	int threads = job->threads > 0 ? job->threads : SDL_GetCPUCount();
+
+	return threads > 0 ? threads : 1;
+}
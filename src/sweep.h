@@ -0,0 +1,27 @@
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+/** \brief The angle is swept across the frames, and the turtle is run for each frame.*/
+#define SWEEP_ANGLE 1
+/** \brief The line length is swept across the frames, and the lines are only scaled for each frame.*/
+#define SWEEP_LENGTH 2
+/** \brief Number of slots in the reorder buffer for each thread drawing frames.*/
+#define SWEEP_SLOTS_PER_THREAD 2
+
+
+/*
+ * Returns the sweep named by a setting value, or 0 if there is none.
+ */
+int findSweep(char *name);
+
+/*
+ * Returns the number of bytes drawing a sweep is expected to hold, not counting the string or the shared line list.
+ */
+size_t sweepBytes(render_job *job, double segments);
+
+/*
+ * Draws a video of a setting sweeping over a range, drawing the frames in parallel and writing them in order.
+ */
+int renderSweep(render_job *job, lsystem *lsys, line *unit_lines, int unit_length, SDL_Colour bg_colour, SDL_Colour ln_colour);
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * \file textcache.c
+ *
+ * \brief A source file for the text cache, which holds text rendered to textures so that
+ * the labels and instructions drawn on every frame are only rendered once.
+ *
+ * Rendering text with SDL_ttf and turning it into a texture takes far longer than copying
+ * the texture, and nearly all of the text on the screens is the same from one frame to the
+ * next. Entries are found by the font, text and colour, checked first by a hash, and when
+ * the cache is full the least recently used entry is replaced, so text that changes, like
+ * the numbers in the info overlay, only pushes out text that is no longer shown.
+ *
+ * The cache belongs to the renderer its textures were made for, and is attached to the
+ * window with SDL_SetWindowData() so drawTextToRenderer() can find it from the renderer.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "textcache.h"
+
+
+/*
+ * Makes a 32 bit FNV-1a hash of a font, text and colour.
+ */
+static Uint32 hashText(TTF_Font *font, char *text, SDL_Colour colour);
+
+
+void freeTextCache(text_cache *cache){
+	/**
+	 * \brief Destroys every texture held by a text cache.
+	 *
+	 * Must be called before the renderer the textures belong to is destroyed.
+	 *
+	 * \param[out] cache 	the cache, left empty.
+	 */
+
+	int i = 0;
+
+	for (i = 0; i < TEXT_CACHE_SIZE; i++)
+		if (cache->entries[i].texture != NULL)
+			SDL_DestroyTexture(cache->entries[i].texture);
+
+	structInitTextCache(cache);
+}
+
+text_cache *rendererTextCache(SDL_Renderer *renderer){
+	/**
+	 * \brief Returns the text cache attached to the window a renderer draws to, or NULL if there is none.
+	 *
+	 * \param[in] renderer 	the renderer.
+	 */
+
+	SDL_Window *window = SDL_RenderGetWindow(renderer);
+
+	if (window == NULL)
+		return NULL;
+
+	return (text_cache*)SDL_GetWindowData(window, TEXT_CACHE_DATA);
+}
+
+SDL_Texture *cachedText(text_cache *cache, SDL_Renderer *renderer, TTF_Font *font, char *text, SDL_Colour colour, int *width, int *height){
+	/**
+	 * \brief Returns a texture of some text in a font and colour, rendering it only if the cache does not hold it.
+	 *
+	 * The texture belongs to the cache and must not be destroyed. Text of TEXT_CACHE_LENGTH
+	 * characters or more is not held, and NULL is returned so it can be rendered as usual.
+	 *
+	 * \param[out] cache 		the cache.
+	 * \param[in] renderer 		renderer the texture is made for.
+	 * \param[in] font 			font for the text.
+	 * \param[in] text 			the text.
+	 * \param[in] colour 		colour for the text.
+	 * \param[out] width 		width of the texture in pixels.
+	 * \param[out] height 		height of the texture in pixels.
+	 *
+	 * \return 					the texture, or NULL if the text is too long or could not be rendered.
+	 */
+
+	Uint32 hash = 0;
+	text_entry *entry = NULL;
+	SDL_Surface *surface = NULL;
+	int oldest = 0;
+	int i = 0;
+
+	if (strlen(text) >= TEXT_CACHE_LENGTH)
+		return NULL;
+
+	hash = hashText(font, text, colour);
+	cache->clock++;
+
+	//looking for the text, and the least recently used entry in case it is not held
+	for (i = 0; i < TEXT_CACHE_SIZE; i++){
+		entry = &(cache->entries[i]);
+		if (entry->font == font && entry->hash == hash && strcmp(entry->text, text) == 0 && entry->colour.r == colour.r && entry->colour.g == colour.g && entry->colour.b == colour.b && entry->colour.a == colour.a){
+			entry->last_used = cache->clock;
+			cache->hits++;
+			*width = entry->width;
+			*height = entry->height;
+			return entry->texture;
+		}
+		if (entry->last_used < cache->entries[oldest].last_used)
+			oldest = i;
+	}
+
+	//rendering the text in place of the least recently used entry
+	cache->misses++;
+	entry = &(cache->entries[oldest]);
+	if (entry->texture != NULL)
+		SDL_DestroyTexture(entry->texture);
+	entry->font = NULL;
+	entry->texture = NULL;
+
+	surface = TTF_RenderText_Solid(font, text, colour);
+	if (surface == NULL)
+		return NULL;
+	entry->texture = SDL_CreateTextureFromSurface(renderer, surface);
+	SDL_FreeSurface(surface);
+	if (entry->texture == NULL)
+		return NULL;
+
+	entry->font = font;
+	strcpy(entry->text, text);
+	entry->colour = colour;
+	entry->hash = hash;
+	entry->last_used = cache->clock;
+	SDL_QueryTexture(entry->texture, NULL, NULL, &(entry->width), &(entry->height));
+
+	*width = entry->width;
+	*height = entry->height;
+	return entry->texture;
+}
+
+static Uint32 hashText(TTF_Font *font, char *text, SDL_Colour colour){
+	/**
+	 * \brief Makes a 32 bit FNV-1a hash of a font, text and colour.
+	 *
+	 * \param[in] font 		the font, hashed by its address.
+	 * \param[in] text 		the text.
+	 * \param[in] colour 	the colour.
+	 *
+	 * \return 				the hash.
+	 */
+
+	Uint32 hash = 2166136261u;
+	unsigned char *bytes = (unsigned char*)&font;
+	size_t i = 0;
+
+	for (i = 0; i < sizeof(font); i++)
+		hash = (hash ^ bytes[i])*16777619u;
+	for (i = 0; text[i] != '\0'; i++)
+		hash = (hash ^ (unsigned char)text[i])*16777619u;
+	hash = (hash ^ colour.r)*16777619u;
+	hash = (hash ^ colour.g)*16777619u;
+	hash = (hash ^ colour.b)*16777619u;
+	hash = (hash ^ colour.a)*16777619u;
+
+	return hash;
+}
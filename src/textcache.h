@@ -0,0 +1,23 @@
+#ifndef _TEXTCACHE_H_
+#define _TEXTCACHE_H_
+
+/** \brief Name the text cache is attached to the window under with SDL_SetWindowData().*/
+#define TEXT_CACHE_DATA "text_cache"
+
+
+/*
+ * Destroys every texture held by a text cache.
+ */
+void freeTextCache(text_cache *cache);
+
+/*
+ * Returns the text cache attached to the window a renderer draws to, or NULL if there is none.
+ */
+text_cache *rendererTextCache(SDL_Renderer *renderer);
+
+/*
+ * Returns a texture of some text in a font and colour, rendering it only if the cache does not hold it.
+ */
+SDL_Texture *cachedText(text_cache *cache, SDL_Renderer *renderer, TTF_Font *font, char *text, SDL_Colour colour, int *width, int *height);
+
+#endif
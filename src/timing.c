@@ -0,0 +1,36 @@
+/**
+ * \file timing.c
+ *
+ * \brief A source file for measuring how long the stages of making and drawing a fractal take.
+ *
+ * Every stage is timed from a value of SDL_GetPerformanceCounter() taken when it starts. The
+ * headless renderer, the batch runner and the benchmark suite report times in seconds, and the
+ * drawing screen and the worker thread in milliseconds, so both are worked out here.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "timing.h"
+
+
+double secondsSince(Uint64 start_time){
+	/**
+	 * \brief Returns the number of seconds since a performance counter value.
+	 *
+	 * \param[in] start_time 	a value from SDL_GetPerformanceCounter().
+	 */
+
+	return (double)(SDL_GetPerformanceCounter() - start_time)/SDL_GetPerformanceFrequency();
+}
+
+double millisecondsSince(Uint64 start_time){
+	/**
+	 * \brief Returns the number of milliseconds since a performance counter value.
+	 *
+	 * \param[in] start_time 	a value from SDL_GetPerformanceCounter().
+	 */
+
+	return 1000.0*(SDL_GetPerformanceCounter() - start_time)/SDL_GetPerformanceFrequency();
+}
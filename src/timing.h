@@ -0,0 +1,14 @@
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+/*
+ * Returns the number of seconds since a performance counter value.
+ */
+double secondsSince(Uint64 start_time);
+
+/*
+ * Returns the number of milliseconds since a performance counter value.
+ */
+double millisecondsSince(Uint64 start_time);
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * \file trace.c
+ *
+ * \brief A source file for recording a trace of where the program's time goes, which can be
+ * loaded into about://tracing or Perfetto without attaching a profiler.
+ *
+ * Each stage that is traced asks traceBegin() for the time it begins, and hands it to
+ * traceEnd() with its name when it ends, which records the span in a ring buffer belonging
+ * to the calling thread. A thread is given its ring the first time it records a span, and
+ * finds it again through thread local storage, so recording a span takes no lock and never
+ * waits for another thread. Each ring only ever has the one writer, which writes the span
+ * and then moves the count on, so the spans below the count are always whole. When a ring
+ * is full the oldest spans are overwritten.
+ *
+ * With no trace log (a NULL pointer), traceBegin() and traceEnd() return straight away, so
+ * the traced stages cost nothing when the program is not being traced.
+ *
+ * The trace is written as Chrome trace event JSON, each span being a complete ("X") event
+ * with the id of the thread that recorded it and times in microseconds from when tracing
+ * started. Spans nest by time, so makeString() shows each of its iterations inside it.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "trace.h"
+
+
+/*
+ * Hands the calling thread its ring buffer, or returns NULL if there are none left.
+ */
+static trace_ring *claimRing(trace_log *log);
+
+
+int startTrace(trace_log *log, char *file){
+	/**
+	 * \brief Starts a trace log that will be written to a file.
+	 *
+	 * \param[out] log 		a log initialised with structInitTraceLog().
+	 * \param[in] file 		name of the file the trace is written to.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file name is too long or thread local storage could not be made.
+	 */
+
+	if (strlen(file) >= sizeof(log->file)){
+		printf("trace file name is too long\n");
+		return 0;
+	}
+
+	log->ring_id = SDL_TLSCreate();
+	if (log->ring_id == 0){
+		printf("Could not start tracing: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	strcpy(log->file, file);
+	log->origin = SDL_GetPerformanceCounter();
+	return 1;
+}
+
+Uint64 traceBegin(trace_log *log){
+	/**
+	 * \brief Returns the time a span begins, to be handed to traceEnd() when it ends.
+	 *
+	 * \param[in] log 		the trace log, or NULL when not tracing.
+	 *
+	 * \return 				a performance counter value, or 0 when not tracing.
+	 */
+
+	if (log == NULL)
+		return 0;
+
+	return SDL_GetPerformanceCounter();
+}
+
+void traceEnd(trace_log *log, const char *name, Uint64 begin){
+	/**
+	 * \brief Records a span from a time returned by traceBegin() until now, in the calling thread's ring buffer.
+	 *
+	 * Spans from a thread after TRACE_THREADS others have recorded spans are dropped.
+	 *
+	 * \param[out] log 		the trace log, or NULL when not tracing.
+	 * \param[in] name 		name of the stage, a string that lives as long as the program, like a string literal.
+	 * \param[in] begin 	value returned by traceBegin() when the stage began.
+	 */
+
+	trace_ring *ring = NULL;
+	trace_event *event = NULL;
+	int count = 0;
+
+	if (log == NULL)
+		return;
+
+	ring = (trace_ring*)SDL_TLSGet(log->ring_id);
+	if (ring == NULL)
+		ring = claimRing(log);
+	if (ring == NULL || ring->events == NULL)
+		return;
+
+	//writing the span before moving the count on past it
+	count = SDL_AtomicGet(&(ring->count));
+	event = &(ring->events[(unsigned)count % TRACE_EVENTS]);
+	event->name = name;
+	event->begin = begin;
+	event->end = SDL_GetPerformanceCounter();
+	SDL_AtomicSet(&(ring->count), count + 1);
+}
+
+int writeTrace(trace_log *log){
+	/**
+	 * \brief Writes every span held by a trace log to its file as Chrome trace event JSON.
+	 *
+	 * The file is written again from the start each time, so it can be written while the program
+	 * runs and again when it exits. While other threads are still recording, a full ring could be
+	 * overwriting its oldest spans as they are read, so the oldest sixteenth of a full ring is
+	 * left out.
+	 *
+	 * \param[in] log 		the trace log.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be written.
+	 */
+
+	FILE *file = NULL;
+	trace_ring *ring = NULL;
+	trace_event *event = NULL;
+	double frequency = SDL_GetPerformanceFrequency()/1000000.0;
+	int rings = SDL_AtomicGet(&(log->ring_count));
+	unsigned count = 0;
+	unsigned first = 0;
+	unsigned i = 0;
+	int spans = 0;
+	int r = 0;
+
+	file = fopen(log->file, "w");
+	if (file == NULL){
+		printf("Could not open %s to write the trace\n", log->file);
+		return 0;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for (r = 0; r < rings && r < TRACE_THREADS; r++){
+		ring = &(log->rings[r]);
+		if (!SDL_AtomicGet(&(ring->ready)))
+			continue;
+
+		count = (unsigned)SDL_AtomicGet(&(ring->count));
+		first = count > TRACE_EVENTS ? count - TRACE_EVENTS + TRACE_EVENTS/16 : 0;
+		for (i = first; i < count; i++){
+			event = &(ring->events[i % TRACE_EVENTS]);
+			fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}", spans > 0 ? "," : "", event->name, TRACE_PID, (unsigned long)ring->thread, (event->begin - log->origin)/frequency, (event->end - event->begin)/frequency);
+			spans++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	if (fclose(file) != 0){
+		printf("Could not write the trace to %s\n", log->file);
+		return 0;
+	}
+
+	printf("trace of %d spans written to %s\n", spans, log->file);
+	return 1;
+}
+
+void freeTrace(trace_log *log){
+	/**
+	 * \brief Frees the ring buffers of a trace log.
+	 *
+	 * Must only be called once every thread that records spans has stopped.
+	 *
+	 * \param[out] log 		the trace log, which is left initialised and not tracing.
+	 */
+
+	int i = 0;
+
+	for (i = 0; i < TRACE_THREADS; i++)
+		free(log->rings[i].events);
+
+	structInitTraceLog(log);
+}
+
+static trace_ring *claimRing(trace_log *log){
+	/**
+	 * \brief Hands the calling thread its ring buffer, or returns NULL if there are none left.
+	 *
+	 * The rings are handed out with an atomic counter, so two threads recording their first spans
+	 * at once are given different rings. The ring is only marked ready, for writeTrace() to read,
+	 * once its spans are allocated.
+	 *
+	 * \param[out] log 		the trace log.
+	 *
+	 * \return 				the ring, with its events left NULL if they could not be allocated.
+	 */
+
+	trace_ring *ring = NULL;
+	int index = SDL_AtomicAdd(&(log->ring_count), 1);
+
+	if (index >= TRACE_THREADS)
+		return NULL;
+
+	ring = &(log->rings[index]);
+	ring->thread = SDL_ThreadID();
+	ring->events = (trace_event*)malloc(TRACE_EVENTS*sizeof(trace_event));
+	if (ring->events == NULL)
+		printf("trace memory allocation failed, spans from this thread are dropped\n");
+	else
+		SDL_AtomicSet(&(ring->ready), 1);
+
+	SDL_TLSSet(log->ring_id, ring, NULL);
+	return ring;
+}
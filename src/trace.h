@@ -0,0 +1,35 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/** \brief Process id written for every span, as the trace only ever holds one process.*/
+#define TRACE_PID 1
+/** \brief Key that writes the trace recorded so far while the window is open.*/
+#define TRACE_KEY SDLK_F9
+
+
+/*
+ * Starts a trace log that will be written to a file.
+ */
+int startTrace(trace_log *log, char *file);
+
+/*
+ * Returns the time a span begins, to be handed to traceEnd() when it ends.
+ */
+Uint64 traceBegin(trace_log *log);
+
+/*
+ * Records a span from a time returned by traceBegin() until now, in the calling thread's ring buffer.
+ */
+void traceEnd(trace_log *log, const char *name, Uint64 begin);
+
+/*
+ * Writes every span held by a trace log to its file as Chrome trace event JSON.
+ */
+int writeTrace(trace_log *log);
+
+/*
+ * Frees the ring buffers of a trace log.
+ */
+void freeTrace(trace_log *log);
+
+#endif
@@ -20,6 +20,7 @@
 #include "structs.h"
 #include "turtle.h"
 #include "lsys.h"
+#include "trace.h"
 
 int stringToTurtle(lsystem *lsys){
 	/**
@@ -32,15 +33,19 @@ int stringToTurtle(lsystem *lsys){
 	 * updated and everytime it draws a line, one is added to the line list and if the position needs to be 
 	 * stored or retrieved from the turtle stack then it extracts or adds to the top element of the linked 
 	 * list.
+	 *
+	 * If the lsystem is being made on the worker thread, the job is checked for cancellation every
+	 * so often and progress is reported as the second half of the job.
 	 * 
 	 * \param[out] lsys 		pointer to the lsystem (needed for angle incriment and line length).
 	 * 
-	 * \return			the number of coordinate pairs that are held in the line_list.
+	 * \return			the number of coordinate pairs that are held in the line_list (0 if the job was cancelled).
 	 */
 
 	//initialising variables
 	int i = 0; 
 	int line_list_pos = 0;
+	Uint64 trace_begin = traceBegin(lsys->trace);
 	turtle_state current_turtle; 
 	structInitTurtleState(&current_turtle);
 
@@ -61,9 +66,21 @@ int stringToTurtle(lsystem *lsys){
 		printf("memory allocation for line list failed\n");
 		return 1;
 	}
+	lsys->geometry_version++;
+
+	//the length of the string is only needed for reporting progress to the worker thread
+	int string_length = (lsys->progress != NULL) ? strlen(lsys->string) : 0;
 
 	// iterating through the string and performing the required action for each character
 	for (i = 0; lsys->string[i] != 0; i++){ 
+		//checking for cancellation and reporting progress every so often when on the worker thread
+		if ((i & 0xffff) == 0 && i > 0){
+			if (jobCancelled(lsys))
+				break;
+			if (string_length > 0)
+				reportProgress(lsys, 50 + (int)(50.0*i/string_length));
+		}
+
 		switch(lsys->string[i]){
 			case 'A': 
 			case 'B':
@@ -95,6 +112,15 @@ int stringToTurtle(lsystem *lsys){
 		}
 	}
 
+	traceEnd(lsys->trace, "stringToTurtle", trace_begin);
+
+	//a cancelled job throws away the part of the line list that was made
+	if (jobCancelled(lsys)){
+		free(lsys->line_list);
+		lsys->line_list = NULL;
+		return 0;
+	}
+
 	//returns the total number of line drawing characters in the string.
 	return num_moves;
 }
@@ -241,3 +267,54 @@ int countMoves(char *string){
 	return counter;
 }
 
+int placeLines(lsystem *lsys, line *unit_lines, int line_list_length){
+	/**
+	 * \brief Scales and moves a line list made with a line length of 1 from (0, 0) into the lsystem.
+	 *
+	 * The shape of the line list only depends on the rules, angle and depth, so it is kept in
+	 * this form by the geometry cache. Changing the line length or the start point then only
+	 * needs this one pass over the lines rather than running the turtle again.
+	 *
+	 * The placed lines are compared with the line list they replace as they are made, and the
+	 * geometry version is only changed if they differ, so anything drawn from the old line list,
+	 * such as the coverage mask, is kept when the same lines are placed again.
+	 *
+	 * \param[out] lsys 				lsystem that holds the line length and start point, and is given the new line list.
+	 * \param[in] unit_lines 			line list made with a line length of 1 from (0, 0).
+	 * \param[in] line_list_length 	number of lines in the line list.
+	 *
+	 * \return 						1 if sucessfull, 0 if memory allocation failed.
+	 */
+
+	int i = 0;
+	int changed = lsys->line_list_length != line_list_length || (line_list_length > 0 && lsys->line_list == NULL);
+	double length = lsys->length;
+	coordinate start = lsys->start;
+	line *placed = NULL;
+
+	//allocating and checking memory for the placed line list, an empty one is left as NULL
+	if (line_list_length > 0){
+		placed = (line*)malloc(line_list_length*sizeof(line));
+		if (placed == NULL){
+			printf("memory allocation for line list failed\n");
+			return 0;
+		}
+	}
+
+	for (i = 0; i < line_list_length; i++){
+		placed[i].start.x_pos = start.x_pos + length*unit_lines[i].start.x_pos;
+		placed[i].start.y_pos = start.y_pos + length*unit_lines[i].start.y_pos;
+		placed[i].end.x_pos = start.x_pos + length*unit_lines[i].end.x_pos;
+		placed[i].end.y_pos = start.y_pos + length*unit_lines[i].end.y_pos;
+		if (!changed && memcmp(&(placed[i]), &(lsys->line_list[i]), sizeof(line)) != 0)
+			changed = 1;
+	}
+
+	//replacing the old line list
+	free(lsys->line_list);
+	lsys->line_list = placed;
+	lsys->line_list_length = line_list_length;
+	if (changed)
+		lsys->geometry_version++;
+	return 1;
+}
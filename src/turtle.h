@@ -31,4 +31,9 @@ void penUpLine(turtle_state *current_turtle, int length);
  */
 int countMoves(char *string);
 
+/*
+ * Scales and moves a line list made with a line length of 1 from (0, 0) into the lsystem.
+ */
+int placeLines(lsystem *lsys, line *unit_lines, int line_list_length);
+
 #endif
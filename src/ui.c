@@ -18,9 +18,29 @@
 #include "structs.h"
 #include "lsys.h"
 #include "turtle.h"
+#include "worker.h"
+#include "cache.h"
+#include "spec.h"
+#include "raster.h"
+#include "export.h"
+#include "encode.h"
+#include "svg.h"
+#include "density.h"
+#include "coverage.h"
+#include "textcache.h"
+#include "scrub.h"
+#include "frame.h"
+#include "trace.h"
+#include "timing.h"
 #include "ui.h"
 
 
+/*
+ * Writes the time a stage took, or why it did not run, as a line of the timings overlay.
+ */
+static void stageText(char *text, char *stage, double time);
+
+
 void createHomeScreenButtons(btn *screen_buttons, TTF_Font *font){
 	/**
 	 * \brief Defines all of the buttons that will appear on the home screen.
@@ -136,84 +156,119 @@ void createDrawScreenButtons(btn *screen_buttons, TTF_Font *title_font, TTF_Font
 	coordinate pos_4 = {110, 200};
 	addButton(&(screen_buttons[5]), pos_4, width, height, colour_1, title_font, "+");
 
-	//show/hide info button;
+	//line length and angle drag controls, their lables are set from the values when they are drawn
+	coordinate pos_11 = {20, 140};
+	addButton(&(screen_buttons[13]), pos_11, 160, 25, colour_1, body_font, "Length");
+	coordinate pos_12 = {20, 245};
+	addButton(&(screen_buttons[12]), pos_12, 160, 30, colour_1, body_font, "Angle");
+
+	//line/density view button, its lable is set from the view when it is drawn
+	coordinate pos_9 = {20, 325};
+	addButton(&(screen_buttons[10]), pos_9, 160, 35, colour_1, body_font, "View");
+
+	//info button, cycles through hidden, shown and shown with timings, its lable is set from the info flag when it is drawn
 	coordinate pos_5 = {20, 370};
-	addButton(&(screen_buttons[6]), pos_5, 160, 40, colour_1, body_font, "Show/Hide Info");
+	addButton(&(screen_buttons[6]), pos_5, 160, 35, colour_1, body_font, "Info");
+
+	//sharp/smooth lines button, its lable is set from the lines when it is drawn
+	coordinate pos_10 = {20, 410};
+	addButton(&(screen_buttons[11]), pos_10, 160, 35, colour_1, body_font, "Lines");
 
 	//save img button
 	coordinate pos_6 = {10, 450};
 	addButton(&(screen_buttons[7]), pos_6, 180, 50, colour_2, body_font, "Save image");
 
+	//save format button, its lable is set from the format when it is drawn
+	coordinate pos_8 = {10, 505};
+	addButton(&(screen_buttons[9]), pos_8, 180, 40, colour_1, body_font, "Format");
+
 	//save sequence button
 	coordinate pos_7 = {10, 550};
 	addButton(&(screen_buttons[8]), pos_7, 180, 50, colour_2, body_font, "Save sequence");
 }
 
-void drawHomeScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font){
+void drawHomeScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, ui_layers *layers){
 	/**
 	 * \brief Draws the home sceen to the renderer.
 	 * 
 	 * draws the background colour to the renderer, then all the buttons defined in the btn array
-	 * and then some title text.
+	 * and then some title text. Nothing on the home screen changes, so it is all drawn once into
+	 * its static layer, which is copied to the renderer every frame after that.
 	 *
 	 * \param[out] renderer			renderer for screen to be drawn to.
 	 * \param[in] screen_buttons 	buttons to be drawn to the screen.
 	 * \param[in] title_font 		font for the title text
 	 * \param[in] body_font 		font for the body text.
+	 * \param[out] layers 			static layers of the screens.
 	 */
 
-	//drawing background colours
-	drawBG(renderer);
-	
-	//drawing buttons over background
-	drawAllButtonsToRenderer(renderer, screen_buttons, 3);
-	
-	//writing title
-	drawTextToRenderer(renderer, 600, 300, "WELCOM TO THE L-SYSTEM DRAWING PROGRAM", title_font, 0);
+	if (startLayer(renderer, layers, LAYER_HOME)){
+		//drawing background colours
+		drawBG(renderer);
+		
+		//drawing buttons over background
+		drawAllButtonsToRenderer(renderer, screen_buttons, 3);
+		
+		//writing title
+		drawTextToRenderer(renderer, 600, 300, "WELCOM TO THE L-SYSTEM DRAWING PROGRAM", title_font, 0);
+		finishLayer(renderer, layers, LAYER_HOME);
+	}
+	drawLayer(renderer, layers, LAYER_HOME);
 }
 
-void drawOptionsScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys){
+void drawOptionsScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys, ui_layers *layers){
 	/**
 	 * \brief Draws the options screen to the renderer.
 	 *
 	 * Sraws the background, then some title text, then colour charts for picking drawing colours, then 
 	 * the buttons defined in the btn array and finally some text to indicate the current L-System loaded 
 	 * into the lsystem structre.
+	 *
+	 * Everything but the current colour boxes and the name of the L-System is drawn once into the
+	 * screen's static layer, including the 216 boxes of each colour chart, so each frame only copies
+	 * the layer and draws those over it.
 	 * 
 	 * \param[out] renderer 		renderer for screen to be drawn to.
 	 * \param[in] screen_buttons  	buttons to be drawn to the screen.
 	 * \param[in] title_font 		font to be used for the title text.
 	 * \param[in] body_font 		font to be used for the body text.
 	 * \param[out] lsys 			lsystem container that has drawing information to be changed byt options buttons.
+	 * \param[out] layers 			static layers of the screens.
 	 */
 
-	//drawing background
-	drawBG(renderer);
+	if (startLayer(renderer, layers, LAYER_OPTIONS)){
+		//drawing background
+		drawBG(renderer);
 
-	//drawing instruction text
-	drawTextToRenderer(renderer, 600, 100, "Please Choose a fractal pattern and colour scheme", title_font, 0);
+		//drawing instruction text
+		drawTextToRenderer(renderer, 600, 100, "Please Choose a fractal pattern and colour scheme", title_font, 0);
 
-	//drawing buttons
-	drawAllButtonsToRenderer(renderer, screen_buttons, 11);
+		//drawing buttons
+		drawAllButtonsToRenderer(renderer, screen_buttons, 11);
 
-	//drawing colour charts
-	drawTextToRenderer(renderer, 300, 170, "Background Colour:", body_font, 1);
-	drawColourChartToRenderer(renderer, 300, 200);
-	drawTextToRenderer(renderer, 600, 170, "Line Colour:", body_font, 1);
-	drawColourChartToRenderer(renderer, 600, 200);
+		//drawing colour charts
+		drawTextToRenderer(renderer, 300, 170, "Background Colour:", body_font, 1);
+		drawColourChartToRenderer(renderer, 300, 200);
+		drawTextToRenderer(renderer, 600, 170, "Line Colour:", body_font, 1);
+		drawColourChartToRenderer(renderer, 600, 200);
+
+		//labelling the current colour selection boxes and lsystem
+		drawTextToRenderer(renderer, 950, 170, "Current line colour:", body_font, 1);
+		drawTextToRenderer(renderer, 950, 370, "Current background colour:", body_font, 1);
+		drawTextToRenderer(renderer, 950, 550, "Currently selected L-System:", body_font, 1);
+		finishLayer(renderer, layers, LAYER_OPTIONS);
+	}
+	drawLayer(renderer, layers, LAYER_OPTIONS);
 
 	//drawing current colour selection boxes to the renderer
-	drawTextToRenderer(renderer, 950, 170, "Current line colour:", body_font, 1);
 	drawInputColourBox(renderer, lsys->ln_colour, 950, 200);
-	drawTextToRenderer(renderer, 950, 370, "Current background colour:", body_font, 1);
 	drawInputColourBox(renderer, lsys->bg_colour, 950, 400);
 
 	//writing out currently selected lsystem
-	drawTextToRenderer(renderer, 950, 550, "Currently selected L-System:", body_font, 1);
 	drawTextToRenderer(renderer, 950, 580, lsys->name, body_font, 1);
 }
 
-void drawDrawingScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys){
+void drawDrawingScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys, gen_worker *worker, spec_scheduler *spec, seq_exporter *exporter, coverage_mask *coverage, ui_layers *layers, scrub_state *scrub, stage_timings *timings){
 	/**
 	 * \brief Sraws the drawing screen to the renderer.
 	 *
@@ -226,60 +281,136 @@ void drawDrawingScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *ti
 	 * the speed up and minimize the number of calultions being done by the computer flags are set to tell
 	 * the program when the string and line list need to be recalulated and when it can just redraw the 
 	 * last ones that is used (which are stored in the lsystem stucture).
+	 *
+	 * The string and line list are remade on the worker thread so that the window keeps responding
+	 * while large fractals are made. Until the new ones are ready, the last fractal is drawn with a
+	 * progress bar over it. Before a job is handed over, the cache filled by the speculative scheduler
+	 * is checked, and every new fractal shown tells the scheduler what to make next. A sequence being
+	 * saved in the background has its own progress bar.
+	 *
+	 * The fractal is drawn through a coverage mask, so its lines are only drawn again when the
+	 * line list or view changes, and new colours only recolour the pixels. The background, the
+	 * buttons whose lables never change and the instructions are drawn once into the screen's
+	 * static layer.
+	 *
+	 * While the angle or line length is being dragged, the line list is remade here once a frame
+	 * by applyScrub(), from the string already held.
+	 *
+	 * How long the string and line list took to make, by the worker thread, the cache or a drag,
+	 * is noted here for the timings the info overlay can show.
 	 * 
 	 * \param[out] renderer  		renderer for the screen to be drawn to.
 	 * \param[in] screen_buttons  	buttons to be drawn to the screen.
 	 * \param[in] title_font 		font to be used for the title text.
 	 * \param[in] body_font 		font to be used for the body text.
 	 * \param[out] lsys 			lsystem that contains information to be drawn to the screen.
+	 * \param[out] worker 			worker thread that remakes the string and line list.
+	 * \param[out] spec 			speculative scheduler and the cache it fills.
+	 * \param[in] exporter 		sequence exporter, checked for progress.
+	 * \param[out] coverage 		coverage mask the fractal is drawn through.
+	 * \param[out] layers 			static layers of the screens.
+	 * \param[out] scrub 			drag of the angle or line length.
+	 * \param[out] timings 		time each stage last took, shown in the info overlay.
 	 */
 
 	SDL_Rect bg = {200, 0, 1000, 1000};
-
-	//drawing background
-	drawBG(renderer);
-
-	//drawing buttons
-	drawAllButtonsToRenderer(renderer, screen_buttons, 9);
-
-	//writing button lables and instructions
-	drawTextToRenderer(renderer, 100, 80, "Line length:", body_font, 0);
-	drawTextToRenderer(renderer, 100, 180, "Fractal Depth:", body_font, 0);
-	drawTextToRenderer(renderer, 100, 290, "Click in window to redraw", body_font, 0);
-	drawTextToRenderer(renderer, 100, 310, "fractal from new position", body_font, 0);
-	drawTextToRenderer(renderer, 100, 620, "WARNING!", body_font, 0);
-	drawTextToRenderer(renderer, 10, 650, "save sequence will save", body_font, 1);
-	drawTextToRenderer(renderer, 10, 670, "up to 201 .bmp images", body_font, 1);
-	drawTextToRenderer(renderer, 10, 690, "showing the full creation", body_font, 1);
-	drawTextToRenderer(renderer, 10, 710, "of the fractal but it can", body_font, 1);
-	drawTextToRenderer(renderer, 10, 730, "be slow. Do not move", body_font, 1);
-	drawTextToRenderer(renderer, 10, 750, "window while saving.", body_font, 1);
-	drawTextToRenderer(renderer, 10, 770, "Progress shown in the", body_font, 1);
-	drawTextToRenderer(renderer, 10, 790, "terminal.", body_font, 1);
-	
-	//checking flags and drawing lsystem window
-	if (lsys->remake_string_flag){
-		makeString(lsys);
-		lsys->remake_string_flag = 0;
+	int version = 0;
+	Uint64 start_time = 0;
+
+	if (startLayer(renderer, layers, LAYER_DRAWING)){
+		//drawing background
+		drawBG(renderer);
+
+		//drawing the buttons with fixed lables
+		drawAllButtonsToRenderer(renderer, screen_buttons, 6);
+		drawAllButtonsToRenderer(renderer, screen_buttons + 7, 2);
+
+		//writing button lables and instructions
+		drawTextToRenderer(renderer, 100, 80, "Line length:", body_font, 0);
+		drawTextToRenderer(renderer, 100, 180, "Fractal Depth:", body_font, 0);
+		drawTextToRenderer(renderer, 100, 290, "Click in window to redraw", body_font, 0);
+		drawTextToRenderer(renderer, 100, 310, "fractal from new position", body_font, 0);
+		drawTextToRenderer(renderer, 100, 620, "WARNING!", body_font, 0);
+		drawTextToRenderer(renderer, 10, 650, "save sequence will save", body_font, 1);
+		drawTextToRenderer(renderer, 10, 670, "up to 201 images", body_font, 1);
+		drawTextToRenderer(renderer, 10, 690, "showing the full creation", body_font, 1);
+		drawTextToRenderer(renderer, 10, 710, "of the fractal. They are", body_font, 1);
+		drawTextToRenderer(renderer, 10, 730, "saved in the background,", body_font, 1);
+		drawTextToRenderer(renderer, 10, 750, "with progress shown", body_font, 1);
+		drawTextToRenderer(renderer, 10, 770, "under the fractal.", body_font, 1);
+		finishLayer(renderer, layers, LAYER_DRAWING);
 	}
+	drawLayer(renderer, layers, LAYER_DRAWING);
+
+	//drawing the buttons whose lables show the current settings
+	sprintf(screen_buttons[9].text, "Format: %s", imageFormatName(lsys->save_format));
+	strcpy(screen_buttons[10].text, lsys->density_flag ? "View: Density" : "View: Lines");
+	strcpy(screen_buttons[11].text, lsys->antialias_flag ? "Lines: Smooth" : "Lines: Sharp");
+	sprintf(screen_buttons[12].text, "< Angle: %.1f >", rtod(lsys->angle));
+	sprintf(screen_buttons[13].text, "< Length: %d >", lsys->length);
+	strcpy(screen_buttons[6].text, lsys->info_disp_flag == INFO_TIMINGS ? "Info: Timings" : (lsys->info_disp_flag ? "Info: Shown" : "Info: Hidden"));
+	drawAllButtonsToRenderer(renderer, screen_buttons + 9, 5);
+	drawAllButtonsToRenderer(renderer, screen_buttons + 6, 1);
 	
-	if (lsys->remake_lines_flag){
-		lsys->line_list_length = stringToTurtle(lsys);
+	//swapping in anything the worker thread has finished and looking ahead from it
+	if (collectResult(worker, spec->cache, lsys)){
+		timings->rewrite_time = worker->rewrite_time;
+		timings->turtle_time = worker->turtle_time;
+		timings->string_counted = 0;
+		speculate(spec, lsys);
+	}
+
+	//checking flags and taking the lsystem from the cache, or handing it to the worker thread to be remade
+	if (lsys->remake_string_flag || lsys->remake_lines_flag){
+		if (cacheLookup(spec->cache, lsys, lsys->remake_string_flag || worker->string_outstanding || lsys->string == NULL)){
+			cancelJobs(worker);
+			speculate(spec, lsys);
+			timings->rewrite_time = STAGE_CACHED;
+			timings->turtle_time = STAGE_CACHED;
+			timings->string_counted = 0;
+		}
+		else
+			submitJob(worker, lsys);
+		lsys->remake_string_flag = 0;
 		lsys->remake_lines_flag = 0;
 	}
+
+	//remaking the line list for the angle or line length being dragged, from the string already held
+	version = lsys->geometry_version;
+	start_time = SDL_GetPerformanceCounter();
+	applyScrub(scrub, lsys, worker, SCRUB_BUDGET);
+	if (lsys->geometry_version != version){
+		timings->rewrite_time = STAGE_SKIPPED;
+		timings->turtle_time = millisecondsSince(start_time);
+	}
 	
 	//drawing background
     SDL_SetRenderDrawColor(renderer, lsys->bg_colour.r, lsys->bg_colour.g, lsys->bg_colour.b, lsys->bg_colour.a);
     SDL_RenderFillRect(renderer, &bg);
 
-    //drawing fractal
-    drawFractal(renderer, lsys->line_list_length, lsys->line_list, lsys->ln_colour);
+    //drawing fractal, or how many lines pass through each pixel of it
+    drawCoverageToRenderer(renderer, coverage, lsys, COVERAGE_BUDGET);
 
     //drawing info
     if (lsys->info_disp_flag){
         drawInfoToRenderer(renderer, 220, 20, *lsys, title_font, body_font);
     }
 
+    //drawing the stage timings and memory held in the other corner
+    if (lsys->info_disp_flag == INFO_TIMINGS){
+        drawTimingsToRenderer(renderer, 1180, 20, lsys, coverage, timings, body_font);
+    }
+
+    //showing progress while the worker thread is making the next fractal
+    if (workerBusy(worker)){
+        drawProgressToRenderer(renderer, 500, 760, workerProgress(worker), "Generating...", body_font);
+    }
+
+    //showing progress while a sequence is being saved
+    if (exportBusy(exporter)){
+        drawProgressToRenderer(renderer, 500, 730, exportProgress(exporter), "Saving sequence...", body_font);
+    }
+
     //setting a boarder on the draw screen
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderDrawRect(renderer, &bg);
@@ -317,7 +448,7 @@ int homeScreenClick(SDL_Event event, btn *button_list, int win_flag){
     return win_flag;
 }
 
-int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys){
+int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, spec_scheduler *spec){
     /**
      * \brief Handles what happens when a button is clicked by checking the position against
      * buttons on the current screen (which is indicated by the win_flag).
@@ -331,6 +462,7 @@ int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list
 	 * \param[in] button_list 	an array of the buttons that are on the screen.
 	 * \param[in] win_flag 		the old window flag.
 	 * \param[in] lsys 			container for information about the lsystem, which will be edited depending on the options chosen.
+	 * \param[out] spec 		speculative scheduler, told which rule sets are picked most.
 	 *
      * \return          		the new win_flag that will indicate what the new window should be (default is the same value that came in).
     */
@@ -346,48 +478,56 @@ int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list
     //click on sierpinski triangle button
     if (clickInButton(event, button_list[2])){
     	sierpinski(lsys);
+    	notePresetUse(spec, 0);
         return 2;
     }
 
     //click on dragon curve button
     if (clickInButton(event, button_list[3])){
     	dragon(lsys);
+    	notePresetUse(spec, 1);
         return 2;
     }
 
     //click on fractal plant 1 button
     if (clickInButton(event, button_list[4])){
         plant1(lsys);
+        notePresetUse(spec, 2);
         return 2;
     }
 
     //click on fractal plant 2 button
     if (clickInButton(event, button_list[5])){
         plant2(lsys);
+        notePresetUse(spec, 3);
         return 2;
     }
 
     //click on islands button
     if (clickInButton(event, button_list[6])){
         islands(lsys);
+        notePresetUse(spec, 4);
         return 2;
     }
 
     //click on koch snowflake button
     if (clickInButton(event, button_list[7])){
         snowflake(lsys);
+        notePresetUse(spec, 5);
         return 2;
     }
 
     //click on quadratic koch island button
     if (clickInButton(event, button_list[8])){
         quadKoch(lsys);
+        notePresetUse(spec, 6);
         return 2;
     }
 
     //click on koch variation 2 button
     if (clickInButton(event, button_list[9])){
         gosper(lsys);
+        notePresetUse(spec, 7);
         return 2;
     }
 
@@ -396,13 +536,13 @@ int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list
 
         //if click in Background colour picker
         if (event.button.x > 300 && event.button.x < 540){
-        	lsys->bg_colour = getPixelColour(renderer, 1200, 800, event.button.x, event.button.y);
+        	lsys->bg_colour = chartColour(300, 200, event.button.x, event.button.y);
             return win_flag;
         }
 
         //if click in line colour picker
         if (event.button.x > 600 && event.button.x < 840){
-        	lsys->ln_colour  = getPixelColour(renderer, 1200, 800, event.button.x, event.button.y);
+        	lsys->ln_colour = chartColour(600, 200, event.button.x, event.button.y);
             return win_flag;
         }
     }
@@ -416,7 +556,7 @@ int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list
     return win_flag;
 }
 
-int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font){
+int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font, gen_worker *worker, seq_exporter *exporter, coverage_mask *coverage, scrub_state *scrub){
 	/**
      * \brief Handles what happens when a button is clicked by checking the position against
      * buttons on the current screen (which is indicated by the win_flag).
@@ -433,30 +573,43 @@ int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, i
 	 * \param[out] lsys 		container for information about the lsystem, which will be edited depending on the options chosen.
 	 * \param[in] tile_font 	large font used in the save sequence button.
 	 * \param[in] body_font 	small font used in the save sequence button.
+	 * \param[out] worker 		worker thread, cancelled when the drawing screen is left.
+	 * \param[out] exporter 	sequence exporter for the save sequence button.
+	 * \param[out] coverage 	coverage mask the fractal is drawn through, for the save image button.
+	 * \param[out] scrub 		drag of the angle or line length, started by their drag controls.
 	 * 
      * \return         			the new win_flag that will indicate what the new window should be (default is the same value that came in).
      */
 
+    //the line list is kept when leaving, so coming back with only the colours changed places
+    //the same lines and the coverage mask does not need drawing again
+
     //click on home button
     if (clickInButton(event, button_list[0])){
-		resetLines(lsys);
+		cancelJobs(worker);
+		freeScrub(scrub);
+		lsys->remake_lines_flag = 1;
 		resetString(lsys);
     	return 1;
 	}
 
     //click on back button
     if (clickInButton(event, button_list[1])){
-		resetLines(lsys);
+		cancelJobs(worker);
+		freeScrub(scrub);
+		lsys->remake_lines_flag = 1;
 		resetString(lsys);
     	return win_flag-1;
 	}
 
+	//changes only set flags, the old fractal is kept on screen until the worker thread replaces it
+
     //line length decrease
     if (clickInButton(event, button_list[2])){
 		//making sure line length is greater than 1
     	if (lsys->length > 1){
     		lsys->length -= 1;
-			resetLines(lsys);
+			lsys->remake_lines_flag = 1;
 			return win_flag;
 		}
     }
@@ -466,7 +619,7 @@ int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, i
 		//setting a limit on the line length
 		if (lsys->length < 20){
 			lsys->length += 1;
-			resetLines(lsys);
+			lsys->remake_lines_flag = 1;
 			return win_flag;
 		}
     }
@@ -475,8 +628,8 @@ int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, i
     if (clickInButton(event, button_list[4])){
         if (lsys->iterations > 1){
     	    lsys->iterations -= 1;
-			resetLines(lsys);
-			resetString(lsys);
+			lsys->remake_lines_flag = 1;
+			lsys->remake_string_flag = 1;
 			return win_flag;
 		}
     }
@@ -485,35 +638,56 @@ int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, i
     if (clickInButton(event, button_list[5])){
         if (lsys->iterations < lsys->iteration_limit){
     	    lsys->iterations += 1;
-			resetLines(lsys);
-			resetString(lsys);
+			lsys->remake_lines_flag = 1;
+			lsys->remake_string_flag = 1;
 			return win_flag;
 		}
     }
 
-    //show/hide info button
+    //angle and line length drag controls, the values change as the mouse moves until it is let go
+    if (clickInButton(event, button_list[12])){
+		startScrub(scrub, lsys, worker, SCRUB_ANGLE);
+		return win_flag;
+    }
+
+    if (clickInButton(event, button_list[13])){
+		startScrub(scrub, lsys, worker, SCRUB_LENGTH);
+		return win_flag;
+    }
+
+    //info button, cycles from hidden to shown to shown with timings
     if (clickInButton(event, button_list[6])){
-    	if (lsys->info_disp_flag)
-    		lsys->info_disp_flag = 0;
-    	else
-    		lsys->info_disp_flag = 1;
+    	lsys->info_disp_flag = (lsys->info_disp_flag + 1) % (INFO_TIMINGS + 1);
     }
 
     //save img button
     if (clickInButton(event, button_list[7])){
     	printf("img saved\n");
-    	imgSave(renderer, lsys);
+    	imgSave(renderer, lsys, coverage, title_font, body_font);
     }
 
     //save seq button
     if (clickInButton(event, button_list[8])){
-    	printf("img sequence saved\n");
-    	sequenceSave(renderer, lsys, title_font, body_font);
+    	sequenceSave(renderer, lsys, title_font, body_font, exporter);
+    }
+
+    //line/density view button
+    if (clickInButton(event, button_list[10])){
+    	lsys->density_flag = !lsys->density_flag;
+    }
+
+    //sharp/smooth lines button
+    if (clickInButton(event, button_list[11])){
+    	lsys->antialias_flag = !lsys->antialias_flag;
+    }
+
+    //save format button, cycles through the formats
+    if (clickInButton(event, button_list[9])){
+    	lsys->save_format = (lsys->save_format + 1) % IMAGE_FORMATS;
     }
 
     //move fractal
     if (event.button.x > 200){
-		free(lsys->line_list);
     	lsys->start.x_pos = event.button.x;
     	lsys->start.y_pos = event.button.y;
     	lsys->remake_lines_flag  = 1;
@@ -592,6 +766,9 @@ void drawTextToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, char *text
      * can then be copied to a renderer inside a rectangle that is the same size as the texture. This 
      * function wraps this proces up and also allows a flag to be set for text allignment to make positioning
      * easier for the user.
+     *
+     * If the window has a text cache attached, the texture is taken from it, so text that is drawn on
+     * every frame is only rendered the first time.
 	 *
      * \param[out] renderer     pointer to the renderer that will hold the output.
      * \param[in] x_pos         x position for the text on the renderer.
@@ -608,11 +785,17 @@ void drawTextToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, char *text
     SDL_Surface *text_surface = NULL;
     SDL_Texture *text_texture = NULL;
     SDL_Colour text_colour = {0, 0, 0, 255};
-
-    //Writing the text to  a surface, then copying that surface to the renderer
-    text_surface = TTF_RenderText_Solid(font, text, text_colour);
-    text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
-    SDL_QueryTexture(text_texture, NULL, NULL, &text_w, &text_h);
+    text_cache *cache = rendererTextCache(renderer);
+
+    //Taking the text from the cache, or writing the text to a surface and copying that surface to a texture
+    if (cache != NULL)
+        text_texture = cachedText(cache, renderer, font, text, text_colour, &text_w, &text_h);
+    if (text_texture == NULL){
+        cache = NULL;
+        text_surface = TTF_RenderText_Solid(font, text, text_colour);
+        text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
+        SDL_QueryTexture(text_texture, NULL, NULL, &text_w, &text_h);
+    }
 
     //Setting the drawing position acording to allignment flag
     y_pos -= text_h/2;
@@ -625,9 +808,11 @@ void drawTextToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, char *text
     SDL_Rect dest_rect = {x_pos, y_pos, text_w, text_h}; 
     SDL_RenderCopy(renderer, text_texture, NULL, &dest_rect); 
   
-  	//freeing helper structures
-    SDL_FreeSurface(text_surface);
-    SDL_DestroyTexture(text_texture);
+  	//freeing helper structures, unless the texture belongs to the cache
+    if (cache == NULL){
+        SDL_FreeSurface(text_surface);
+        SDL_DestroyTexture(text_texture);
+    }
 }
 
 void drawButtonToRenderer(SDL_Renderer *renderer, btn ui_button){
@@ -689,17 +874,17 @@ void drawColourChartToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos){
     int r = 0, g = 0, b = 0;
     int x = x_pos;
     int y = y_pos;
-    int box_width = 40;
-    int box_height = 13;
+    int box_width = CHART_BOX_WIDTH;
+    int box_height = CHART_BOX_HEIGHT;
     SDL_Rect box = {x, y, box_width, box_height};
     int i = 1;
     
     //iterating through 6 values of red
-    for (r = 0; r <= 255; r += 51){
+    for (r = 0; r <= 255; r += CHART_STEP){
     	//for each red value 6 green values are used
-        for (g = 0; g <= 255; g += 51){
+        for (g = 0; g <= 255; g += CHART_STEP){
         	//for each green value 6 values of blue are used
-            for (b = 0; b <= 255; b += 51, i++){
+            for (b = 0; b <= 255; b += CHART_STEP, i++){
                 SDL_SetRenderDrawColor(renderer, r, g, b, 255);
                 SDL_RenderFillRect(renderer, &box);
 
@@ -716,6 +901,39 @@ void drawColourChartToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos){
     }
 }
 
+SDL_Colour chartColour(int x_pos, int y_pos, int point_x, int point_y){
+    /**
+     * \brief Returns the colour of the box of a colour chart under a point.
+     *
+     * The colour is worked out from the position of the box in the same order the boxes are
+     * drawn by drawColourChartToRenderer(), so nothing is read back from the renderer. A point
+     * outside the chart is given the nearest box.
+     *
+     * \param[in] x_pos         x position of the top left-hand corner of the chart.
+     * \param[in] y_pos         y position of the top left-hand corner of the chart.
+     * \param[in] point_x       x coordinate of the point, such as a click.
+     * \param[in] point_y       y coordinate of the point.
+     *
+     * \return                  the colour of the box.
+     */
+
+    SDL_Colour colour = {0, 0, 0, 255};
+    int column = (point_x - x_pos)/CHART_BOX_WIDTH;
+    int row = (point_y - y_pos)/CHART_BOX_HEIGHT;
+    int box = 0;
+
+    //keeping the point to the 6 columns and 36 rows of boxes
+    column = column < 0 ? 0 : (column > 5 ? 5 : column);
+    row = row < 0 ? 0 : (row > 35 ? 35 : row);
+    box = 6*row + column;
+
+    //blue changes every box, green every 6 boxes and red every 36
+    colour.r = CHART_STEP*(box/36);
+    colour.g = CHART_STEP*(box/6 % 6);
+    colour.b = CHART_STEP*(box % 6);
+    return colour;
+}
+
 void drawInputColourBox(SDL_Renderer *renderer, SDL_Colour colour, int x_pos, int y_pos){
     /**
      * \brief A function for drawing a coloured box to the screen. 
@@ -840,6 +1058,65 @@ void drawInfoToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, lsystem ls
     }
 }
 
+void drawTimingsToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, lsystem *lsys, coverage_mask *coverage, stage_timings *timings, TTF_Font *body_font){
+    /**
+     * \brief Draws the time each stage of making and showing the fractal last took, and the memory its string and line list hold.
+     *
+     * The rewrite and turtle times are from whichever of the worker thread, the geometry cache or
+     * a drag made the fractal shown, the raster time adds up every slice drawn into the coverage
+     * mask so far, and the present and frame times are from the last frame presented. The string
+     * is only counted once each time it is replaced. The lines are right alligned to x_pos.
+     *
+     * \param[out] renderer      renderer for the timings to be drawn to.
+     * \param[in] x_pos          x coordinate of the right hand side of the timings.
+     * \param[in] y_pos          y coordinate of the top of the timings.
+     * \param[in] lsys           lsystem holding the string and line list.
+     * \param[in] coverage       coverage mask the fractal is drawn through.
+     * \param[out] timings       time each stage last took, given the string length if it has not been counted.
+     * \param[in] body_font      small font.
+     */
+
+    char text[TEXT_CACHE_LENGTH];
+    int length = lsys->line_list == NULL ? 0 : lsys->line_list_length;
+
+    //counting the string once for each new string
+    if (!timings->string_counted){
+        timings->string_length = lsys->string == NULL ? 0 : strlen(lsys->string);
+        timings->string_counted = 1;
+    }
+
+    stageText(text, "rewrite", timings->rewrite_time);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    y_pos += 20;
+    stageText(text, "turtle", timings->turtle_time);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    y_pos += 20;
+    if (coverageDone(coverage, lsys))
+        sprintf(text, "raster: %.1f ms", coverage->raster_time);
+    else
+        sprintf(text, "raster: %.1f ms, %d%% drawn", coverage->raster_time, length > 0 ? (int)(100.0*coverage->drawn/length) : 0);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    y_pos += 20;
+    sprintf(text, "present: %.1f ms", timings->present_time);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    y_pos += 20;
+    sprintf(text, "frame: %.1f ms", timings->frame_time);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    //memory held by the string and line list
+    y_pos += 30;
+    sprintf(text, "string: %lu chars, %.2f MB", (unsigned long)timings->string_length, (timings->string_length + (lsys->string != NULL))/1048576.0);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+
+    y_pos += 20;
+    sprintf(text, "line list: %d lines, %.2f MB", length, (double)length*sizeof(line)/1048576.0);
+    drawTextToRenderer(renderer, x_pos, y_pos, text, body_font, 2);
+}
+
 void drawLine(SDL_Renderer *renderer, coordinate start, coordinate end, int x_max, int x_min, int y_max, int y_min){
     /**
      * \brief A line drawing function that implements the bresenheim line drawing
@@ -928,6 +1205,76 @@ void drawFractal(SDL_Renderer *renderer, int length, line *line_list, SDL_Colour
     }
 }
 
+void drawCoverageToRenderer(SDL_Renderer *renderer, coverage_mask *mask, lsystem *lsys, double budget){
+    /**
+     * \brief Draws the fractal, or how many lines pass through each pixel of it, through a coverage mask.
+     *
+     * The mask covers the drawing area and is made the first time it is drawn. Its levels are
+     * only redrawn when the lsystem's line list or density flag has changed, and its pixels are
+     * only recoloured and copied to its texture when the levels or colours have changed, so an
+     * unchanged fractal is a single texture copy. A large fractal is drawn over several frames,
+     * budget milliseconds of lines at a time, until coverageDone() is true.
+     *
+     * \param[out] renderer  	renderer to be drawn to.
+     * \param[out] mask         coverage mask the fractal is drawn through.
+     * \param[in] lsys          lsystem holding the line list, colours and density flag.
+     * \param[in] budget        milliseconds of lines to draw, or 0 to draw every line left.
+     */
+
+    //initialising variables
+    SDL_Rect area = {200, 0, 1000, 800};
+    coordinate offset = {-200, 0};
+
+    if (mask->levels == NULL && !initCoverage(mask, area.w, area.h))
+        return;
+
+    //redrawing the levels and colours only when they are out of date
+    updateCoverage(mask, lsys, 1, offset, budget);
+    if (mask->texture == NULL){
+        mask->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, area.w, area.h);
+        mask->composited = 0;
+    }
+    if (compositeCoverage(mask, lsys->bg_colour, lsys->ln_colour) && mask->texture != NULL)
+        SDL_UpdateTexture(mask->texture, NULL, mask->image.pixels, mask->image.width*sizeof(Uint32));
+
+    //copying the coloured mask to the renderer
+    if (mask->texture != NULL)
+        SDL_RenderCopy(renderer, mask->texture, NULL, &area);
+}
+
+void drawProgressToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, int percent, char *label, TTF_Font *font){
+    /**
+     * \brief Draws a progress bar with a label to the renderer.
+     *
+     * Used on the drawing screen while the worker thread is making the next fractal and while a
+     * sequence is being saved.
+     *
+     * \param[out] renderer     renderer for the progress bar to be drawn to.
+     * \param[in] x_pos         x position of the top left corner of the bar.
+     * \param[in] y_pos         y position of the top left corner of the bar.
+     * \param[in] percent       progress from 0 to 100.
+     * \param[in] label         text written in front of the percentage.
+     * \param[in] font          font for the label.
+     */
+
+    //initialising variables
+    char text[40];
+    SDL_Rect bar = {x_pos, y_pos, 400, 20};
+    SDL_Rect fill = {x_pos, y_pos, 4*percent, 20};
+
+    //drawing the bar, the filled part and a boarder
+    SDL_SetRenderDrawColor(renderer, 197, 202, 235, 255);
+    SDL_RenderFillRect(renderer, &bar);
+    SDL_SetRenderDrawColor(renderer, 255, 64, 129, 255);
+    SDL_RenderFillRect(renderer, &fill);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &bar);
+
+    //writing the label over the bar
+    sprintf(text, "%s %d%%", label, percent);
+    drawTextToRenderer(renderer, x_pos + 200, y_pos + 10, text, font, 0);
+}
+
 void printRule(SDL_Renderer *renderer, int x_pos, int y_pos, char *original, char *replacement, TTF_Font *font){
     /**
      * \brief Formats and writes out the rule for the input character.
@@ -1059,91 +1406,226 @@ void drawBG(SDL_Renderer *renderer){
     SDL_RenderFillRect(renderer, &menu_bar);
 }
 
-void imgSave(SDL_Renderer *renderer, lsystem *lsys){
+int startLayer(SDL_Renderer *renderer, ui_layers *layers, int layer){
+    /**
+     * \brief Starts drawing a screen's static layer, returning false if it is already drawn.
+     *
+     * When the layer needs drawing, its texture is made the render target, so what is drawn until
+     * finishLayer() goes into the layer. If the texture cannot be made the render target is left
+     * as the window, and the static layer is drawn straight to it every frame as it used to be.
+     *
+     * \param[out] renderer     renderer the layer belongs to.
+     * \param[out] layers       the static layers.
+     * \param[in] layer         one of the LAYER_ values.
+     *
+     * \return                  true if the static layer should be drawn now, false if it is already drawn.
+     */
+
+    //initialising variables
+    int width = 0;
+    int height = 0;
+
+    if (layers->valid[layer])
+        return 0;
+
+    //making the texture the size of the window the first time the layer is drawn
+    if (layers->textures[layer] == NULL && SDL_GetRendererOutputSize(renderer, &width, &height) == 0)
+        layers->textures[layer] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+    if (layers->textures[layer] != NULL && SDL_SetRenderTarget(renderer, layers->textures[layer]) != 0){
+        SDL_DestroyTexture(layers->textures[layer]);
+        layers->textures[layer] = NULL;
+    }
+
+    layers->redraws++;
+    return 1;
+}
+
+void finishLayer(SDL_Renderer *renderer, ui_layers *layers, int layer){
+    /**
+     * \brief Finishes drawing a screen's static layer and sets the render target back to the window.
+     *
+     * \param[out] renderer     renderer the layer belongs to.
+     * \param[out] layers       the static layers.
+     * \param[in] layer         one of the LAYER_ values.
+     */
+
+    if (layers->textures[layer] == NULL)
+        return;
+
+    SDL_SetRenderTarget(renderer, NULL);
+    layers->valid[layer] = 1;
+}
+
+void drawLayer(SDL_Renderer *renderer, ui_layers *layers, int layer){
+    /**
+     * \brief Copies a screen's static layer to the window, over everything.
+     *
+     * Does nothing if the layer could not be drawn into a texture, as it has then been drawn
+     * straight to the window.
+     *
+     * \param[out] renderer     renderer for the layer to be copied to.
+     * \param[in] layers        the static layers.
+     * \param[in] layer         one of the LAYER_ values.
+     */
+
+    if (layers->valid[layer])
+        SDL_RenderCopy(renderer, layers->textures[layer], NULL, NULL);
+}
+
+void invalidateLayers(ui_layers *layers){
+    /**
+     * \brief Marks every static layer to be drawn again, for when the renderer has lost its textures.
+     *
+     * \param[out] layers       the static layers.
+     */
+
+    int i = 0;
+
+    for (i = 0; i < UI_LAYERS; i++)
+        layers->valid[i] = 0;
+}
+
+void freeLayers(ui_layers *layers){
+    /**
+     * \brief Destroys the textures of the static layers.
+     *
+     * \param[out] layers       the static layers, left empty.
+     */
+
+    int i = 0;
+
+    for (i = 0; i < UI_LAYERS; i++)
+        if (layers->textures[i] != NULL)
+            SDL_DestroyTexture(layers->textures[i]);
+
+    structInitUiLayers(layers);
+}
+
+void imgSave(SDL_Renderer *renderer, lsystem *lsys, coverage_mask *coverage, TTF_Font *title_font, TTF_Font *body_font){
 	/**
-	 * \brief Saves the fractal image as a single bmp image.
+	 * \brief Saves the fractal image as a single image in the chosen save format.
 	 *
-	 * Copies the drawing region of the renderer to a surface to be saved by the
-	 * SDL_SaveBMP() function.
+	 * The drawing region is drawn again, with the info if it is shown, and copied from the
+	 * renderer to an image to be saved by the saveImage() function. It is drawn here rather than
+	 * read from the last frame, as the renderer's contents are not kept once a frame has been
+	 * presented. Any lines the coverage mask has not drawn yet are drawn first, so a fractal still
+	 * being drawn over several frames is saved whole. An svg is written from the line list instead, fitted to the size of the drawing
+	 * region so that none of the fractal is cut off.
 	 * 
-	 * \param[in] renderer 		renderer that contains onformation to be copied
-	 * \param[in] lsys 			the structure that contains the information for naming
+	 * \param[out] renderer 	renderer the drawing region is drawn to and copied from.
+	 * \param[in] lsys 			the structure that contains the information for naming and the save format
+	 * \param[out] coverage 	coverage mask the fractal is drawn through.
+	 * \param[in] title_font 	font for the title text of the info.
+	 * \param[in] body_font 	font for the body text of the info.
 	 */
 
 	//initialising variables
 	char name[100];
 	time_t current_time = time(NULL);
 	char *base_time = ctime(&current_time);
-	SDL_Surface *out = SDL_CreateRGBSurface(0, 1000, 800, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+	raster_image out;
 	SDL_Rect area = {200, 0, 1000, 800};
+	double scale = 1;
+	coordinate offset;
+	Uint64 trace_begin = 0;
 
 	//creating name for the save file
-	sprintf(name, "saves/%s_%s.bmp", lsys->name, base_time);
-
-	//copy renderer to surface
-	SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, out->pixels, out->pitch);
+	sprintf(name, "saves/%s_%s.%s", lsys->name, base_time, imageExtension(lsys->save_format));
+
+	//writing the whole line list as an svg
+	structInitCoord(&offset);
+	if (lsys->save_format == IMAGE_SVG){
+		if (lsys->line_list == NULL)
+			return;
+		trace_begin = traceBegin(lsys->trace);
+		fitLines(lsys->line_list, lsys->line_list_length, area.w, area.h, 10, &scale, &offset);
+		saveSVG(lsys->line_list, lsys->line_list_length, scale, offset, area.w, area.h, lsys->bg_colour, lsys->ln_colour, SVG_DEFAULT_PRECISION, name);
+		traceEnd(lsys->trace, "saveSVG", trace_begin);
+		return;
+	}
 
-	//save surface as .bmp
-	SDL_SaveBMP(out, name);
+	structInitRasterImage(&out);
+	if (!initRaster(&out, area.w, area.h))
+		return;
 
-	//freeing surface
-	SDL_FreeSurface(out);
+	//drawing the region again and copying it to the image
+	SDL_SetRenderDrawColor(renderer, lsys->bg_colour.r, lsys->bg_colour.g, lsys->bg_colour.b, lsys->bg_colour.a);
+	SDL_RenderFillRect(renderer, &area);
+	drawCoverageToRenderer(renderer, coverage, lsys, 0);
+	if (lsys->info_disp_flag)
+		drawInfoToRenderer(renderer, 220, 20, *lsys, title_font, body_font);
+	SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, out.pixels, out.width*sizeof(Uint32));
+
+	//save image in the chosen format
+	trace_begin = traceBegin(lsys->trace);
+	saveImage(&out, name, lsys->save_format);
+	traceEnd(lsys->trace, "saveImage", trace_begin);
+
+	//freeing image
+	freeRaster(&out);
 }
 
-void sequenceSave(SDL_Renderer *renderer, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font){
+void sequenceSave(SDL_Renderer *renderer, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font, seq_exporter *exporter){
 	/**
-	 * \brief Saves the fractal as a sequence of bmp images that show the fractal being drawn line by line.
+	 * \brief Starts saving the fractal as a sequence of images that show the fractal being drawn line by line.
 	 * 
-	 * clears the renderer before iteratively drawing lines to it, then converting to surface and saving.
-	 * The program splits up the lines being drawn so that there is a limit of 100 frames that can be saved.
-	 * this keeps the program running quickly but limits what the user can do with the output. I decided on 
-	 * doing it this way because the save sequence is error porne and slow (moving the window while saving
-	 * off a sequence causes artifacts).
+	 * The background (and the info, if it is shown) is drawn to the renderer and read back once
+	 * as the first frame. From there the lines are drawn and the frames saved by the exporter's
+	 * own threads, away from the window, so the program keeps responding and moving the window
+	 * does not affect the frames. The lines are split up so that there is a limit of 201 frames.
+	 * Only one sequence is saved at a time. Frames are saved as PNG when svg is the chosen format.
 	 * 
-	 * \param[in] window 		window that is being drawn to
-	 * \param[in] renderer 		renderer being drawn to and saved
+	 * \param[in] renderer 		renderer the first frame is drawn to and read from.
 	 * \param[in] lsys 			structure that contians information for drawing img sequence.
 	 * \param[in] title_font 	font for title text
 	 * \param[in] body_font 	font for main body text
+	 * \param[out] exporter 	the exporter that saves the frames.
 	 */
 
 	//initialising variables
-	SDL_Surface *out = SDL_CreateRGBSurface(0, 1000, 800, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-	char name[100];
-	time_t current_time = time(NULL);
-	char *base_time = ctime(&current_time);
-	SDL_Rect bg = {200, 0, 1000, 1000};
-	int i = 0;
+	raster_image base;
+	SDL_Rect area = {200, 0, 1000, 800};
+
+	if (exportBusy(exporter)){
+		printf("a sequence is already being saved\n");
+		return;
+	}
+
+	structInitRasterImage(&base);
+	if (lsys->line_list == NULL || !initRaster(&base, area.w, area.h))
+		return;
 
 	//clearing renderer drawing screen
     SDL_SetRenderDrawColor(renderer, lsys->bg_colour.r, lsys->bg_colour.g, lsys->bg_colour.b, lsys->bg_colour.a);
-    SDL_RenderFillRect(renderer, &bg);
+    SDL_RenderFillRect(renderer, &area);
 
     //drawing info if correct flag is shown
     if (lsys->info_disp_flag){
         drawInfoToRenderer(renderer, 220, 20, *lsys, title_font, body_font);
     }
 
-	//drawing and saving as lines are drawn
-	//the number of lines per frame is dependant on the numbe of lines in the line list
-	//so that there is an upper limit to the number of frames being saved
-	lsys->seq_file_num = 1;
-	SDL_SetRenderDrawColor(renderer, lsys->ln_colour.r, lsys->ln_colour.g, lsys->ln_colour.b, lsys->ln_colour.a);
-	
-	for (i = 0; i < lsys->line_list_length; i++){
-		sprintf(name, "saves/fractal_seq_%s_%03d.bmp", base_time, lsys->seq_file_num);
-		
-		drawLine(renderer, lsys->line_list[i].start, lsys->line_list[i].end, 1200, 200, 800, 0);
+	//reading back the first frame and handing the rest to the exporter
+	SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, base.pixels, base.width*sizeof(Uint32));
+	if (startSequenceExport(exporter, &base, lsys->line_list, lsys->line_list_length, lsys->ln_colour, area.x, lsys->save_format == IMAGE_SVG ? IMAGE_PNG : lsys->save_format, lsys->antialias_flag))
+		printf("img sequence started\n");
+	else
+		freeRaster(&base);
+}
 
-		if (i % (lsys->line_list_length/200+ 1) == 0 || i == lsys->line_list_length-1){
+static void stageText(char *text, char *stage, double time){
+    /**
+     * \brief Writes the time a stage took, or why it did not run, as a line of the timings overlay.
+     *
+     * \param[out] text     string of at least TEXT_CACHE_LENGTH characters to write to.
+     * \param[in] stage     name of the stage.
+     * \param[in] time      milliseconds the stage took, or STAGE_SKIPPED or STAGE_CACHED.
+     */
 
-			SDL_RenderReadPixels(renderer, &bg, SDL_PIXELFORMAT_ARGB8888, out->pixels, out->pitch);
-			SDL_SaveBMP(out, name);
-			printf("%d of up to 201 frames saved.\n", lsys->seq_file_num);
-			lsys->seq_file_num += 1;
-		}
-	}
-	
-	//freeing surface
-	SDL_FreeSurface(out);
+    if (time == STAGE_CACHED)
+        sprintf(text, "%s: from cache", stage);
+    else if (time == STAGE_SKIPPED)
+        sprintf(text, "%s: not needed", stage);
+    else
+        sprintf(text, "%s: %.1f ms", stage, time);
 }
@@ -4,6 +4,27 @@
 #define TITLE_SIZE 30
 #define BODY_SIZE 16
 
+/** \brief Static layer of the home screen.*/
+#define LAYER_HOME 0
+/** \brief Static layer of the options screen.*/
+#define LAYER_OPTIONS 1
+/** \brief Static layer of the drawing screen.*/
+#define LAYER_DRAWING 2
+
+/** \brief Info flag of an lsystem when the info overlay is hidden.*/
+#define INFO_HIDDEN 0
+/** \brief Info flag of an lsystem when the info overlay shows the name, rules and angle.*/
+#define INFO_SHOWN 1
+/** \brief Info flag of an lsystem when the info overlay also shows the time each stage took and the memory held.*/
+#define INFO_TIMINGS 2
+
+/** \brief Width in pixels of each box of a colour chart.*/
+#define CHART_BOX_WIDTH 40
+/** \brief Height in pixels of each box of a colour chart.*/
+#define CHART_BOX_HEIGHT 13
+/** \brief Step between the 6 values of each colour channel in a colour chart.*/
+#define CHART_STEP 51
+
 
 /*************************************
 *       General UI Functions         *
@@ -49,6 +70,11 @@ void drawAllButtonsToRenderer(SDL_Renderer *renderer, btn *screen, int len);
  */
 void drawColourChartToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos);
 
+/*
+ * Returns the colour of the box of a colour chart under a point
+ */
+SDL_Colour chartColour(int x_pos, int y_pos, int point_x, int point_y);
+
 /*
  * Draws a bounded box of the input colour to the specified position on the renderer
  */
@@ -59,6 +85,11 @@ void drawInputColourBox(SDL_Renderer *renderer, SDL_Colour colour, int x_pos, in
  */
 void drawInfoToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, lsystem lsys, TTF_Font *title_font, TTF_Font *body_font);
 
+/*
+ * Draws the time each stage of making and showing the fractal last took, and the memory its string and line list hold
+ */
+void drawTimingsToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, lsystem *lsys, coverage_mask *coverage, stage_timings *timings, TTF_Font *body_font);
+
 /*
  * Draws a line to the renderer
  */
@@ -69,6 +100,16 @@ void drawLine(SDL_Renderer *renderer, coordinate start, coordinate end, int x_ma
  */
 void drawFractal(SDL_Renderer *renderer, int length, line *line_list, SDL_Colour line_colour);
 
+/*
+ * Draws the fractal, or how many lines pass through each pixel of it, through a coverage mask
+ */
+void drawCoverageToRenderer(SDL_Renderer *renderer, coverage_mask *mask, lsystem *lsys, double budget);
+
+/*
+ * Draws a progress bar to the renderer
+ */
+void drawProgressToRenderer(SDL_Renderer *renderer, int x_pos, int y_pos, int percent, char *label, TTF_Font *font);
+
 /*
  * Prints a single rule to the renderer
  */
@@ -89,6 +130,31 @@ SDL_Colour getPixelColour(SDL_Renderer *renderer, int win_width, int win_height,
  */
 void drawBG(SDL_Renderer *renderer);
 
+/*
+ * Starts drawing a screen's static layer, returning false if it is already drawn
+ */
+int startLayer(SDL_Renderer *renderer, ui_layers *layers, int layer);
+
+/*
+ * Finishes drawing a screen's static layer and sets the render target back to the window
+ */
+void finishLayer(SDL_Renderer *renderer, ui_layers *layers, int layer);
+
+/*
+ * Copies a screen's static layer to the window
+ */
+void drawLayer(SDL_Renderer *renderer, ui_layers *layers, int layer);
+
+/*
+ * Marks every static layer to be drawn again
+ */
+void invalidateLayers(ui_layers *layers);
+
+/*
+ * Destroys the textures of the static layers
+ */
+void freeLayers(ui_layers *layers);
+
 
 /*************************************
 *       Specific UI Functions        *
@@ -112,17 +178,17 @@ void createDrawScreenButtons(btn *screen_buttons, TTF_Font *title_font, TTF_Font
 /*
  * Draws the home screen to the renderer
  */
-void drawHomeScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font);
+void drawHomeScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, ui_layers *layers);
 
 /*
  * Draws the options screen to the renderer
  */
-void drawOptionsScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys);
+void drawOptionsScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys, ui_layers *layers);
 
 /*
  * Draws the drawing screen to the renderer
  */
-void drawDrawingScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys);
+void drawDrawingScreen(SDL_Renderer *renderer, btn *screen_buttons, TTF_Font *title_font, TTF_Font *body_font, lsystem *lsys, gen_worker *worker, spec_scheduler *spec, seq_exporter *exporter, coverage_mask *coverage, ui_layers *layers, scrub_state *scrub, stage_timings *timings);
 
 /*
  * Handles a click while the home screen is being displayed
@@ -132,12 +198,12 @@ int homeScreenClick(SDL_Event event, btn *button_list, int win_flag);
 /*
  * Handles a click while the options screen is being displayed
  */
-int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys);
+int optionsScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, spec_scheduler *spec);
 
 /*
  * Handles a click while the draw screen is beign displayed
  */
-int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font);
+int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, int win_flag, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font, gen_worker *worker, seq_exporter *exporter, coverage_mask *coverage, scrub_state *scrub);
 
 
 /*************************************
@@ -145,14 +211,14 @@ int drawScreenClick(SDL_Renderer *renderer, SDL_Event event, btn *button_list, i
 *************************************/
 
 /*
- * Saves the fractal viewing window as .bmp file
+ * Saves the fractal viewing window in the chosen save format
  */
-void imgSave(SDL_Renderer *renderer, lsystem *lsys);
+void imgSave(SDL_Renderer *renderer, lsystem *lsys, coverage_mask *coverage, TTF_Font *title_font, TTF_Font *body_font);
 
 /*
- * Saves the fractal as a sequence of up to 100 bmp files
+ * Starts saving the fractal as a sequence of up to 201 images in the background
  */
-void sequenceSave(SDL_Renderer *renderer, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font);
+void sequenceSave(SDL_Renderer *renderer, lsystem *lsys, TTF_Font *title_font, TTF_Font *body_font, seq_exporter *exporter);
 
 
 #endif
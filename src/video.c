@@ -0,0 +1,158 @@
+/**
+ * \file video.c
+ *
+ * \brief A source file for writing frames to an uncompressed video stream.
+ *
+ * Long sequences are written as a single stream rather than one image file for each
+ * frame, so that they can be piped straight into an external encoder. Two formats are
+ * written. YUV4MPEG2 (.y4m) has a short text header giving the size and frame rate and
+ * is read by most encoders as it is, so colour is kept at full resolution (4:4:4) and
+ * converted with the BT.601 studio range coefficients. Raw RGB has no header at all,
+ * so the reader has to be told the size, and is simply 3 bytes for every pixel.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "video.h"
+
+
+int openVideo(video_stream *video, char *name, int format, int width, int height, int fps){
+	/**
+	 * \brief Opens a video stream, using stdout if the file name is "-".
+	 *
+	 * \param[out] video 	a stream initialised with structInitVideoStream().
+	 * \param[in] name 		file name for the stream, or "-" for stdout.
+	 * \param[in] format 	VIDEO_Y4M or VIDEO_RGB.
+	 * \param[in] width 	width of each frame in pixels.
+	 * \param[in] height 	height of each frame in pixels.
+	 * \param[in] fps 		frame rate, only written by formats with a header.
+	 *
+	 * \return 				1 if sucessfull, 0 if the file could not be opened.
+	 */
+
+	video->buffer = (unsigned char*)malloc((size_t)width*height*3);
+	if (video->buffer == NULL){
+		printf("video frame memory allocation failed\n");
+		return 0;
+	}
+
+	if (strcmp(name, "-") == 0)
+		video->file = stdout;
+	else
+		video->file = fopen(name, "wb");
+	if (video->file == NULL){
+		printf("Could not open video file %s\n", name);
+		free(video->buffer);
+		video->buffer = NULL;
+		return 0;
+	}
+
+	video->format = format;
+	video->width = width;
+	video->height = height;
+	video->frames = 0;
+
+	if (format == VIDEO_Y4M)
+		fprintf(video->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+
+	return 1;
+}
+
+int writeVideoFrame(video_stream *video, raster_image *image){
+	/**
+	 * \brief Converts an image to the format of the stream and writes it as the next frame.
+	 *
+	 * \param[out] video 	the open stream.
+	 * \param[in] image 	the frame, the same size as the stream.
+	 *
+	 * \return 				1 if sucessfull, 0 if the frame could not be written.
+	 */
+
+	size_t count = (size_t)video->width*video->height;
+	unsigned char *y_plane = video->buffer;
+	unsigned char *u_plane = video->buffer + count;
+	unsigned char *v_plane = video->buffer + 2*count;
+	int r = 0;
+	int g = 0;
+	int b = 0;
+	size_t i = 0;
+
+	for (i = 0; i < count; i++){
+		r = (image->pixels[i] >> 16) & 0xff;
+		g = (image->pixels[i] >> 8) & 0xff;
+		b = image->pixels[i] & 0xff;
+
+		if (video->format == VIDEO_Y4M){
+			//each plane is written whole, one after another
+			y_plane[i] = ((66*r + 129*g + 25*b + 128) >> 8) + 16;
+			u_plane[i] = ((-38*r - 74*g + 112*b + 128) >> 8) + 128;
+			v_plane[i] = ((112*r - 94*g - 18*b + 128) >> 8) + 128;
+		}
+		else {
+			video->buffer[3*i] = r;
+			video->buffer[3*i+1] = g;
+			video->buffer[3*i+2] = b;
+		}
+	}
+
+	if (video->format == VIDEO_Y4M && fputs("FRAME\n", video->file) == EOF)
+		return 0;
+	if (fwrite(video->buffer, 1, 3*count, video->file) != 3*count)
+		return 0;
+
+	video->frames++;
+	return 1;
+}
+
+int closeVideo(video_stream *video){
+	/**
+	 * \brief Finishes a video stream and closes its file.
+	 *
+	 * stdout is flushed rather than closed.
+	 *
+	 * \param[out] video 	the stream to be closed.
+	 *
+	 * \return 				1 if everything was written, 0 if not.
+	 */
+
+	int closed = 1;
+
+	if (video->file == stdout)
+		closed = fflush(stdout) == 0;
+	else if (video->file != NULL)
+		closed = fclose(video->file) == 0;
+
+	free(video->buffer);
+	structInitVideoStream(video);
+	return closed;
+}
+
+int findVideoFormat(char *name){
+	/**
+	 * \brief Returns the video format named by a setting value, or 0 if there is none.
+	 *
+	 * \param[in] name 		"y4m" or "rgb".
+	 */
+
+	if (strcmp(name, "y4m") == 0)
+		return VIDEO_Y4M;
+	if (strcmp(name, "rgb") == 0)
+		return VIDEO_RGB;
+
+	return 0;
+}
+
+char *videoExtension(int format){
+	/**
+	 * \brief Returns the file extension used for a video format.
+	 *
+	 * \param[in] format 	VIDEO_Y4M or VIDEO_RGB.
+	 */
+
+	return format == VIDEO_Y4M ? "y4m" : "rgb";
+}
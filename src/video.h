@@ -0,0 +1,35 @@
+#ifndef _VIDEO_H_
+#define _VIDEO_H_
+
+/** \brief Uncompressed YUV4MPEG2 video with full resolution colour (4:4:4).*/
+#define VIDEO_Y4M 1
+/** \brief Raw 8 bit RGB frames one after another, with no header.*/
+#define VIDEO_RGB 2
+
+
+/*
+ * Opens a video stream, using stdout if the file name is "-".
+ */
+int openVideo(video_stream *video, char *name, int format, int width, int height, int fps);
+
+/*
+ * Converts an image to the format of the stream and writes it as the next frame.
+ */
+int writeVideoFrame(video_stream *video, raster_image *image);
+
+/*
+ * Finishes a video stream and closes its file.
+ */
+int closeVideo(video_stream *video);
+
+/*
+ * Returns the video format named by a setting value, or 0 if there is none.
+ */
+int findVideoFormat(char *name);
+
+/*
+ * Returns the file extension used for a video format.
+ */
+char *videoExtension(int format);
+
+#endif
@@ -0,0 +1,401 @@
+/**
+ * \file worker.c
+ *
+ * \brief A source file for the worker thread that makes L-System strings and line lists
+ * in the background.
+ *
+ * When the depth, line length or position changes, the drawing screen hands a copy of
+ * the lsystem to the worker thread and carries on drawing the last finished fractal.
+ * The worker thread runs makeString() and stringToTurtle() on its copy and publishes
+ * the result through an atomic pointer swap, which the drawing screen collects on its
+ * next frame. Line lists are made with a line length of 1 from (0, 0), and are put in
+ * the geometry cache in that form when collected as well as being placed for drawing.
+ * Every request is numbered, and a newer request cancels the running job and causes
+ * any result made for an older request to be thrown away. Large line lists are also
+ * written to the geometry store before they are published, so that they can be mapped
+ * in the next time the program is run instead of being made again.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "structs.h"
+#include "lsys.h"
+#include "turtle.h"
+#include "cache.h"
+#include "store.h"
+#include "timing.h"
+#include "worker.h"
+
+
+/*
+ * Main loop of the worker thread.
+ */
+static int workerThread(void *data);
+
+/*
+ * Marks the worker as no longer busy if no job has been submitted since the one that finished.
+ */
+static void finishJob(gen_worker *worker, int generation);
+
+/*
+ * Frees a result that will not be used.
+ */
+static void freeResult(gen_result *result);
+
+
+int startWorker(gen_worker *worker){
+	/**
+	 * \brief Creates the lock and condition for the worker and starts its thread.
+	 *
+	 * \param[out] worker 	a worker initialised with structInitGenWorker().
+	 *
+	 * \return 				1 if sucessfull, 0 if the thread could not be started.
+	 */
+
+	worker->lock = SDL_CreateMutex();
+	worker->wake = SDL_CreateCond();
+	if (worker->lock == NULL || worker->wake == NULL){
+		printf("Could not create worker lock: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	worker->thread = SDL_CreateThread(workerThread, "worker", worker);
+	if (worker->thread == NULL){
+		printf("Could not start worker thread: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	return 1;
+}
+
+void stopWorker(gen_worker *worker){
+	/**
+	 * \brief Cancels any job, waits for the worker thread to exit and frees anything it was holding.
+	 *
+	 * \param[out] worker 	the worker to be stopped.
+	 */
+
+	if (worker->thread != NULL){
+		SDL_LockMutex(worker->lock);
+		worker->quit = 1;
+		SDL_AtomicSet(&(worker->cancel), 1);
+		SDL_CondSignal(worker->wake);
+		SDL_UnlockMutex(worker->lock);
+		SDL_WaitThread(worker->thread, NULL);
+		worker->thread = NULL;
+	}
+
+	//freeing a job that never started and a result that was never collected
+	if (worker->job_pending){
+		free(worker->job.string);
+		worker->job_pending = 0;
+	}
+	freeResult((gen_result*)SDL_AtomicSetPtr(&(worker->result), NULL));
+
+	SDL_DestroyCond(worker->wake);
+	SDL_DestroyMutex(worker->lock);
+	worker->wake = NULL;
+	worker->lock = NULL;
+}
+
+void submitJob(gen_worker *worker, lsystem *lsys){
+	/**
+	 * \brief Hands a copy of the lsystem to the worker thread to remake the string and/or line list.
+	 *
+	 * The remake flags of the lsystem decide what is remade. If only the line list is needed, the
+	 * job is given its own copy of the string so the drawing screen is free to replace its string
+	 * at any time. If a string is still being remade for an earlier request, this job remakes the
+	 * string too, as the string held by the lsystem is out of date. Any job that has not finished
+	 * is cancelled.
+	 *
+	 * \param[out] worker 	the worker to hand the job to.
+	 * \param[in] lsys 		the lsystem to be remade.
+	 */
+
+	int remake_string = lsys->remake_string_flag || worker->string_outstanding || lsys->string == NULL;
+
+	SDL_LockMutex(worker->lock);
+
+	//replacing a job that has not been started yet
+	if (worker->job_pending)
+		free(worker->job.string);
+
+	worker->job = *lsys;
+	worker->job.line_list = NULL;
+	worker->job.line_list_length = 0;
+	worker->job.remake_string_flag = remake_string;
+	worker->job.string = NULL;
+	if (!remake_string){
+		worker->job.string = (char*)malloc(strlen(lsys->string)+1);
+		if (worker->job.string == NULL){
+			printf("memory allocation for worker string failed\n");
+			worker->job.remake_string_flag = remake_string = 1;
+		}
+		else
+			strcpy(worker->job.string, lsys->string);
+	}
+
+	worker->string_outstanding = remake_string;
+	worker->job_pending = 1;
+	SDL_AtomicAdd(&(worker->generation), 1);
+	SDL_AtomicSet(&(worker->cancel), 1);
+	SDL_AtomicSet(&(worker->progress), 0);
+	SDL_AtomicSet(&(worker->busy), 1);
+
+	SDL_CondSignal(worker->wake);
+	SDL_UnlockMutex(worker->lock);
+}
+
+void cancelJobs(gen_worker *worker){
+	/**
+	 * \brief Cancels any job so that its result is never used.
+	 *
+	 * Used when the drawing screen is left, as the string and line list are thrown away.
+	 *
+	 * \param[out] worker 	the worker to be cancelled.
+	 */
+
+	SDL_LockMutex(worker->lock);
+	if (worker->job_pending){
+		free(worker->job.string);
+		worker->job.string = NULL;
+		worker->job_pending = 0;
+	}
+	SDL_AtomicAdd(&(worker->generation), 1);
+	SDL_AtomicSet(&(worker->cancel), 1);
+	SDL_AtomicSet(&(worker->busy), 0);
+	SDL_UnlockMutex(worker->lock);
+
+	worker->string_outstanding = 0;
+	freeResult((gen_result*)SDL_AtomicSetPtr(&(worker->result), NULL));
+}
+
+int collectResult(gen_worker *worker, geom_cache *cache, lsystem *lsys){
+	/**
+	 * \brief Swaps a finished string and line list into the lsystem, freeing the ones they replace.
+	 *
+	 * The result is taken with an atomic swap so the worker thread never has to wait for the
+	 * drawing screen. Results made for a request that has since been replaced are freed unused.
+	 * The line list is placed at the line length and start point of the lsystem, and the string
+	 * and unplaced line list are offered to the cache so that coming back to this lsystem later
+	 * does not remake it.
+	 *
+	 * \param[in] worker 	the worker to collect from.
+	 * \param[out] cache 	the geometry cache.
+	 * \param[out] lsys 	the lsystem being drawn.
+	 *
+	 * \return 				1 if a new line list was swapped in, 0 if not.
+	 */
+
+	char *cached_string = NULL;
+
+	gen_result *result = (gen_result*)SDL_AtomicSetPtr(&(worker->result), NULL);
+
+	if (result == NULL)
+		return 0;
+
+	if (result->generation != SDL_AtomicGet(&(worker->generation))){
+		freeResult(result);
+		return 0;
+	}
+
+	//keeping how long it took to make for the timings in the info overlay
+	worker->rewrite_time = result->rewrite_time;
+	worker->turtle_time = result->turtle_time;
+
+	//swapping in the new string if one was made
+	if (result->string != NULL){
+		free(lsys->string);
+		lsys->string = result->string;
+		worker->string_outstanding = 0;
+	}
+
+	//placing the new line list
+	if (!placeLines(lsys, result->line_list, result->line_list_length)){
+		free(result->line_list);
+		free(result);
+		return 0;
+	}
+
+	//offering a copy of the string and the unplaced line list to the cache
+	cached_string = (char*)malloc(strlen(lsys->string)+1);
+	if (cached_string != NULL)
+		strcpy(cached_string, lsys->string);
+	if (cached_string == NULL || !cacheInsert(cache, lsys, cached_string, result->line_list, result->line_list_length)){
+		free(cached_string);
+		free(result->line_list);
+	}
+
+	free(result);
+	return 1;
+}
+
+int workerBusy(gen_worker *worker){
+	/**
+	 * \brief Returns true while a job is waiting or running.
+	 *
+	 * \param[in] worker 	the worker being checked.
+	 */
+
+	return SDL_AtomicGet(&(worker->busy));
+}
+
+int workerProgress(gen_worker *worker){
+	/**
+	 * \brief Returns the percentage progress of the running job.
+	 *
+	 * \param[in] worker 	the worker being checked.
+	 */
+
+	return SDL_AtomicGet(&(worker->progress));
+}
+
+static int workerThread(void *data){
+	/**
+	 * \brief Waits for jobs and makes the string and line list for each one.
+	 *
+	 * The job is copied out under the lock and the cancel flag cleared, so that a job submitted
+	 * while this one runs will set the flag again and stop it. When the job is finished, the
+	 * result is published with an atomic swap (freeing any result that was never collected) and
+	 * an event is pushed to wake up the main loop so the new fractal is drawn. Large geometry is
+	 * only written to the geometry store after that, from a copy kept back before publishing, so
+	 * the new fractal is shown without waiting for the write.
+	 *
+	 * \param[in] data 		the gen_worker that owns the thread.
+	 *
+	 * \return 				0 when the worker is stopped.
+	 */
+
+	gen_worker *worker = (gen_worker*)data;
+	gen_result *result = NULL;
+	lsystem job;
+	char *store_string = NULL;
+	line *store_lines = NULL;
+	int generation = 0;
+	double rewrite_time = -1;
+	double turtle_time = 0;
+	Uint64 start_time = 0;
+	SDL_Event wake_event;
+
+	while (1){
+		//waiting for a job
+		SDL_LockMutex(worker->lock);
+		while (!worker->job_pending && !worker->quit)
+			SDL_CondWait(worker->wake, worker->lock);
+
+		if (worker->quit){
+			SDL_UnlockMutex(worker->lock);
+			break;
+		}
+
+		job = worker->job;
+		generation = SDL_AtomicGet(&(worker->generation));
+		worker->job_pending = 0;
+		worker->job.string = NULL;
+		SDL_AtomicSet(&(worker->cancel), 0);
+		SDL_UnlockMutex(worker->lock);
+
+		//making the string and a line list of unit length from (0, 0), checking for cancellation as it goes
+		job.cancel_flag = &(worker->cancel);
+		job.progress = &(worker->progress);
+		job.length = 1;
+		structInitCoord(&(job.start));
+
+		start_time = SDL_GetPerformanceCounter();
+		if (job.remake_string_flag && !makeString(&job)){
+			free(job.string);
+			finishJob(worker, generation);
+			continue;
+		}
+		rewrite_time = job.remake_string_flag ? millisecondsSince(start_time) : -1;
+
+		start_time = SDL_GetPerformanceCounter();
+		job.line_list_length = stringToTurtle(&job);
+		turtle_time = millisecondsSince(start_time);
+
+		result = (gen_result*)malloc(sizeof(gen_result));
+		if (jobCancelled(&job) || job.line_list == NULL || result == NULL){
+			free(job.string);
+			free(job.line_list);
+			free(result);
+			finishJob(worker, generation);
+			continue;
+		}
+
+		//keeping back a copy of large geometry to store once the result has been handed over,
+		//a string that was copied rather than remade is not handed over so is kept as it is
+		store_string = job.remake_string_flag ? NULL : job.string;
+		store_lines = NULL;
+		if (job.line_list_length >= STORE_MIN_LINES){
+			if (store_string == NULL){
+				store_string = (char*)malloc(strlen(job.string)+1);
+				if (store_string != NULL)
+					strcpy(store_string, job.string);
+			}
+			store_lines = (line*)malloc(job.line_list_length*sizeof(line));
+			if (store_lines != NULL)
+				memcpy(store_lines, job.line_list, job.line_list_length*sizeof(line));
+		}
+
+		//the string is only handed over if it was remade
+		result->string = job.remake_string_flag ? job.string : NULL;
+		result->line_list = job.line_list;
+		result->line_list_length = job.line_list_length;
+		result->generation = generation;
+		result->rewrite_time = rewrite_time;
+		result->turtle_time = turtle_time;
+
+		//publishing the result and waking up the main loop
+		freeResult((gen_result*)SDL_AtomicSetPtr(&(worker->result), result));
+		finishJob(worker, generation);
+
+		memset(&wake_event, 0, sizeof(wake_event));
+		wake_event.type = SDL_USEREVENT;
+		SDL_PushEvent(&wake_event);
+
+		//keeping large geometry on disk for later runs, now that it is on screen
+		if (store_string != NULL && store_lines != NULL)
+			storeGeometry(&job, store_string, store_lines, job.line_list_length);
+		free(store_string);
+		free(store_lines);
+	}
+
+	return 0;
+}
+
+static void finishJob(gen_worker *worker, int generation){
+	/**
+	 * \brief Marks the worker as no longer busy if no job has been submitted since the one that finished.
+	 *
+	 * The generation is compared and busy cleared under the lock, as submitJob() moves the
+	 * generation on and sets busy under it too, so a job submitted between the two is never
+	 * marked as finished.
+	 *
+	 * \param[out] worker 		the worker.
+	 * \param[in] generation 	generation of the job that finished.
+	 */
+
+	SDL_LockMutex(worker->lock);
+	if (generation == SDL_AtomicGet(&(worker->generation)))
+		SDL_AtomicSet(&(worker->busy), 0);
+	SDL_UnlockMutex(worker->lock);
+}
+
+static void freeResult(gen_result *result){
+	/**
+	 * \brief Frees a result and the string and line list it holds.
+	 *
+	 * \param[out] result 	the result to be freed (may be NULL).
+	 */
+
+	if (result == NULL)
+		return;
+
+	free(result->string);
+	free(result->line_list);
+	free(result);
+}
@@ -0,0 +1,39 @@
+#ifndef _WORKER_H_
+#define _WORKER_H_
+
+/*
+ * Starts the worker thread.
+ */
+int startWorker(gen_worker *worker);
+
+/*
+ * Cancels any job, stops the worker thread and frees anything it was holding.
+ */
+void stopWorker(gen_worker *worker);
+
+/*
+ * Hands the flagged parts of the lsystem to the worker thread to be remade, cancelling any older job.
+ */
+void submitJob(gen_worker *worker, lsystem *lsys);
+
+/*
+ * Cancels any job so that its result is never used.
+ */
+void cancelJobs(gen_worker *worker);
+
+/*
+ * Swaps a finished string and line list into the lsystem and offers them to the cache.
+ */
+int collectResult(gen_worker *worker, geom_cache *cache, lsystem *lsys);
+
+/*
+ * Returns true while a job is waiting or running.
+ */
+int workerBusy(gen_worker *worker);
+
+/*
+ * Returns the percentage progress of the running job.
+ */
+int workerProgress(gen_worker *worker);
+
+#endif